@@ -30,20 +30,58 @@
 
 #include "cmsis_device.h"
 
+#include <stddef.h>
+#include <stdbool.h>
+
 // ----------------------------------------------------------------------------
 
 #define TIMER_FREQUENCY_HZ (1000u)
 
 typedef uint32_t timer_ticks_t;
 
-extern volatile timer_ticks_t timer_delayCount;
+typedef void
+(*timer_callback_t) (void* arg);
+
+// A software timer, one-shot or periodic. The callback is invoked
+// from the SysTick interrupt handler, so it must be short.
+typedef struct timer_event_s
+{
+  struct timer_event_s* next;
+  struct timer_event_s** pprev; // NULL when not armed
+  timer_ticks_t expires;
+  timer_ticks_t period;
+  timer_callback_t callback;
+  void* arg;
+} timer_event_t;
 
 extern void
 timer_start (void);
 
+// Sleep (WFI) until the given number of ticks pass.
 extern void
 timer_sleep (timer_ticks_t ticks);
 
+extern timer_ticks_t
+timer_now (void);
+
+extern void
+timer_event_init (timer_event_t* event, timer_callback_t callback, void* arg);
+
+// Expire after delay ticks (at least 1) and then, if period is
+// not zero, every period ticks; an armed event is re-armed.
+extern void
+timer_event_arm (timer_event_t* event, timer_ticks_t delay,
+                 timer_ticks_t period);
+
+extern void
+timer_event_cancel (timer_event_t* event);
+
+static inline bool
+timer_event_is_armed (const timer_event_t* event)
+{
+  return event->pprev != NULL;
+}
+
 // ----------------------------------------------------------------------------
 
 #endif // TIMER_H_
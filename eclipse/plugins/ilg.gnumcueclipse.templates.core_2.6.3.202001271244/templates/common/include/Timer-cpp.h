@@ -29,6 +29,7 @@
 #define TIMER_H_
 
 #include "cmsis_device.h"
+#include "cortexm/Clock.h"
 
 // ----------------------------------------------------------------------------
 
@@ -38,10 +39,47 @@ public:
   typedef uint32_t ticks_t;
   static constexpr ticks_t FREQUENCY_HZ = 1000u;
 
-private:
-  static volatile ticks_t ms_delayCount;
+  typedef void
+  (*callback_t) (void* arg);
+
+  // A software timer, one-shot or periodic. The callback is invoked
+  // from the SysTick interrupt handler, so it must be short.
+  class Event
+  {
+  public:
+    Event (callback_t callback, void* arg = nullptr);
+
+    Event (const Event&) = delete;
+    Event&
+    operator= (const Event&) = delete;
+
+    ~Event ();
+
+    // Expire after delay ticks (at least 1) and then, if period is
+    // not zero, every period ticks; an armed event is re-armed.
+    void
+    arm (ticks_t delay, ticks_t period = 0);
+
+    void
+    cancel (void);
+
+    inline bool
+    isArmed (void) const
+    {
+      return fPrev != nullptr;
+    }
+
+  private:
+    friend class Timer;
+
+    Event* fNext;
+    Event** fPrev; // nullptr when not armed
+    ticks_t fExpires;
+    ticks_t fPeriod;
+    callback_t fCallback;
+    void* fArg;
+  };
 
-public:
   // Default constructor
   Timer() = default;
 
@@ -50,20 +88,47 @@ public:
   {
     // Use SysTick as reference for the delay loops.
     SysTick_Config(SystemCoreClock / FREQUENCY_HZ);
+
+    // The high resolution clock, see cortexm/Clock.h.
+    clock_initialize();
   }
 
+  // Sleep (WFI) until the given number of ticks pass.
   static void
   sleep(ticks_t ticks);
 
-  inline static void
-  tick(void)
+  inline static ticks_t
+  now(void)
   {
-    // Decrement to zero the counter used by the delay routine.
-    if (ms_delayCount != 0u)
-      {
-        --ms_delayCount;
-      }
+    return ms_ticks;
   }
+
+  static void
+  tick(void);
+
+private:
+  // The armed events are kept in a hierarchical timing wheel;
+  // see Timer.cpp for details.
+  static constexpr unsigned int WHEEL_LEVELS = 4;
+  static constexpr unsigned int WHEEL_SLOT_BITS = 5;
+  static constexpr unsigned int WHEEL_SLOTS = 1u << WHEEL_SLOT_BITS;
+
+  static void
+  insert(Event* event);
+
+  static void
+  remove(Event* event);
+
+#if defined(OS_USE_TIMER_TICKLESS)
+  static ticks_t
+  idleTicks(ticks_t max);
+
+  static void
+  sleepTickless(void);
+#endif
+
+  static volatile ticks_t ms_ticks;
+  static Event* ms_wheel[WHEEL_LEVELS][WHEEL_SLOTS];
 };
 
 // ----------------------------------------------------------------------------
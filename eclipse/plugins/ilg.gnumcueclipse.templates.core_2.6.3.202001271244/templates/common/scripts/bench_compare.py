@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# This file is part of the µOS++ distribution.
+#   (https://github.com/micro-os-plus)
+# Copyright (c) 2014 Liviu Ionescu.
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom
+# the Software is furnished to do so, subject to the following
+# conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+# OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+
+
+"""
+Compare the bench_run_all() results with a baseline.
+
+Both files are trace outputs (or any text) with lines like:
+  bench,<name>,<repetitions>,<min>,<median>,<max>
+the other lines are ignored. The medians are compared, and the
+exit code is 1 if any benchmark is slower than the baseline by more
+than the threshold (10% by default), or is missing.
+
+Usage:
+  bench_compare.py baseline.txt current.txt [--threshold 10]
+
+Only the standard library is used.
+"""
+
+import argparse
+import sys
+
+
+def read_results(path):
+    """Return a dictionary name -> (min, median, max)."""
+    results = {}
+    with open(path, 'r', errors='replace') as f:
+        for line in f:
+            fields = line.strip().split(',')
+            if len(fields) != 6 or fields[0] != 'bench':
+                continue
+            results[fields[1]] = tuple(int(v) for v in fields[3:6])
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument('baseline')
+    parser.add_argument('current')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='allowed slowdown, in percents')
+    args = parser.parse_args()
+
+    baseline = read_results(args.baseline)
+    current = read_results(args.current)
+
+    failed = 0
+    for name in sorted(baseline):
+        before = baseline[name][1]
+        if name not in current:
+            print('%-32s %10d %10s  missing' % (name, before, '-'))
+            failed += 1
+            continue
+        after = current[name][1]
+        change = 100.0 * (after - before) / before if before else 0.0
+        status = ''
+        if change > args.threshold:
+            status = 'SLOWER'
+            failed += 1
+        print('%-32s %10d %10d %+7.1f%%  %s' % (name, before, after, change,
+                                              status))
+
+    for name in sorted(set(current) - set(baseline)):
+        print('%-32s %10s %10d  new' % (name, '-', current[name][1]))
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+#
+# This file is part of the µOS++ distribution.
+#   (https://github.com/micro-os-plus)
+# Copyright (c) 2014 Liviu Ionescu.
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom
+# the Software is furnished to do so, subject to the following
+# conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+# OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+
+"""
+Decode the trace_log() packets from a raw SWO/ITM capture.
+
+The format strings are read from the .trace_fmt section of the ELF
+file; the text channel (stimulus port 0 by default) is printed as is,
+and the packets on the events port (1 by default) are formatted.
+The packets with a timestamp (OS_USE_TRACE_LOG_TIMESTAMPS) are
+prefixed with the time in seconds, like "[   12.345678901] ".
+
+Usage:
+  trace_log_decode.py app.elf swo.bin [--text-port 0] [--events-port 1]
+
+Only the standard library is used; the ITM parser is tested with:
+  python3 -m doctest trace_log_decode.py
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+
+def read_trace_formats(elf_path):
+    """Return the content of the .trace_fmt section of an ELF32 file."""
+    with open(elf_path, 'rb') as f:
+        elf = f.read()
+
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        raise ValueError('%s: not an ELF32 file' % elf_path)
+    endian = '<' if elf[5] == 1 else '>'
+
+    (e_shoff,) = struct.unpack_from(endian + 'I', elf, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from(
+        endian + 'HHH', elf, 0x2E)
+
+    def section(i):
+        # name, type, flags, addr, offset, size
+        return struct.unpack_from(endian + 'IIIIII', elf,
+                                  e_shoff + i * e_shentsize)
+
+    strtab = section(e_shstrndx)
+    for i in range(e_shnum):
+        sh = section(i)
+        name_start = strtab[4] + sh[0]
+        name = elf[name_start:elf.index(b'\0', name_start)]
+        if name == b'.trace_fmt':
+            return elf[sh[4]:sh[4] + sh[5]]
+
+    raise ValueError('%s: no .trace_fmt section' % elf_path)
+
+
+def itm_packets(data):
+    """Yield (port, payload) for each ITM software source packet.
+
+    A synchronisation packet (at least five zero bytes and 0x80)
+    has no payload:
+
+    >>> list(itm_packets(bytes([0, 0, 0, 0, 0, 0x80,
+    ...                         0x0B, 1, 2, 3, 4, 0x0B, 5, 6, 7, 8])))
+    [(1, b'\\x01\\x02\\x03\\x04'), (1, b'\\x05\\x06\\x07\\x08')]
+    >>> list(itm_packets(bytes([0x01, 0x41, 0, 0, 0, 0, 0, 0, 0x80,
+    ...                         0x02, 0x42, 0x43])))
+    [(0, b'A'), (0, b'BC')]
+    """
+    i = 0
+    n = len(data)
+    zeros = 0
+    while i < n:
+        header = data[i]
+        i += 1
+        if header == 0:
+            zeros += 1
+            continue
+        if header == 0x80 and zeros >= 5:
+            # End of a synchronisation packet.
+            zeros = 0
+            continue
+        zeros = 0
+        size = header & 0x03
+        if size == 0:
+            # Overflow, timestamp or extension packet;
+            # skip the continuation bytes, if any.
+            if header & 0x80:
+                while i < n and data[i] & 0x80:
+                    i += 1
+                i += 1
+            continue
+
+        length = 4 if size == 3 else size
+        payload = data[i:i + length]
+        i += length
+        if header & 0x04:
+            continue  # hardware source (DWT)
+        yield header >> 3, payload
+
+
+_printf_spec = re.compile(
+    r'%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|l|z|j|t)?([diuxXcpo%])')
+
+
+def format_message(fmt, args):
+    """Apply a C printf format to a list of 32-bit words."""
+    args = list(args)
+
+    def convert(m):
+        flags, width, precision, conv = m.groups()
+        if conv == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        if conv in 'di':
+            value = value - (1 << 32) if value & 0x80000000 else value
+            conv = 'd'
+        elif conv == 'u':
+            conv = 'd'
+        elif conv == 'c':
+            value = chr(value & 0xFF)
+        elif conv == 'p':
+            return '0x%08x' % value
+        spec = '%' + flags + width
+        if precision:
+            spec += '.' + precision
+        return (spec + conv) % value
+
+    return _printf_spec.sub(convert, fmt)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument('elf')
+    parser.add_argument('swo')
+    parser.add_argument('--text-port', type=int, default=0)
+    parser.add_argument('--events-port', type=int, default=1)
+    args = parser.parse_args()
+
+    formats = read_trace_formats(args.elf)
+    with open(args.swo, 'rb') as f:
+        swo = f.read()
+
+    out = sys.stdout
+    events = bytearray()
+    for port, payload in itm_packets(swo):
+        if port == args.text_port:
+            out.write(payload.decode('utf-8', 'replace'))
+        elif port == args.events_port:
+            events += payload
+            # Decode all the complete packets collected so far.
+            while len(events) >= 4:
+                (header,) = struct.unpack_from('<I', events, 0)
+                nargs = header >> 24
+                nheader = 3 if header & 0x00800000 else 1
+                if len(events) < 4 * (nheader + nargs):
+                    break
+                offset = header & 0x007FFFFF
+                if nheader == 3:
+                    (ns,) = struct.unpack_from('<Q', events, 4)
+                    out.write('[%4d.%09d] ' % divmod(ns, 1000000000))
+                values = struct.unpack_from('<%dI' % nargs, events,
+                                            4 * nheader)
+                del events[:4 * (nheader + nargs)]
+                end = formats.find(b'\0', offset)
+                fmt = formats[offset:end].decode('utf-8', 'replace')
+                out.write(format_message(fmt, values))
+
+
+if __name__ == '__main__':
+    main()
@@ -27,6 +27,17 @@
 
 #include "Timer.h"
 #include "cortexm/ExceptionHandlers.h"
+#include "cortexm/Clock.h"
+
+#if defined(OS_USE_STACK_USAGE)
+#include "cortexm/StackUsage.h"
+#endif
+
+#if defined(OS_USE_FAST_ISRS)
+#include "cortexm/FastCode.h"
+#else
+#define OS_FAST_ISR
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -41,7 +52,242 @@ timer_tick (void);
 
 // ----------------------------------------------------------------------------
 
-volatile timer_ticks_t timer_delayCount;
+// The armed events are kept in a hierarchical timing wheel: level 0
+// has one slot per tick, each slot of level n covers a full turn of
+// level n-1. Arming and cancelling are O(1); once per turn of a level,
+// the events in the next slot of the level above are moved down
+// (cascaded). Events further in the future than the whole wheel
+// (2^20 ticks with the defaults) are parked in the top level and
+// cascaded until they fit.
+
+#if !defined(TIMER_WHEEL_LEVELS)
+#define TIMER_WHEEL_LEVELS (4u)
+#endif
+
+#if !defined(TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_BITS (5u)
+#endif
+
+#if (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS) >= 32
+#error "The timer wheel must cover less than 2^32 ticks"
+#endif
+
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1u)
+#define TIMER_WHEEL_SPAN(level) \
+  ((timer_ticks_t) 1 << (TIMER_WHEEL_SLOT_BITS * (level)))
+
+static timer_event_t* timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+static volatile timer_ticks_t timer_ticks;
+
+// ----------------------------------------------------------------------------
+
+// Must be called with the interrupts disabled.
+static void
+timer_wheel_insert (timer_event_t* event)
+{
+  timer_ticks_t expires = event->expires;
+  timer_ticks_t delta = expires - timer_ticks;
+
+  unsigned int level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1
+      && delta >= TIMER_WHEEL_SPAN(level + 1))
+    {
+      ++level;
+    }
+  if (delta >= TIMER_WHEEL_SPAN(TIMER_WHEEL_LEVELS))
+    {
+      // Too far, park it in the last slot it can reach.
+      expires = timer_ticks + TIMER_WHEEL_SPAN(TIMER_WHEEL_LEVELS) - 1;
+    }
+
+  timer_event_t** head = &timer_wheel[level][(expires
+      >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_MASK];
+
+  event->next = *head;
+  if (event->next != NULL)
+    {
+      event->next->pprev = &event->next;
+    }
+  event->pprev = head;
+  *head = event;
+}
+
+// Must be called with the interrupts disabled.
+static void
+timer_wheel_remove (timer_event_t* event)
+{
+  *event->pprev = event->next;
+  if (event->next != NULL)
+    {
+      event->next->pprev = event->pprev;
+    }
+  event->pprev = NULL;
+}
+
+#if defined(OS_USE_TIMER_TICKLESS)
+
+// With OS_USE_TIMER_TICKLESS defined, timer_sleep() does not wake up
+// every tick: the SysTick is reprogrammed to interrupt at the next
+// deadline (an expiry or a cascade of a non empty slot), at most
+// 2^24 cycles away, and on wakeup the skipped ticks are accounted,
+// for timer_now(), HAL_GetTick() and the clock. The few cycles
+// the SysTick is stopped while being reprogrammed are measured with
+// the DWT cycle counter, when running (cortexm/Clock.h), and
+// subtracted from the current tick; otherwise they are lost.
+
+// The core cycles, to measure how long the SysTick (clocked by the
+// core, as set by SysTick_Config()) is stopped; zero if the DWT
+// cycle counter is not available or not enabled.
+static inline uint32_t
+__attribute__((always_inline))
+timer_tickless_cycles (void)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  return DWT->CYCCNT;
+#else
+  return 0;
+#endif
+}
+
+// The number of ticks until the wheel needs processing, up to max.
+// Must be called with the interrupts disabled.
+static timer_ticks_t
+timer_wheel_idle_ticks (timer_ticks_t max)
+{
+  timer_ticks_t now = timer_ticks;
+  timer_ticks_t ticks = max;
+
+  for (timer_ticks_t delta = 1; delta < TIMER_WHEEL_SLOTS && delta < ticks;
+      ++delta)
+    {
+      if (timer_wheel[0][(now + delta) & TIMER_WHEEL_MASK] != NULL)
+        {
+          ticks = delta;
+          break;
+        }
+    }
+
+  for (unsigned int level = 1; level < TIMER_WHEEL_LEVELS; ++level)
+    {
+      timer_ticks_t span = TIMER_WHEEL_SPAN(level);
+      timer_ticks_t index = now >> (TIMER_WHEEL_SLOT_BITS * level);
+      for (timer_ticks_t k = 1; k <= TIMER_WHEEL_SLOTS; ++k)
+        {
+          timer_ticks_t delta = (now & ~(span - 1u)) + k * span - now;
+          if (delta >= ticks)
+            {
+              break;
+            }
+          if (timer_wheel[level][(index + k) & TIMER_WHEEL_MASK] != NULL)
+            {
+              ticks = delta;
+              break;
+            }
+        }
+    }
+
+  return ticks;
+}
+
+// Must be called with the interrupts disabled; the interrupt that
+// caused the wakeup is taken after the interrupts are enabled.
+static void
+timer_sleep_tickless (void)
+{
+  uint32_t reload = SysTick->LOAD + 1u;
+  timer_ticks_t ticks = timer_wheel_idle_ticks (
+      SysTick_LOAD_RELOAD_Msk / reload);
+  if (ticks < 2u)
+    {
+      __WFI ();
+      return;
+    }
+
+  SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+  uint32_t val = SysTick->VAL;
+  uint32_t stopped = timer_tickless_cycles ();
+  if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0u)
+    {
+      // A tick is already pending, process it first.
+      SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+      __WFI ();
+      return;
+    }
+  if (val == 0u)
+    {
+      // Just (re)started, a full tick to go.
+      val = reload;
+    }
+
+  // Keep the phase of the tick: the first tick was already
+  // partly counted, and the counter was stopped for a few cycles.
+  uint32_t lost = timer_tickless_cycles () - stopped;
+  val = (val > lost + 1u) ? val - lost : 1u;
+  uint32_t load = val + reload * (ticks - 1u);
+  SysTick->LOAD = load;
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+  __WFI ();
+
+  uint32_t ctrl = SysTick->CTRL;
+  SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+  val = SysTick->VAL;
+  stopped = timer_tickless_cycles ();
+
+  timer_ticks_t elapsed;
+  uint32_t next;
+  if ((ctrl & SysTick_CTRL_COUNTFLAG_Msk) != 0u)
+    {
+      // The deadline was reached; the pending SysTick interrupt
+      // will process the last tick.
+      elapsed = ticks - 1u;
+      next = reload - 1u - (load - val);
+      if ((load - val) >= reload - 2u)
+        {
+          next = reload - 1u;
+        }
+    }
+  else
+    {
+      // Woken up earlier by another interrupt; the tick in progress
+      // is left to the SysTick interrupt, even if it is only a few
+      // cycles away (a reload value of 0 would stop the counter).
+      elapsed = ticks - 1u - val / reload;
+      next = val % reload;
+      next = (next >= 2u) ? next - 1u : 1u;
+    }
+
+  // Restart with the remainder of the current tick, less the cycles
+  // the counter was stopped. The counter loads it on its next clock;
+  // the reload value for the full ticks must be restored right after,
+  // before the catch up below, otherwise a short remainder would be
+  // reloaded several times, and the ticks would drift.
+  lost = timer_tickless_cycles () - stopped;
+  next = (next > lost + 1u) ? next - lost : 1u;
+  SysTick->LOAD = next;
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+  while ((SysTick->VAL == 0u)
+      && ((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) == 0u))
+    {
+      ;
+    }
+  SysTick->LOAD = reload - 1u;
+
+  timer_ticks += elapsed;
+  for (timer_ticks_t i = 0; i < elapsed; ++i)
+    {
+      clock_tick ();
+#if defined(USE_HAL_DRIVER)
+      HAL_IncTick ();
+#endif
+    }
+}
+
+#endif // defined(OS_USE_TIMER_TICKLESS)
 
 // ----------------------------------------------------------------------------
 
@@ -50,33 +296,287 @@ timer_start (void)
 {
   // Use SysTick as reference for the delay loops.
   SysTick_Config (SystemCoreClock / TIMER_FREQUENCY_HZ);
+
+  // The high resolution clock, see cortexm/Clock.h.
+  clock_initialize ();
+}
+
+timer_ticks_t
+timer_now (void)
+{
+  return timer_ticks;
 }
 
 void
-timer_sleep (timer_ticks_t ticks)
+timer_event_init (timer_event_t* event, timer_callback_t callback, void* arg)
+{
+  event->next = NULL;
+  event->pprev = NULL;
+  event->expires = 0;
+  event->period = 0;
+  event->callback = callback;
+  event->arg = arg;
+}
+
+void
+timer_event_arm (timer_event_t* event, timer_ticks_t delay,
+                 timer_ticks_t period)
 {
-  timer_delayCount = ticks;
+  if (delay == 0u)
+    {
+      delay = 1u;
+    }
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
 
-  // Busy wait until the SysTick decrements the counter to zero.
-  while (timer_delayCount != 0u)
-    ;
+  if (event->pprev != NULL)
+    {
+      timer_wheel_remove (event);
+    }
+  event->expires = timer_ticks + delay;
+  event->period = period;
+  timer_wheel_insert (event);
+
+  __set_PRIMASK (primask);
 }
 
 void
+timer_event_cancel (timer_event_t* event)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  if (event->pprev != NULL)
+    {
+      timer_wheel_remove (event);
+    }
+
+  __set_PRIMASK (primask);
+}
+
+static void
+timer_sleep_callback (void* arg)
+{
+  *(volatile bool*) arg = true;
+}
+
+void
+timer_sleep (timer_ticks_t ticks)
+{
+  if (ticks == 0u)
+    {
+      return;
+    }
+
+  volatile bool done = false;
+  timer_event_t event;
+  timer_event_init (&event, timer_sleep_callback, (void*) &done);
+  timer_event_arm (&event, ticks, 0);
+
+  // Sleep until the event expires. The flag is checked with the
+  // interrupts disabled; WFI still wakes up on a pending interrupt,
+  // which is taken as soon as PRIMASK is restored.
+  uint32_t primask = __get_PRIMASK ();
+  for (;;)
+    {
+      __disable_irq ();
+      if (done)
+        {
+          break;
+        }
+#if defined(OS_USE_TIMER_TICKLESS)
+      timer_sleep_tickless ();
+#else
+      __WFI ();
+#endif
+      __set_PRIMASK (primask);
+    }
+  __set_PRIMASK (primask);
+}
+
+void OS_FAST_ISR
 timer_tick (void)
 {
-  // Decrement to zero the counter used by the delay routine.
-  if (timer_delayCount != 0u)
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  timer_ticks_t now = timer_ticks + 1u;
+  timer_ticks = now;
+
+  // At the end of a turn, move the next slot of the upper level down.
+  for (unsigned int level = 1; level < TIMER_WHEEL_LEVELS; ++level)
+    {
+      if ((now & (TIMER_WHEEL_SPAN(level) - 1u)) != 0u)
+        {
+          break;
+        }
+
+      timer_event_t** head = &timer_wheel[level][(now
+          >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_MASK];
+      timer_event_t* event = *head;
+      *head = NULL;
+      while (event != NULL)
+        {
+          timer_event_t* next = event->next;
+          timer_wheel_insert (event);
+          event = next;
+        }
+    }
+
+  // All events in the current slot expire now. Periodic events are
+  // re-armed before the callback, which may cancel them; the callbacks
+  // run with the interrupts enabled.
+  timer_event_t** head = &timer_wheel[0][now & TIMER_WHEEL_MASK];
+  while (*head != NULL)
     {
-      --timer_delayCount;
+      timer_event_t* event = *head;
+      timer_wheel_remove (event);
+      if (event->period != 0u)
+        {
+          event->expires += event->period;
+          timer_wheel_insert (event);
+        }
+
+      __set_PRIMASK (primask);
+      event->callback (event->arg);
+      __disable_irq ();
     }
+
+  __set_PRIMASK (primask);
 }
 
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include "diag/Bench.h"
+
+// Arm, cancel and expire, with 10, 100 or 1000 other events armed
+// at distant delays, so they only cascade. Each arm run uses a new
+// event, cancelled in the same order by the cancel runs.
+//
+// The events are static, so no allocator time is measured; on parts
+// with little RAM, reduce OS_INTEGER_TIMER_BENCH_EVENTS, and the
+// benchmarks with more events are not registered.
+
+#if !defined(OS_INTEGER_TIMER_BENCH_EVENTS)
+#define OS_INTEGER_TIMER_BENCH_EVENTS (1000u)
+#endif
+
+#define TIMER_BENCH_PROBES (OS_INTEGER_BENCH_WARMUP \
+  + OS_INTEGER_BENCH_REPETITIONS)
+
+static timer_event_t timer_bench_events[OS_INTEGER_TIMER_BENCH_EVENTS];
+static size_t timer_bench_armed;
+static timer_event_t timer_bench_probes[TIMER_BENCH_PROBES];
+static size_t timer_bench_next;
+
+static void
+timer_bench_noop (void* arg __attribute__((unused)))
+{
+}
+
+// Arm the given number of background events; called from the
+// warm up runs, so it is not measured.
+static void
+timer_bench_populate (size_t count)
+{
+  if (count == timer_bench_armed)
+    {
+      return;
+    }
+  for (size_t i = 0; i < OS_INTEGER_TIMER_BENCH_EVENTS; ++i)
+    {
+      if (i < timer_bench_armed)
+        {
+          timer_event_cancel (&timer_bench_events[i]);
+        }
+      timer_event_init (&timer_bench_events[i], timer_bench_noop, NULL);
+      if (i < count)
+        {
+          timer_event_arm (&timer_bench_events[i],
+                           10000u + (timer_ticks_t) ((i * 7919u) % 100000u),
+                           0);
+        }
+    }
+  timer_bench_armed = count;
+}
+
+static void
+timer_bench_arm (void* arg)
+{
+  timer_bench_populate ((size_t) arg);
+  if (timer_bench_next == 0u)
+    {
+      for (size_t i = 0; i < TIMER_BENCH_PROBES; ++i)
+        {
+          timer_event_init (&timer_bench_probes[i], timer_bench_noop, NULL);
+        }
+    }
+  timer_event_arm (&timer_bench_probes[timer_bench_next++], 100u, 0);
+}
+
+static void
+timer_bench_cancel (void* arg __attribute__((unused)))
+{
+  timer_event_cancel (&timer_bench_probes[--timer_bench_next]);
+}
+
+static void
+timer_bench_tick (void* arg)
+{
+  static timer_event_t probe;
+
+  timer_bench_populate ((size_t) arg);
+  if (!timer_event_is_armed (&probe))
+    {
+      // Expires, and is re-armed, on each tick.
+      timer_event_init (&probe, timer_bench_noop, NULL);
+      timer_event_arm (&probe, 1u, 1u);
+    }
+  timer_tick ();
+}
+
+static bench_t timer_benches[] =
+  {
+    { "timer_arm_10", timer_bench_arm, (void*) 10, NULL },
+    { "timer_cancel_10", timer_bench_cancel, (void*) 10, NULL },
+    { "timer_tick_10", timer_bench_tick, (void*) 10, NULL },
+    { "timer_arm_100", timer_bench_arm, (void*) 100, NULL },
+    { "timer_cancel_100", timer_bench_cancel, (void*) 100, NULL },
+    { "timer_tick_100", timer_bench_tick, (void*) 100, NULL },
+    { "timer_arm_1000", timer_bench_arm, (void*) 1000, NULL },
+    { "timer_cancel_1000", timer_bench_cancel, (void*) 1000, NULL },
+    { "timer_tick_1000", timer_bench_tick, (void*) 1000, NULL },
+  };
+
+static void
+__attribute__((constructor))
+timer_bench_register (void)
+{
+  for (size_t i = 0; i < sizeof(timer_benches) / sizeof(timer_benches[0]);
+      ++i)
+    {
+      // The argument is the number of background events.
+      if ((size_t) timer_benches[i].arg <= OS_INTEGER_TIMER_BENCH_EVENTS)
+        {
+          bench_register (&timer_benches[i]);
+        }
+    }
+}
+
+#endif // defined(OS_USE_BENCH)
+
 // ----- SysTick_Handler() ----------------------------------------------------
 
-void
+void OS_FAST_ISR
 SysTick_Handler (void)
 {
+#if defined(OS_USE_STACK_USAGE)
+  stack_usage_tick ();
+#endif
+  clock_tick ();
 #if defined(USE_HAL_DRIVER)
   HAL_IncTick();
 #endif
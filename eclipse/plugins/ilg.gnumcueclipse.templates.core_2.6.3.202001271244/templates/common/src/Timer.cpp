@@ -27,6 +27,17 @@
 
 #include "Timer.h"
 #include "cortexm/ExceptionHandlers.h"
+#include "cortexm/Clock.h"
+
+#if defined(OS_USE_STACK_USAGE)
+#include "cortexm/StackUsage.h"
+#endif
+
+#if defined(OS_USE_FAST_ISRS)
+#include "cortexm/FastCode.h"
+#else
+#define OS_FAST_ISR
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -36,25 +47,508 @@ extern "C" void HAL_IncTick(void);
 
 // ----------------------------------------------------------------------------
 
-volatile Timer::ticks_t Timer::ms_delayCount;
+// The armed events are kept in a hierarchical timing wheel: level 0
+// has one slot per tick, each slot of level n covers a full turn of
+// level n-1. Arming and cancelling are O(1); once per turn of a level,
+// the events in the next slot of the level above are moved down
+// (cascaded). Events further in the future than the whole wheel
+// (2^20 ticks) are parked in the top level and cascaded until they fit.
+
+volatile Timer::ticks_t Timer::ms_ticks;
+Timer::Event* Timer::ms_wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+
+namespace
+{
+  constexpr Timer::ticks_t
+  wheelSpan(unsigned int level, unsigned int bits)
+  {
+    return static_cast<Timer::ticks_t>(1) << (bits * level);
+  }
+}
 
 // ----------------------------------------------------------------------------
 
+Timer::Event::Event (callback_t callback, void* arg) :
+    fNext(nullptr), //
+    fPrev(nullptr), //
+    fExpires(0), //
+    fPeriod(0), //
+    fCallback(callback), //
+    fArg(arg)
+{
+  ;
+}
+
+Timer::Event::~Event ()
+{
+  cancel ();
+}
+
+void
+Timer::Event::arm (ticks_t delay, ticks_t period)
+{
+  if (delay == 0u)
+    {
+      delay = 1u;
+    }
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  if (fPrev != nullptr)
+    {
+      Timer::remove (this);
+    }
+  fExpires = ms_ticks + delay;
+  fPeriod = period;
+  Timer::insert (this);
+
+  __set_PRIMASK (primask);
+}
+
+void
+Timer::Event::cancel (void)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  if (fPrev != nullptr)
+    {
+      Timer::remove (this);
+    }
+
+  __set_PRIMASK (primask);
+}
+
+// ----------------------------------------------------------------------------
+
+// Must be called with the interrupts disabled.
+void
+Timer::insert(Event* event)
+{
+  ticks_t expires = event->fExpires;
+  ticks_t delta = expires - ms_ticks;
+
+  unsigned int level = 0;
+  while (level < WHEEL_LEVELS - 1
+      && delta >= wheelSpan(level + 1, WHEEL_SLOT_BITS))
+    {
+      ++level;
+    }
+  if (delta >= wheelSpan(WHEEL_LEVELS, WHEEL_SLOT_BITS))
+    {
+      // Too far, park it in the last slot it can reach.
+      expires = ms_ticks + wheelSpan(WHEEL_LEVELS, WHEEL_SLOT_BITS) - 1;
+    }
+
+  Event** head = &ms_wheel[level][(expires >> (WHEEL_SLOT_BITS * level))
+      & (WHEEL_SLOTS - 1)];
+
+  event->fNext = *head;
+  if (event->fNext != nullptr)
+    {
+      event->fNext->fPrev = &event->fNext;
+    }
+  event->fPrev = head;
+  *head = event;
+}
+
+// Must be called with the interrupts disabled.
+void
+Timer::remove(Event* event)
+{
+  *event->fPrev = event->fNext;
+  if (event->fNext != nullptr)
+    {
+      event->fNext->fPrev = event->fPrev;
+    }
+  event->fPrev = nullptr;
+}
+
+#if defined(OS_USE_TIMER_TICKLESS)
+
+// With OS_USE_TIMER_TICKLESS defined, Timer::sleep() does not wake up
+// every tick: the SysTick is reprogrammed to interrupt at the next
+// deadline (an expiry or a cascade of a non empty slot), at most
+// 2^24 cycles away, and on wakeup the skipped ticks are accounted,
+// for Timer::now(), HAL_GetTick() and the clock. The few cycles
+// the SysTick is stopped while being reprogrammed are measured with
+// the DWT cycle counter, when running (cortexm/Clock.h), and
+// subtracted from the current tick; otherwise they are lost.
+
+namespace
+{
+  // The core cycles, to measure how long the SysTick (clocked by the
+  // core, as set by SysTick_Config()) is stopped; zero if the DWT
+  // cycle counter is not available or not enabled.
+  inline uint32_t
+  __attribute__((always_inline))
+  ticklessCycles(void)
+  {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    return DWT->CYCCNT;
+#else
+    return 0;
+#endif
+  }
+}
+
+// The number of ticks until the wheel needs processing, up to max.
+// Must be called with the interrupts disabled.
+Timer::ticks_t
+Timer::idleTicks(ticks_t max)
+{
+  ticks_t now = ms_ticks;
+  ticks_t ticks = max;
+
+  for (ticks_t delta = 1; delta < WHEEL_SLOTS && delta < ticks;
+      ++delta)
+    {
+      if (ms_wheel[0][(now + delta) & (WHEEL_SLOTS - 1)] != nullptr)
+        {
+          ticks = delta;
+          break;
+        }
+    }
+
+  for (unsigned int level = 1; level < WHEEL_LEVELS; ++level)
+    {
+      ticks_t span = wheelSpan(level, WHEEL_SLOT_BITS);
+      ticks_t index = now >> (WHEEL_SLOT_BITS * level);
+      for (ticks_t k = 1; k <= WHEEL_SLOTS; ++k)
+        {
+          ticks_t delta = (now & ~(span - 1u)) + k * span - now;
+          if (delta >= ticks)
+            {
+              break;
+            }
+          if (ms_wheel[level][(index + k) & (WHEEL_SLOTS - 1)] != nullptr)
+            {
+              ticks = delta;
+              break;
+            }
+        }
+    }
+
+  return ticks;
+}
+
+// Must be called with the interrupts disabled; the interrupt that
+// caused the wakeup is taken after the interrupts are enabled.
+void
+Timer::sleepTickless(void)
+{
+  uint32_t reload = SysTick->LOAD + 1u;
+  ticks_t ticks = idleTicks (
+      SysTick_LOAD_RELOAD_Msk / reload);
+  if (ticks < 2u)
+    {
+      __WFI ();
+      return;
+    }
+
+  SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+  uint32_t val = SysTick->VAL;
+  uint32_t stopped = ticklessCycles ();
+  if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0u)
+    {
+      // A tick is already pending, process it first.
+      SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+      __WFI ();
+      return;
+    }
+  if (val == 0u)
+    {
+      // Just (re)started, a full tick to go.
+      val = reload;
+    }
+
+  // Keep the phase of the tick: the first tick was already
+  // partly counted, and the counter was stopped for a few cycles.
+  uint32_t lost = ticklessCycles () - stopped;
+  val = (val > lost + 1u) ? val - lost : 1u;
+  uint32_t load = val + reload * (ticks - 1u);
+  SysTick->LOAD = load;
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+  __WFI ();
+
+  uint32_t ctrl = SysTick->CTRL;
+  SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+  val = SysTick->VAL;
+  stopped = ticklessCycles ();
+
+  ticks_t elapsed;
+  uint32_t next;
+  if ((ctrl & SysTick_CTRL_COUNTFLAG_Msk) != 0u)
+    {
+      // The deadline was reached; the pending SysTick interrupt
+      // will process the last tick.
+      elapsed = ticks - 1u;
+      next = reload - 1u - (load - val);
+      if ((load - val) >= reload - 2u)
+        {
+          next = reload - 1u;
+        }
+    }
+  else
+    {
+      // Woken up earlier by another interrupt; the tick in progress
+      // is left to the SysTick interrupt, even if it is only a few
+      // cycles away (a reload value of 0 would stop the counter).
+      elapsed = ticks - 1u - val / reload;
+      next = val % reload;
+      next = (next >= 2u) ? next - 1u : 1u;
+    }
+
+  // Restart with the remainder of the current tick, less the cycles
+  // the counter was stopped. The counter loads it on its next clock;
+  // the reload value for the full ticks must be restored right after,
+  // before the catch up below, otherwise a short remainder would be
+  // reloaded several times, and the ticks would drift.
+  lost = ticklessCycles () - stopped;
+  next = (next > lost + 1u) ? next - lost : 1u;
+  SysTick->LOAD = next;
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+  while ((SysTick->VAL == 0u)
+      && ((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) == 0u))
+    {
+      ;
+    }
+  SysTick->LOAD = reload - 1u;
+
+  ms_ticks += elapsed;
+  for (ticks_t i = 0; i < elapsed; ++i)
+    {
+      clock_tick ();
+#if defined(USE_HAL_DRIVER)
+      HAL_IncTick ();
+#endif
+    }
+}
+
+#endif // defined(OS_USE_TIMER_TICKLESS)
+
 void
 Timer::sleep(ticks_t ticks)
 {
-  ms_delayCount = ticks;
+  if (ticks == 0u)
+    {
+      return;
+    }
+
+  volatile bool done = false;
+  Event event
+    { [](void* arg)
+      {
+        *static_cast<volatile bool*>(arg) = true;
+      }, const_cast<bool*>(&done) };
+  event.arm (ticks);
+
+  // Sleep until the event expires. The flag is checked with the
+  // interrupts disabled; WFI still wakes up on a pending interrupt,
+  // which is taken as soon as PRIMASK is restored.
+  uint32_t primask = __get_PRIMASK ();
+  for (;;)
+    {
+      __disable_irq ();
+      if (done)
+        {
+          break;
+        }
+#if defined(OS_USE_TIMER_TICKLESS)
+      sleepTickless ();
+#else
+      __WFI ();
+#endif
+      __set_PRIMASK (primask);
+    }
+  __set_PRIMASK (primask);
+}
+
+void OS_FAST_ISR
+Timer::tick(void)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  ticks_t now = ms_ticks + 1u;
+  ms_ticks = now;
+
+  // At the end of a turn, move the next slot of the upper level down.
+  for (unsigned int level = 1; level < WHEEL_LEVELS; ++level)
+    {
+      if ((now & (wheelSpan(level, WHEEL_SLOT_BITS) - 1u)) != 0u)
+        {
+          break;
+        }
+
+      Event** head = &ms_wheel[level][(now >> (WHEEL_SLOT_BITS * level))
+          & (WHEEL_SLOTS - 1)];
+      Event* event = *head;
+      *head = nullptr;
+      while (event != nullptr)
+        {
+          Event* next = event->fNext;
+          insert (event);
+          event = next;
+        }
+    }
+
+  // All events in the current slot expire now. Periodic events are
+  // re-armed before the callback, which may cancel them; the callbacks
+  // run with the interrupts enabled.
+  Event** head = &ms_wheel[0][now & (WHEEL_SLOTS - 1)];
+  while (*head != nullptr)
+    {
+      Event* event = *head;
+      remove (event);
+      if (event->fPeriod != 0u)
+        {
+          event->fExpires += event->fPeriod;
+          insert (event);
+        }
+
+      __set_PRIMASK (primask);
+      event->fCallback (event->fArg);
+      __disable_irq ();
+    }
+
+  __set_PRIMASK (primask);
+}
+
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include <new>
+#include "diag/Bench.h"
+
+// Same as in Timer.c: the background events (10, 100 or 1000) are
+// armed far away, the probes are armed by the arm runs and cancelled
+// by the cancel runs. The pool is a static array, constructed on the
+// first warm up run, so neither the allocator nor the constructors
+// are measured.
+
+#if !defined(OS_INTEGER_TIMER_BENCH_EVENTS)
+#define OS_INTEGER_TIMER_BENCH_EVENTS (1000u)
+#endif
+
+namespace
+{
+  constexpr std::size_t benchEvents = OS_INTEGER_TIMER_BENCH_EVENTS;
+  constexpr std::size_t benchProbes = OS_INTEGER_BENCH_WARMUP
+      + OS_INTEGER_BENCH_REPETITIONS;
+
+  // The background events, followed by the probes.
+  alignas(Timer::Event) unsigned char benchStorage[(benchEvents
+      + benchProbes) * sizeof(Timer::Event)];
+  Timer::Event* benchPool;
+  std::size_t benchArmed;
+  std::size_t benchNext;
+
+  void
+  benchNoop(void*)
+  {
+  }
+
+  // Arm the given number of background events; called from the
+  // warm up runs, so it is not measured.
+  void
+  benchPopulate(std::size_t count)
+  {
+    if (benchPool == nullptr)
+      {
+        benchPool = reinterpret_cast<Timer::Event*>(benchStorage);
+        for (std::size_t i = 0; i < benchEvents + benchProbes; ++i)
+          {
+            new (&benchPool[i]) Timer::Event(benchNoop);
+          }
+      }
+    for (std::size_t i = benchArmed; i > count; --i)
+      {
+        benchPool[i - 1].cancel();
+      }
+    for (std::size_t i = benchArmed; i < count; ++i)
+      {
+        benchPool[i].arm(10000u + static_cast<Timer::ticks_t>((i * 7919u)
+            % 100000u));
+      }
+    benchArmed = count;
+  }
+
+  void
+  benchArm(void* arg)
+  {
+    benchPopulate(reinterpret_cast<std::size_t>(arg));
+    benchPool[benchEvents + benchNext++].arm(100u);
+  }
 
-  // Busy wait until the SysTick decrements the counter to zero.
-  while (ms_delayCount != 0u)
-    ;
+  void
+  benchCancel(void*)
+  {
+    benchPool[benchEvents + --benchNext].cancel();
+  }
+
+  void
+  benchTick(void* arg)
+  {
+    static Timer::Event probe(benchNoop);
+
+    benchPopulate(reinterpret_cast<std::size_t>(arg));
+    if (!probe.isArmed())
+      {
+        // Expires, and is re-armed, on each tick.
+        probe.arm(1u, 1u);
+      }
+    Timer::tick();
+  }
+
+  bench_t benches[] =
+    {
+      { "timer_arm_10", benchArm, reinterpret_cast<void*>(10), nullptr },
+      { "timer_cancel_10", benchCancel, reinterpret_cast<void*>(10), nullptr },
+      { "timer_tick_10", benchTick, reinterpret_cast<void*>(10), nullptr },
+      { "timer_arm_100", benchArm, reinterpret_cast<void*>(100), nullptr },
+      { "timer_cancel_100", benchCancel, reinterpret_cast<void*>(100),
+          nullptr },
+      { "timer_tick_100", benchTick, reinterpret_cast<void*>(100), nullptr },
+      { "timer_arm_1000", benchArm, reinterpret_cast<void*>(1000), nullptr },
+      { "timer_cancel_1000", benchCancel, reinterpret_cast<void*>(1000),
+          nullptr },
+      { "timer_tick_1000", benchTick, reinterpret_cast<void*>(1000), nullptr },
+    };
+
+  struct BenchRegistrar
+  {
+    BenchRegistrar()
+    {
+      for (auto& bench : benches)
+        {
+          // The argument is the number of background events; with
+          // a smaller pool, skip the larger benchmarks.
+          if (reinterpret_cast<std::size_t>(bench.arg) <= benchEvents)
+            {
+              bench_register(&bench);
+            }
+        }
+    }
+  } benchRegistrar;
 }
 
+#endif // defined(OS_USE_BENCH)
+
 // ----- SysTick_Handler() ----------------------------------------------------
 
-extern "C" void
+extern "C" void OS_FAST_ISR
 SysTick_Handler(void)
 {
+#if defined(OS_USE_STACK_USAGE)
+  stack_usage_tick();
+#endif
+  clock_tick();
 #if defined(USE_HAL_DRIVER)
   HAL_IncTick();
 #endif
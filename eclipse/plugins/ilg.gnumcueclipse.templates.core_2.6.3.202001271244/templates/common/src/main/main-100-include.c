@@ -30,3 +30,5 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "diag/Trace.h"
+#include "diag/Bench.h"
+#include "diag/StartupProfiler.h"
@@ -1,3 +1,15 @@
   // At this stage the system clock should have already been configured
   // at high speed.
   trace_printf("System clock: %u Hz\n", SystemCoreClock);
+
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+  // Display the duration of the startup steps, up to main()
+  // (see diag/StartupProfiler.h).
+  __startup_profiler_dump();
+#endif
+
+#if defined(OS_USE_BENCH)
+  // Run the microbenchmarks (see diag/Bench.h); the results are
+  // printed on the trace output.
+  bench_run_all();
+#endif
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_CLOCK_H_
+#define CORTEXM_CLOCK_H_
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// A 64-bit monotonic clock, with the resolution of the core clock.
+//
+// On ARMv7-M the DWT cycle counter is extended to 64-bits; on ARMv6-M
+// (or with OS_USE_CLOCK_SYSTICK defined) the ticks are counted and
+// the current SysTick value is added. The readers do not disable the
+// interrupts; if an update is detected while reading, they retry,
+// so they can be used from interrupt handlers too.
+//
+// clock_tick() must be called from SysTick_Handler(), once per tick
+// (the Timer template does it). With DWT it must be called at least
+// once every 2^32 cycles; with SysTick, an interrupt with a higher
+// priority than SysTick that preempts the handler before the call
+// might read a value one tick behind.
+//
+// clock_initialize() must be called again after SystemCoreClock
+// changes; the cycles are not reset, and the nanoseconds continue
+// from the value at the change.
+//
+// With OS_USE_CLOCK_HAL_GETTICK defined, HAL_GetTick() is computed
+// from this clock, and the HAL timeouts (HAL_Delay() included) also
+// work with the SysTick interrupt masked; before clock_initialize(),
+// it returns the ticks counted by HAL_IncTick(), and the clock
+// continues from them.
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Enable the counter and compute the nanoseconds conversion.
+  void
+  clock_initialize (void);
+
+  void
+  clock_tick (void);
+
+  // The core clock cycles since the first clock_initialize().
+  uint64_t
+  clock_now_cycles (void);
+
+  uint64_t
+  clock_now_ns (void);
+
+  uint64_t
+  clock_cycles_to_ns (uint64_t cycles);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_CLOCK_H_
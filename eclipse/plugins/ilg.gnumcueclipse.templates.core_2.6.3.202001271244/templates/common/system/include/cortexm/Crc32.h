@@ -0,0 +1,78 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_CRC32_H_
+#define CORTEXM_CRC32_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+// Software CRC-32 with the polynomial 0x04C11DB7, not reflected,
+// as computed by the STM32 CRC unit, for the devices without it and
+// for the host builds.
+//
+// The bytes are processed 8 at a time with 8 tables of 256 words
+// (slicing-by-8, 8 KB of flash), instead of 8 shift/xor steps per
+// byte; the buffers may have any alignment and length. With
+// OS_USE_BENCH, the crc32_sw_* benchmarks measure 1 KB buffers.
+//
+// Two orders are available:
+// - crc32_update() processes the bytes in the order they are in
+//   memory, most significant bit first (with CRC32_INIT and no final
+//   xor, this is CRC-32/MPEG-2; it is the order of the F7 unit with
+//   CRC_INPUTDATA_FORMAT_BYTES);
+// - crc32_update_words() processes each group of 4 bytes as a little
+//   endian word, as the F4 unit does with HAL_CRC_Accumulate() on
+//   a word buffer (or the F7 with CRC_INPUTDATA_FORMAT_WORDS); the
+//   1 to 3 bytes after the last full word are processed in memory
+//   order, as the DMA variant of the HAL functions does.
+//
+// The returned value is the new CRC, to be passed to the next call
+// to continue the computation.
+
+#define CRC32_INIT (0xFFFFFFFFu)
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  uint32_t
+  crc32_update (uint32_t crc, const void* buf, size_t len);
+
+  uint32_t
+  crc32_update_words (uint32_t crc, const void* buf, size_t len);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_CRC32_H_
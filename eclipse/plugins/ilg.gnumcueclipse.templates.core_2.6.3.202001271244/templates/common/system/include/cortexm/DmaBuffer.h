@@ -0,0 +1,115 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_DMA_BUFFER_H_
+#define CORTEXM_DMA_BUFFER_H_
+
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+// Buffers shared with the DMA controllers, on cores with a data cache
+// (Cortex-M7).
+//
+// The variables marked with OS_DMA_BUFFER and the blocks returned by
+// dma_buffer_alloc() are in the .dmabuffer section, at the beginning
+// of the DMA_BUFFER region alias defined in mem.ld (RAM, or SRAM2 in
+// the STM32F7 templates, so the buffers are in the AXI SRAM and not
+// in the DTCM). When mem.ld defines __Dma_Buffer_Size (16K in the
+// STM32F7 templates), the section has this size, a power of two, and
+// is aligned to it; dma_buffer_init() then makes it non cacheable
+// with one MPU region, so the CPU and the DMA always see the same
+// data, without any clean or invalidate. The space not used by the
+// variables is the dma_buffer_alloc() pool.
+//
+// Without __Dma_Buffer_Size, the section only holds the variables
+// and dma_buffer_alloc() returns NULL; the buffers are still aligned
+// to the cache line, so the clean/invalidate by address (done by the
+// STM32F7 HAL DMA driver with DMA_DCACHE_MAINTENANCE_ENABLE) never
+// touches the neighbouring variables.
+//
+// The variables are zeroed by the startup code with the other bss
+// regions (OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS is required,
+// the linker script checks it); they cannot have non zero
+// initialisers, which the compiler rejects. The pool is not cleared.
+
+// The Cortex-M7 cache line.
+#define OS_INTEGER_DMA_BUFFER_ALIGNMENT (32)
+
+#if !defined(OS_INTEGER_DMA_BUFFER_MPU_REGION)
+// The highest region of the Cortex-M7 MPU, which takes precedence
+// over the others.
+#define OS_INTEGER_DMA_BUFFER_MPU_REGION (7)
+#endif
+
+#define OS_DMA_BUFFER \
+  __attribute__((section(".bss.dmabuffer"), aligned(OS_INTEGER_DMA_BUFFER_ALIGNMENT)))
+
+// Zeroed variables that must go through the D-cache, for example to
+// compare the cached and non cached accesses: on STM32F7 .bss is in
+// the DTCM, which is never cached, and these are placed after the
+// end of the DTCM (__Cached_Bss_Start in mem.ld), in the AXI SRAM.
+// Like OS_DMA_BUFFER, they need the multi-region startup; they cannot
+// have initialisers.
+#define OS_CACHED_BSS \
+  __attribute__((section(".cachedbss"), aligned(OS_INTEGER_DMA_BUFFER_ALIGNMENT)))
+
+// Round a buffer size up to whole cache lines, so that the next
+// variable does not share the last line.
+#define OS_DMA_BUFFER_SIZE(size) \
+  (((size) + OS_INTEGER_DMA_BUFFER_ALIGNMENT - 1) \
+      & ~(OS_INTEGER_DMA_BUFFER_ALIGNMENT - 1))
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Make the .dmabuffer section non cacheable; return -1 if it has
+  // no valid MPU size (no __Dma_Buffer_Size) or there is no MPU.
+  // Called by __initialize_hardware() on STM32F7, before the
+  // D-cache is enabled.
+  int
+  dma_buffer_init (void);
+
+  // Return a block of whole cache lines from the pool, or NULL if the
+  // pool is exhausted. The blocks are never freed; allocate them
+  // once, during the initialisations.
+  void*
+  dma_buffer_alloc (size_t size);
+
+  // Return the bytes still available in the pool.
+  size_t
+  dma_buffer_available (void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_DMA_BUFFER_H_
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_FAST_CODE_H_
+#define CORTEXM_FAST_CODE_H_
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// Placement of the hot code and data in zero wait state memory.
+//
+// The functions marked with OS_FAST_CODE are linked in the FAST_CODE
+// region and the variables marked with OS_FAST_DATA (initialised) or
+// OS_FAST_BSS (cleared) in the FAST_DATA region; both regions are
+// aliases defined in mem.ld: ITCM and the DTCM at the beginning of
+// RAM on STM32F7, RAM and CCMRAM on the STM32F4 devices with CCM,
+// RAM on the others. The code and the initial values are copied from
+// flash by the startup code, which must be built with
+// OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS (as in the STM32F3,
+// F4 and F7 templates). The CCMRAM is not reachable by DMA, so the
+// DMA buffers must not be marked.
+//
+// With OS_USE_FAST_VECTORS, the vector table is copied to the
+// beginning of RAM by __initialize_hardware(), and with
+// OS_USE_FAST_ISRS the handlers marked with OS_FAST_ISR (SysTick, the
+// timer tick in the templates, and the STM32F4/F7 HAL DMA and UART
+// interrupt handlers) are linked in FAST_CODE.
+//
+// The calls between flash and RAM are out of the range of the BL
+// instruction, so the linker adds a veneer; the fast functions are
+// never inlined in their callers. On STM32F4 the ART accelerator
+// hides most of the flash wait states for loops, so the gain is
+// mostly in the latency of rarely executed handlers; with OS_USE_BENCH
+// and OS_USE_FAST_VECTORS, the fast_* benchmarks compare the same
+// handler linked in flash and in RAM.
+
+#define OS_FAST_CODE __attribute__((section(".fastcode"), noinline))
+#define OS_FAST_DATA __attribute__((section(".fastdata")))
+#define OS_FAST_BSS __attribute__((section(".fastbss")))
+
+#if defined(OS_USE_FAST_ISRS)
+#define OS_FAST_ISR OS_FAST_CODE
+#else
+#define OS_FAST_ISR
+#endif
+
+#if !defined(OS_INTEGER_FAST_VECTORS)
+// The size of the RAM vector table, a power of two.
+#define OS_INTEGER_FAST_VECTORS (128)
+#endif
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  typedef void
+  (*fast_vectors_handler_t) (void);
+
+  // Copy the vector table to RAM and point VTOR to it;
+  // return -1 if the table does not fit.
+  int
+  fast_vectors_relocate (void);
+
+  // Replace a handler in the RAM vector table and return the
+  // previous one; the irq is the CMSIS number (SysTick_IRQn is -1).
+  fast_vectors_handler_t
+  fast_vectors_set_handler (int irq, fast_vectors_handler_t handler);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_FAST_CODE_H_
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_HEAP_H_
+#define CORTEXM_HEAP_H_
+
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+// With OS_USE_HEAP_TLSF defined, malloc() & co are replaced by a
+// two-level segregated fit allocator (TLSF), with constant time
+// allocation and deallocation, bounded fragmentation, and interrupts
+// disabled only for a few dozen instructions.
+//
+// The free blocks are kept in lists indexed by a first level (the power
+// of two of the size) and a second level (2^OS_INTEGER_HEAP_SL_LOG2
+// linear subdivisions of each power of two). Larger values for the
+// second level reduce the fragmentation, at the cost of a larger
+// control structure (4 * HEAP_CLASSES * 2^OS_INTEGER_HEAP_SL_LOG2 bytes).
+
+// The number of second level subdivisions, as a power of two (max 5).
+#if !defined(OS_INTEGER_HEAP_SL_LOG2)
+#define OS_INTEGER_HEAP_SL_LOG2 (4)
+#endif
+
+// Blocks are smaller than (1 << OS_INTEGER_HEAP_FL_MAX) bytes; larger
+// regions are managed as several adjacent blocks.
+#if !defined(OS_INTEGER_HEAP_FL_MAX)
+#define OS_INTEGER_HEAP_FL_MAX (20)
+#endif
+
+// The number of first level size classes; the first class keeps all
+// blocks smaller than (8 << OS_INTEGER_HEAP_SL_LOG2) bytes.
+#define HEAP_CLASSES (OS_INTEGER_HEAP_FL_MAX - OS_INTEGER_HEAP_SL_LOG2 - 3 + 1)
+
+typedef struct
+{
+  // Managed memory, including the block headers.
+  size_t total_bytes;
+  // Allocated memory, including the block headers.
+  size_t used_bytes;
+  // The largest value of used_bytes so far (high-water mark).
+  size_t max_used_bytes;
+  // Memory available in the free blocks.
+  size_t free_bytes;
+  // The largest allocation that would currently succeed.
+  size_t largest_free_bytes;
+  // The percentage of the free memory outside the largest free block.
+  unsigned int fragmentation;
+
+  unsigned int allocated_blocks;
+  unsigned int free_blocks;
+  unsigned int failed_allocations;
+
+  // Allocated blocks, by first level size class.
+  unsigned int class_allocated[HEAP_CLASSES];
+} heap_stats_t;
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Add a region of memory (for example external RAM) to the heap;
+  // return -1 if it is too small. The region between _Heap_Begin and
+  // _Heap_Limit, defined in the linker script, is added automatically,
+  // before the first allocation.
+  int
+  heap_add_region (void* begin, size_t size);
+
+  // Take a snapshot of the heap statistics. Finding the largest
+  // free block walks a free list, so prefer calling it from the
+  // background, not from interrupt handlers.
+  void
+  heap_get_stats (heap_stats_t* stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_HEAP_H_
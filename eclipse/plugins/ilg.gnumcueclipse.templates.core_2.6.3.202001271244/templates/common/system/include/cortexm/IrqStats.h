@@ -0,0 +1,112 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_IRQ_STATS_H_
+#define CORTEXM_IRQ_STATS_H_
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// Per interrupt statistics, enabled by OS_USE_IRQ_STATS.
+//
+// irq_stats_start() copies the vector table to RAM and points SysTick
+// and all device interrupts to a dispatcher, which counts the entries
+// and measures the cycles spent in each handler (the time spent in
+// nested, higher priority, handlers is not included). The other
+// system exceptions (faults, SVC, PendSV) are not touched. When not
+// started, or after irq_stats_stop(), the handlers are reached
+// directly, without any overhead.
+//
+// The entry latency (the cycles from the event to the handler) is
+// known only for the sources with a probe: SysTick has one by
+// default, other timers can register theirs with
+// irq_stats_set_probe(). The latencies are kept in a histogram,
+// bucket 0 for less than 32 cycles, bucket n for less than 32 << n,
+// and the last one for the rest.
+//
+// The cycles are counted with DWT CYCCNT on ARMv7-M, and with the
+// SysTick counter on ARMv6-M (the handlers must be shorter than a
+// tick). The vector table must be relocatable (VTOR). While the
+// statistics are running, NVIC_SetVector() must not be used.
+
+#if !defined(OS_INTEGER_IRQ_STATS_VECTORS)
+// The size of the RAM vector table, a power of two; the vectors
+// beyond it are not instrumented.
+#define OS_INTEGER_IRQ_STATS_VECTORS (128)
+#endif
+
+#if !defined(OS_INTEGER_IRQ_STATS_BUCKETS)
+#define OS_INTEGER_IRQ_STATS_BUCKETS (10)
+#endif
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint32_t latency[OS_INTEGER_IRQ_STATS_BUCKETS];
+} irq_stats_t;
+
+// Return the cycles elapsed since the event that triggered
+// the interrupt.
+typedef uint32_t
+(*irq_stats_probe_t) (void);
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Return -1 if the vector table cannot be relocated.
+  int
+  irq_stats_start (void);
+
+  void
+  irq_stats_stop (void);
+
+  void
+  irq_stats_reset (void);
+
+  // The irq is the CMSIS number (SysTick_IRQn is -1).
+  void
+  irq_stats_get (int irq, irq_stats_t* stats);
+
+  void
+  irq_stats_set_probe (int irq, irq_stats_probe_t probe);
+
+  // Print the sources with at least one entry on the trace output.
+  void
+  irq_stats_dump (void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_IRQ_STATS_H_
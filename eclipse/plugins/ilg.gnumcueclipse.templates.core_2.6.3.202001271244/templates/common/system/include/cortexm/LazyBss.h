@@ -0,0 +1,70 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_LAZY_BSS_H_
+#define CORTEXM_LAZY_BSS_H_
+
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+// Large buffers that are written before being read (frame buffers,
+// network pools, etc) do not need to be cleared by the startup code.
+// Placed in the .lazybss section, they are cleared after main()
+// starts, in small steps, by calls to lazy_bss_clear() from the
+// idle loop. The code that needs a buffer before the background
+// clear reaches it must call lazy_bss_ensure() first.
+//
+// Other regions (for example in external RAM) can be added with
+// lazy_bss_register().
+
+#define OS_ATTRIBUTE_LAZY_BSS __attribute__((section(".lazybss")))
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Add a region to be cleared lazily; return -1 if the table is full.
+  int
+  lazy_bss_register (void* begin, size_t size);
+
+  // Clear at most max_bytes; return the number of bytes still pending.
+  size_t
+  lazy_bss_clear (size_t max_bytes);
+
+  // Make sure the given range is cleared, before the first use.
+  void
+  lazy_bss_ensure (void* begin, size_t size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_LAZY_BSS_H_
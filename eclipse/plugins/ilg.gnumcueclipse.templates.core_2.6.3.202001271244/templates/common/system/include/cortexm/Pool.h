@@ -0,0 +1,103 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_POOL_H_
+#define CORTEXM_POOL_H_
+
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+// With OS_USE_CXX_POOLS defined, the C++ operator new and delete use
+// fixed size pools, with constant time allocation and deallocation
+// (a free list pop or push, with the interrupts disabled for a few
+// instructions), instead of malloc().
+//
+// The pools take their memory from a static arena, in pages of
+// OS_INTEGER_POOL_PAGE_SIZE bytes; each page is dedicated to one
+// size class (8, 16, 32, ... bytes), and the class of a block is
+// found from its address, so there is no per block header. The pages
+// are never given back to the arena, but the freed blocks are reused
+// by the same class. The requests larger than the largest class, or
+// made after the arena is exhausted, are passed to malloc().
+//
+// The objects built once at startup, and never deleted, can be
+// placed in the arena with pool_arena_alloc(), which takes the
+// memory from the arena end, without any rounding to a size class:
+//   Object* obj = new (pool_arena_alloc (sizeof(Object), alignof(Object)))
+//       Object (...);
+
+#if !defined(OS_INTEGER_POOL_ARENA_SIZE)
+#define OS_INTEGER_POOL_ARENA_SIZE (4096)
+#endif
+
+#if !defined(OS_INTEGER_POOL_PAGE_SIZE)
+#define OS_INTEGER_POOL_PAGE_SIZE (256)
+#endif
+
+// The size classes are 8 << 0 to 8 << (OS_INTEGER_POOL_CLASSES - 1).
+#if !defined(OS_INTEGER_POOL_CLASSES)
+#define OS_INTEGER_POOL_CLASSES (5)
+#endif
+
+typedef struct
+{
+  size_t arena_bytes;
+  // The pages given to the pools, plus the arena allocations.
+  size_t arena_used_bytes;
+  unsigned int class_allocated[OS_INTEGER_POOL_CLASSES];
+  // Requests passed to malloc().
+  unsigned int fallback_allocations;
+} pool_stats_t;
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Return NULL when the pools and malloc() have no memory.
+  void*
+  pool_alloc (size_t size);
+
+  void
+  pool_free (void* ptr);
+
+  // Return NULL if the arena is exhausted; the align must be a
+  // power of two. The memory cannot be freed.
+  void*
+  pool_arena_alloc (size_t size, size_t align);
+
+  void
+  pool_get_stats (pool_stats_t* stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_POOL_H_
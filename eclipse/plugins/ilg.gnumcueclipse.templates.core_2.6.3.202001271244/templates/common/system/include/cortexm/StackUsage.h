@@ -0,0 +1,111 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORTEXM_STACK_USAGE_H_
+#define CORTEXM_STACK_USAGE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+// Stack usage measurement, enabled by OS_USE_STACK_USAGE.
+//
+// The startup code fills the main stack, from __Main_Stack_Limit up
+// to the current stack pointer, with STACK_USAGE_PAINT, before the
+// data and bss are initialised. The high-water mark is the lowest
+// word no longer holding the pattern; stack_usage_high_water()
+// finds it by scanning up from the bottom, so the cost is
+// proportional to the free space, and the result is remembered to
+// shorten the next scans.
+//
+// Other stacks (for example the process stacks of the threads) can
+// be painted and added with stack_usage_register(). A large local
+// array which is never written may hide part of the usage, so leave
+// some margin.
+//
+// When stack_usage_tick() is called from SysTick_Handler() (as in
+// the templates), the MSP and the PSP are also sampled on each tick,
+// and the lowest values are kept; if a sample is below the bottom of
+// its stack, stack_usage_overflow() is called.
+
+#define STACK_USAGE_PAINT (0xCCCCCCCCu)
+
+#if !defined(OS_INTEGER_STACK_USAGE_MAX_STACKS)
+// The main stack always uses the first entry.
+#define OS_INTEGER_STACK_USAGE_MAX_STACKS (4)
+#endif
+
+typedef struct
+{
+  const char* name;
+  uint32_t* bottom;
+  uint32_t* top;
+  uint32_t* high_water; // lowest word found modified
+  uint32_t* lowest_sp; // lowest stack pointer sampled
+} stack_usage_t;
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Fill the stack with the pattern; it must not be in use.
+  void
+  stack_usage_paint (void* bottom, size_t size);
+
+  // Add a painted stack; return -1 if the table is full.
+  int
+  stack_usage_register (const char* name, void* bottom, size_t size);
+
+  // Return the number of bytes used, at the deepest point; the
+  // index is 0 for the main stack, or the registration order.
+  size_t
+  stack_usage_high_water (int index);
+
+  // Sample the stack pointers; called from SysTick_Handler().
+  void
+  stack_usage_tick (void);
+
+  // Called from stack_usage_tick() when a stack pointer is below
+  // the bottom of its stack; by default it prints a message (once)
+  // and, in debug builds, stops in the debugger.
+  void
+  stack_usage_overflow (const stack_usage_t* stack, uint32_t sp);
+
+  // Print the size, the high-water mark and the deepest sample of
+  // each stack on the trace output.
+  void
+  stack_usage_dump (void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CORTEXM_STACK_USAGE_H_
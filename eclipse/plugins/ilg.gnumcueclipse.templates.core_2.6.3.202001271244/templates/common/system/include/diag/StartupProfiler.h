@@ -0,0 +1,67 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DIAG_STARTUP_PROFILER_H_
+#define DIAG_STARTUP_PROFILER_H_
+
+// ----------------------------------------------------------------------------
+
+// With OS_INCLUDE_STARTUP_PROFILER defined for the whole project,
+// _startup.c measures the duration of each startup step, including
+// each static constructor, up to the call to main(), with the DWT
+// cycle counter (ARMv7-M only). __startup_profiler_dump() prints the
+// table on the trace output; it is called by main(), since the
+// output may be slow and must not delay the application startup.
+
+#if defined(OS_INCLUDE_STARTUP_PROFILER) \
+  && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  void
+  __startup_profiler_dump (void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#else
+
+static inline void
+__attribute__((always_inline))
+__startup_profiler_dump (void)
+{
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // DIAG_STARTUP_PROFILER_H_
@@ -31,6 +31,7 @@
 // ----------------------------------------------------------------------------
 
 #include <unistd.h>
+#include <stdint.h>
 
 // ----------------------------------------------------------------------------
 
@@ -51,13 +52,64 @@
 // changing the definitions required in system/src/diag/trace_impl.c
 // (currently OS_USE_TRACE_ITM, OS_USE_TRACE_SEMIHOSTING_DEBUG/_STDOUT).
 //
+// With OS_USE_TRACE_ITM_DEFERRED, trace_write() only copies the bytes
+// into a RAM ring buffer and returns; the actual ITM output is done
+// later by trace_flush(), called from the application idle loop or
+// from PendSV (OS_USE_TRACE_ITM_DEFERRED_PENDSV).
+//
 // When TRACE is not defined, all functions are inlined to empty bodies.
 // This has the advantage that the trace call do not need to be conditionally
 // compiled with #ifdef TRACE/#endif
+//
+// Binary data (events, counters) can be sent on separate channels,
+// via trace_write_channel(). With ITM, each channel is routed to its
+// own stimulus port (by default 0 for text, 1 for events and
+// 2 for counters, see trace_route_channel()).
 
+//
+// trace_log() is a lightweight alternative to trace_printf(): the format
+// string is stored in the .trace_fmt section, which is not loaded in
+// flash, and only its offset and the raw arguments are sent on the
+// events channel; the text is reconstructed on the host from the ELF
+// file (scripts/trace_log_decode.py). The arguments (at most
+// TRACE_LOG_MAX_ARGS) must be integers, characters or pointers;
+// strings and floating point values are not supported.
+// With OS_USE_TRACE_LOG_TIMESTAMPS defined, each packet also carries
+// the clock_now_ns() value (cortexm/Clock.h), printed by the decoder
+// in front of the message.
+// The interrupts are disabled only to queue the packet; the packets
+// logged by interrupts while another call is sending are sent by that
+// call, and dropped if the queue (OS_INTEGER_TRACE_LOG_QUEUE_WORDS)
+// is full.
+
+typedef enum
+{
+  trace_channel_text = 0,
+  trace_channel_events,
+  trace_channel_counters,
+  trace_channel_count
+} trace_channel_t;
+
+
+#define TRACE_LOG_MAX_ARGS (8)
 
 #if defined(TRACE)
 
+// Count the arguments, 0 to 8 (the GNU ## extension handles 0).
+#define TRACE_LOG_NARGS(...) \
+  TRACE_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TRACE_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+#define trace_log(format, ...) \
+  do \
+    { \
+      static const char __trace_log_format[] \
+        __attribute__((section(".trace_fmt"), used)) = format; \
+      trace_log_write ((uint32_t) (uintptr_t) __trace_log_format, \
+                       TRACE_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__); \
+    } \
+  while (0)
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -70,6 +122,28 @@ extern "C"
   ssize_t
   trace_write(const char* buf, size_t nbyte);
 
+  ssize_t
+  trace_write_channel(trace_channel_t channel, const void* buf, size_t nbyte);
+
+  void
+  trace_route_channel(trace_channel_t channel, unsigned int port);
+
+  // Push the buffered output (if any) to the device.
+  void
+  trace_flush(void);
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED) || defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV)
+  typedef struct
+  {
+    uint32_t dropped_writes; // trace_write() calls discarded when full
+    uint32_t dropped_bytes; // bytes lost in the discarded calls
+    uint32_t high_water; // max number of bytes pending in the ring
+  } trace_ring_stats_t;
+
+  void
+  trace_get_ring_stats(trace_ring_stats_t* stats);
+#endif // OS_USE_TRACE_ITM_DEFERRED
+
   // ----- Portable -----
 
   int
@@ -84,12 +158,20 @@ extern "C"
   void
   trace_dump_args(int argc, char* argv[]);
 
+  // Called via trace_log(), do not use directly.
+  void
+  trace_log_write(uint32_t format, unsigned int nargs, ...);
+
 #if defined(__cplusplus)
 }
 #endif
 
 #else // !defined(TRACE)
 
+// The arguments are still evaluated, as for the other functions.
+#define trace_log(format, ...) \
+  trace_log_write (0, 0, ##__VA_ARGS__)
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -102,6 +184,15 @@ extern "C"
   inline ssize_t
   trace_write(const char* buf, size_t nbyte);
 
+  inline ssize_t
+  trace_write_channel(trace_channel_t channel, const void* buf, size_t nbyte);
+
+  inline void
+  trace_route_channel(trace_channel_t channel, unsigned int port);
+
+  inline void
+  trace_flush(void);
+
   inline int
   trace_printf(const char* format, ...);
 
@@ -114,6 +205,9 @@ extern "C"
   inline void
   trace_dump_args(int argc, char* argv[]);
 
+  inline void
+  trace_log_write(uint32_t format, unsigned int nargs, ...);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -133,6 +227,28 @@ trace_write(const char* buf __attribute__((unused)),
   return 0;
 }
 
+inline ssize_t
+__attribute__((always_inline))
+trace_write_channel(trace_channel_t channel __attribute__((unused)),
+    const void* buf __attribute__((unused)),
+    size_t nbyte __attribute__((unused)))
+{
+  return 0;
+}
+
+inline void
+__attribute__((always_inline))
+trace_route_channel(trace_channel_t channel __attribute__((unused)),
+    unsigned int port __attribute__((unused)))
+{
+}
+
+inline void
+__attribute__((always_inline))
+trace_flush(void)
+{
+}
+
 inline int
 __attribute__((always_inline))
 trace_printf(const char* format __attribute__((unused)), ...)
@@ -161,6 +277,13 @@ trace_dump_args(int argc __attribute__((unused)),
 {
 }
 
+inline void
+__attribute__((always_inline))
+trace_log_write(uint32_t format __attribute__((unused)),
+    unsigned int nargs __attribute__((unused)), ...)
+{
+}
+
 #endif // defined(TRACE)
 
 // ----------------------------------------------------------------------------
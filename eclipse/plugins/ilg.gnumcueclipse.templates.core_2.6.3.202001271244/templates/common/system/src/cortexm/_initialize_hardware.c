@@ -29,6 +29,10 @@
 
 #include "cmsis_device.h"
 
+#if defined(OS_USE_FAST_VECTORS)
+#include "cortexm/FastCode.h"
+#endif
+
 // ----------------------------------------------------------------------------
 
 extern unsigned int __vectors_start;
@@ -104,6 +108,11 @@ __initialize_hardware(void)
   // Call the CSMSIS system clock routine to store the clock frequency
   // in the SystemCoreClock global RAM location.
   SystemCoreClockUpdate();
+
+#if defined(OS_USE_FAST_VECTORS)
+  // Copy the vector table to zero wait state RAM.
+  fast_vectors_relocate();
+#endif
 }
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,266 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cortexm/Clock.h"
+#include "cmsis_device.h"
+
+#if defined(OS_USE_FAST_ISRS)
+#include "cortexm/FastCode.h"
+#else
+#define OS_FAST_ISR
+#endif
+
+// ----------------------------------------------------------------------------
+
+#if !defined(OS_USE_CLOCK_SYSTICK) && !defined(__ARM_ARCH_7M__) \
+  && !defined(__ARM_ARCH_7EM__)
+#define OS_USE_CLOCK_SYSTICK
+#endif
+
+#define CLOCK_NS_PER_SECOND (1000000000ULL)
+
+#if defined(USE_HAL_DRIVER) && defined(OS_USE_CLOCK_HAL_GETTICK)
+
+// The milliseconds counted by HAL_IncTick(), used until the clock
+// is initialised.
+extern volatile uint32_t uwTick;
+
+// The milliseconds returned by HAL_GetTick(), and the nanoseconds
+// at which they were last incremented.
+static uint32_t clock_ms;
+static uint64_t clock_ms_ns;
+
+#endif
+
+// ns = base + ((cycles - base) * mult) >> shift, with the largest
+// shift that keeps mult in 32-bits.
+static uint64_t clock_ns_base;
+static uint64_t clock_cycles_base;
+static uint32_t clock_ns_mult;
+static uint32_t clock_ns_shift;
+
+#if defined(OS_USE_CLOCK_SYSTICK)
+
+// The SysTick periods since start.
+static volatile uint64_t clock_ticks;
+
+#else
+
+// The cycle counter value at the last tick, and the high word.
+static volatile uint32_t clock_cycles_last;
+static volatile uint32_t clock_cycles_high;
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+uint64_t
+clock_cycles_to_ns (uint64_t cycles)
+{
+  // A 64 x 32 bits multiplication, in two halves, to avoid
+  // overflowing.
+  uint32_t shift = clock_ns_shift;
+  uint64_t high = (uint64_t) (uint32_t) (cycles >> 32) * clock_ns_mult;
+  uint64_t low = (uint64_t) (uint32_t) cycles * clock_ns_mult;
+
+  return (high << (32 - shift)) + (low >> shift);
+}
+
+void
+clock_initialize (void)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  uint64_t cycles = 0;
+  if (clock_ns_mult == 0u)
+    {
+#if defined(USE_HAL_DRIVER) && defined(OS_USE_CLOCK_HAL_GETTICK)
+      // Continue from the HAL ticks, so HAL_GetTick() does not
+      // move back while a timeout is in progress.
+      clock_ns_base = (uint64_t) uwTick * 1000000u;
+      clock_ms = uwTick;
+      clock_ms_ns = clock_ns_base;
+#endif
+#if !defined(OS_USE_CLOCK_SYSTICK)
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if (__CORTEX_M == 0x07U)
+      // Unlock the DWT registers.
+      DWT->LAR = 0xC5ACCE55;
+#endif
+      DWT->CYCCNT = 0;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    }
+  else
+    {
+      cycles = clock_now_cycles ();
+      clock_ns_base += clock_cycles_to_ns (cycles - clock_cycles_base);
+    }
+  clock_cycles_base = cycles;
+
+  uint32_t shift = 32;
+  while ((CLOCK_NS_PER_SECOND << shift) / SystemCoreClock > 0xFFFFFFFFULL)
+    {
+      --shift;
+    }
+  clock_ns_shift = shift;
+  clock_ns_mult = (uint32_t) ((CLOCK_NS_PER_SECOND << shift)
+      / SystemCoreClock);
+
+  __set_PRIMASK (primask);
+}
+
+#if defined(OS_USE_CLOCK_SYSTICK)
+
+void OS_FAST_ISR
+clock_tick (void)
+{
+  clock_ticks++;
+}
+
+uint64_t
+clock_now_cycles (void)
+{
+  uint64_t ticks;
+  uint32_t val;
+  uint32_t pending;
+
+  // The 64-bit ticks are read twice, to detect an update (or a torn
+  // read) in between; the pending flag is read before and after the
+  // counter, to know on which side of a reload the value is.
+  for (;;)
+    {
+      ticks = clock_ticks;
+      pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+      val = SysTick->VAL;
+      if (pending == (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+          && ticks == clock_ticks)
+        {
+          break;
+        }
+    }
+
+  uint32_t reload = SysTick->LOAD + 1u;
+  if (pending != 0u)
+    {
+      // Reloaded, but the interrupt was not yet taken.
+      ticks++;
+    }
+
+  return ticks * reload + (reload - 1u - val);
+}
+
+#else
+
+void OS_FAST_ISR
+clock_tick (void)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  uint32_t cycles = DWT->CYCCNT;
+  if (cycles < clock_cycles_last)
+    {
+      clock_cycles_high++;
+    }
+  clock_cycles_last = cycles;
+
+  __set_PRIMASK (primask);
+}
+
+uint64_t
+clock_now_cycles (void)
+{
+  uint32_t high;
+  uint32_t last;
+  uint32_t cycles;
+
+  // Retry if clock_tick() ran in between; the counter is read after
+  // the snapshot, so it is never behind it.
+  do
+    {
+      high = clock_cycles_high;
+      last = clock_cycles_last;
+      cycles = DWT->CYCCNT;
+    }
+  while (high != clock_cycles_high || last != clock_cycles_last);
+
+  return (((uint64_t) high << 32) | last) + (uint32_t) (cycles - last);
+}
+
+#endif // defined(OS_USE_CLOCK_SYSTICK)
+
+uint64_t
+clock_now_ns (void)
+{
+  return clock_ns_base + clock_cycles_to_ns (clock_now_cycles ()
+      - clock_cycles_base);
+}
+
+#if defined(USE_HAL_DRIVER) && defined(OS_USE_CLOCK_HAL_GETTICK)
+
+// Replaces the weak HAL definition, which returns the ticks counted
+// by HAL_IncTick(). Until clock_initialize() is called (by
+// timer_start(), after HAL_Init() and the clock configuration, which
+// already use the HAL timeouts), the HAL ticks are returned.
+uint32_t
+HAL_GetTick (void)
+{
+  if (clock_ns_mult == 0u)
+    {
+      return uwTick;
+    }
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  // Advance the milliseconds by the time since the last call, with
+  // a 32-bit division, since HAL_GetTick() is also called from
+  // interrupt handlers and the 64-bit division library code is slow;
+  // only after more than 4 seconds without calls are whole steps of
+  // 4 seconds added first.
+  uint64_t delta = clock_now_ns () - clock_ms_ns;
+  while (delta > 0xFFFFFFFFu)
+    {
+      clock_ms += 4000u;
+      clock_ms_ns += 4000000000u;
+      delta -= 4000000000u;
+    }
+  uint32_t ms = (uint32_t) delta / 1000000u;
+  clock_ms += ms;
+  clock_ms_ns += (uint64_t) ms * 1000000u;
+
+  uint32_t ret = clock_ms;
+
+  __set_PRIMASK (primask);
+  return ret;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
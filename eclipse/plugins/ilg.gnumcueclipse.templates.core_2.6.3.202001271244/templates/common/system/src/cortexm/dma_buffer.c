@@ -0,0 +1,265 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+#include "cmsis_device.h"
+#include "cortexm/DmaBuffer.h"
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// Defined in the linker script; weak, so older scripts without
+// the .dmabuffer section still link (the pool is then empty).
+extern unsigned int __dmabuffer_start__ __attribute__((weak));
+extern unsigned int __dmabuffer_pool__ __attribute__((weak));
+extern unsigned int __dmabuffer_end__ __attribute__((weak));
+
+// In .data, so it is valid right after the startup.
+static uint8_t* dma_buffer_next = (uint8_t*) &__dmabuffer_pool__;
+
+// ----------------------------------------------------------------------------
+
+int
+dma_buffer_init (void)
+{
+#if defined(__MPU_PRESENT) && (__MPU_PRESENT == 1U)
+  uint32_t start = (uint32_t) &__dmabuffer_start__;
+  uint32_t size = (uint32_t) &__dmabuffer_end__ - start;
+
+  // The MPU regions are powers of two, aligned to their size.
+  if (size < OS_INTEGER_DMA_BUFFER_ALIGNMENT || (size & (size - 1)) != 0
+      || (start & (size - 1)) != 0)
+    {
+      return -1;
+    }
+
+  uint32_t regions = (MPU->TYPE & MPU_TYPE_DREGION_Msk)
+      >> MPU_TYPE_DREGION_Pos;
+  if (regions <= OS_INTEGER_DMA_BUFFER_MPU_REGION)
+    {
+      return -1;
+    }
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  if ((SCB->CCR & SCB_CCR_DC_Msk) != 0)
+    {
+      // Lines cached before would no longer be looked up, and
+      // their eviction would overwrite the data written later.
+      SCB_CleanInvalidateDCache_by_Addr ((uint32_t*) start, (int32_t) size);
+    }
+#endif
+
+  __DMB ();
+  MPU->RNR = OS_INTEGER_DMA_BUFFER_MPU_REGION;
+  MPU->RBAR = start;
+  // Normal memory, non cacheable (TEX=1, C=0, B=0), not executable,
+  // full access; the SIZE field is log2(size) - 1.
+  MPU->RASR = MPU_RASR_XN_Msk | (3u << MPU_RASR_AP_Pos)
+      | (1u << MPU_RASR_TEX_Pos)
+      | ((uint32_t) (__builtin_ctz (size) - 1) << MPU_RASR_SIZE_Pos)
+      | MPU_RASR_ENABLE_Msk;
+  // The regions not covered keep the default memory map; the
+  // other bits (HFNMIENA) are preserved.
+  MPU->CTRL |= MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+  __DSB ();
+  __ISB ();
+
+  __set_PRIMASK (primask);
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+void*
+dma_buffer_alloc (size_t size)
+{
+  size = OS_DMA_BUFFER_SIZE(size);
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  uint8_t* p = dma_buffer_next;
+  if (size == 0 || (size_t) ((uint8_t*) &__dmabuffer_end__ - p) < size)
+    {
+      __set_PRIMASK (primask);
+      return NULL;
+    }
+  dma_buffer_next = p + size;
+
+  __set_PRIMASK (primask);
+  return p;
+}
+
+size_t
+dma_buffer_available (void)
+{
+  return (size_t) ((uint8_t*) &__dmabuffer_end__ - dma_buffer_next);
+}
+
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include "cortexm/Crc32.h"
+#include "diag/Bench.h"
+
+#include <string.h>
+
+#if OS_INTEGER_BENCH_WARMUP < 1
+#error "The D-cache benchmarks switch the cache in the warm-up runs"
+#endif
+
+// The same memcpy() and crc32_update() on 2 KB, with cacheable
+// buffers, with the D-cache on and off, and in .dmabuffer. The
+// *_dcache_off benchmarks are registered first; their first warm-up
+// run disables the D-cache and the first warm-up run of the next
+// ones enables it again, so the switch (a clean and invalidate of
+// the whole cache) is never measured.
+//
+// On the STM32F7 templates .bss is in the DTCM, which is never
+// cached, so with a D-cache the buffers are OS_CACHED_BSS, in the
+// AXI SRAM.
+//
+// The .dmabuffer ones are built only on the devices with a D-cache;
+// on the others they would measure the same as .bss, and the
+// OS_CACHED_BSS and OS_DMA_BUFFER variables need the multi-region
+// startup, which the templates of these devices do not use.
+
+#define DMA_BENCH_SIZE (2048)
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+
+static uint8_t dma_bench_src[DMA_BENCH_SIZE] OS_CACHED_BSS;
+static uint8_t dma_bench_dst[DMA_BENCH_SIZE] OS_CACHED_BSS;
+
+static uint8_t dma_bench_nc_src[DMA_BENCH_SIZE] OS_DMA_BUFFER;
+static uint8_t dma_bench_nc_dst[DMA_BENCH_SIZE] OS_DMA_BUFFER;
+
+// Set if the D-cache was disabled by a benchmark.
+static int dma_bench_dcache_disabled;
+
+static void
+dma_bench_dcache (int enable)
+{
+  if (enable)
+    {
+      if (dma_bench_dcache_disabled)
+        {
+          dma_bench_dcache_disabled = 0;
+          SCB_EnableDCache ();
+        }
+    }
+  else if ((SCB->CCR & SCB_CCR_DC_Msk) != 0)
+    {
+      dma_bench_dcache_disabled = 1;
+      SCB_DisableDCache ();
+    }
+}
+
+#else
+
+static uint8_t dma_bench_src[DMA_BENCH_SIZE]
+__attribute__((aligned(OS_INTEGER_DMA_BUFFER_ALIGNMENT)));
+static uint8_t dma_bench_dst[DMA_BENCH_SIZE]
+__attribute__((aligned(OS_INTEGER_DMA_BUFFER_ALIGNMENT)));
+
+static inline void
+__attribute__((always_inline))
+dma_bench_dcache (int enable __attribute__((unused)))
+{
+}
+
+#endif
+
+static void
+dma_bench_memcpy (void* arg)
+{
+  dma_bench_dcache (arg != NULL);
+  memcpy (dma_bench_dst, dma_bench_src, DMA_BENCH_SIZE);
+  BENCH_KEEP(dma_bench_dst);
+}
+
+static void
+dma_bench_crc (void* arg)
+{
+  dma_bench_dcache (arg != NULL);
+  BENCH_KEEP(crc32_update (0xFFFFFFFFu, dma_bench_src, DMA_BENCH_SIZE));
+}
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+
+static void
+dma_bench_memcpy_nc (void* arg __attribute__((unused)))
+{
+  dma_bench_dcache (1);
+  memcpy (dma_bench_nc_dst, dma_bench_nc_src, DMA_BENCH_SIZE);
+  BENCH_KEEP(dma_bench_nc_dst);
+}
+
+static void
+dma_bench_crc_nc (void* arg __attribute__((unused)))
+{
+  dma_bench_dcache (1);
+  BENCH_KEEP(crc32_update (0xFFFFFFFFu, dma_bench_nc_src, DMA_BENCH_SIZE));
+}
+
+#endif
+
+// The non NULL arg keeps the D-cache enabled.
+static bench_t dma_benches[] =
+  {
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    { "dcache_memcpy_2k_dcache_off", dma_bench_memcpy, NULL, NULL },
+    { "dcache_crc32_2k_dcache_off", dma_bench_crc, NULL, NULL },
+#endif
+    { "dcache_memcpy_2k", dma_bench_memcpy, (void*) dma_bench_src, NULL },
+    { "dcache_crc32_2k", dma_bench_crc, (void*) dma_bench_src, NULL },
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    { "dcache_memcpy_2k_dmabuffer", dma_bench_memcpy_nc, NULL, NULL },
+    { "dcache_crc32_2k_dmabuffer", dma_bench_crc_nc, NULL, NULL },
+#endif
+  };
+
+static void
+__attribute__((constructor))
+dma_bench_register (void)
+{
+  for (size_t i = 0; i < sizeof(dma_benches) / sizeof(dma_benches[0]); ++i)
+    {
+      bench_register (&dma_benches[i]);
+    }
+}
+
+#endif // defined(OS_USE_BENCH)
+
+// ----------------------------------------------------------------------------
@@ -154,6 +154,22 @@ dumpExceptionStack (ExceptionStackFrame* frame, uint32_t lr)
 
 #endif // defined(__ARM_ARCH_6M__)
 
+// Push out the buffered trace output before halting, otherwise
+// the last messages, including the exception dump, are lost.
+static void
+flushExceptionTrace (void)
+{
+#if defined(OS_USE_TRACE_SEMIHOSTING_BUFFERED) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+  // Without a debugger to service it, a BKPT in a fault handler
+  // locks up the core.
+  if ((CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) == 0)
+    {
+      return;
+    }
+#endif
+  trace_flush ();
+}
+
 #endif // defined(TRACE)
 
 // ----------------------------------------------------------------------------
@@ -397,6 +413,7 @@ HardFault_Handler_C (ExceptionStackFrame* frame __attribute__((unused)),
 #if defined(TRACE)
   trace_printf ("[HardFault]\n");
   dumpExceptionStack (frame, cfsr, mmfar, bfar, lr);
+  flushExceptionTrace ();
 #endif // defined(TRACE)
 
 #if defined(DEBUG)
@@ -452,6 +469,7 @@ HardFault_Handler_C (ExceptionStackFrame* frame __attribute__((unused)),
 #if defined(TRACE)
   trace_printf ("[HardFault]\n");
   dumpExceptionStack (frame, lr);
+  flushExceptionTrace ();
 #endif // defined(TRACE)
 
 #if defined(DEBUG)
@@ -507,6 +525,7 @@ BusFault_Handler_C (ExceptionStackFrame* frame __attribute__((unused)),
 
   trace_printf ("[BusFault]\n");
   dumpExceptionStack (frame, cfsr, mmfar, bfar, lr);
+  flushExceptionTrace ();
 #endif // defined(TRACE)
 
 #if defined(DEBUG)
@@ -561,6 +580,7 @@ UsageFault_Handler_C (ExceptionStackFrame* frame __attribute__((unused)),
 #if defined(TRACE)
   trace_printf ("[UsageFault]\n");
   dumpExceptionStack (frame, cfsr, mmfar, bfar, lr);
+  flushExceptionTrace ();
 #endif // defined(TRACE)
 
 #if defined(DEBUG)
@@ -0,0 +1,196 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_FAST_VECTORS)
+
+#include "cortexm/FastCode.h"
+#include "cmsis_device.h"
+
+#include <stddef.h>
+
+// ----------------------------------------------------------------------------
+
+#if defined(__ARM_ARCH_6M__) && (!defined(__VTOR_PRESENT) || (__VTOR_PRESENT == 0))
+#error "OS_USE_FAST_VECTORS requires a relocatable vector table"
+#endif
+
+#if (OS_INTEGER_FAST_VECTORS & (OS_INTEGER_FAST_VECTORS - 1)) != 0
+#error "OS_INTEGER_FAST_VECTORS must be a power of two"
+#endif
+
+// Provided by the linker script.
+extern unsigned int __vectors_start;
+extern unsigned int __vectors_end;
+
+// VTOR requires the table to be aligned to its size. Where the
+// DMA_BUFFER region alias is RAM (all but STM32F7), the section
+// follows .dmabuffer; when there are OS_DMA_BUFFER variables, the
+// alignment may leave a gap of up to the table size less 32 bytes.
+static fast_vectors_handler_t fast_vectors[OS_INTEGER_FAST_VECTORS]
+__attribute__((section(".fastvectors"),
+    aligned(OS_INTEGER_FAST_VECTORS * 4)));
+
+// ----------------------------------------------------------------------------
+
+int
+fast_vectors_relocate (void)
+{
+  fast_vectors_handler_t* flash = (fast_vectors_handler_t*) &__vectors_start;
+  size_t count = (size_t) (&__vectors_end - &__vectors_start);
+  if (count > OS_INTEGER_FAST_VECTORS)
+    {
+      return -1;
+    }
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      fast_vectors[i] = flash[i];
+    }
+
+  __DSB ();
+  SCB->VTOR = (uint32_t) fast_vectors;
+  __DSB ();
+  __ISB ();
+
+  __set_PRIMASK (primask);
+  return 0;
+}
+
+fast_vectors_handler_t
+fast_vectors_set_handler (int irq, fast_vectors_handler_t handler)
+{
+  int index = irq + 16;
+  if (index < 0 || index >= OS_INTEGER_FAST_VECTORS)
+    {
+      return NULL;
+    }
+
+  fast_vectors_handler_t previous = fast_vectors[index];
+  fast_vectors[index] = handler;
+  __DSB ();
+
+  return previous;
+}
+
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include "diag/Bench.h"
+
+// The same handler, linked in flash and in FAST_CODE, is installed
+// for PendSV (not used by the templates) and triggered by software;
+// the cycles include the entry, the body and the return. The call
+// benchmarks run the same body as a plain function, without the
+// interrupt.
+
+static volatile uint32_t fast_bench_value = 1u;
+
+static inline void
+__attribute__((always_inline))
+fast_bench_body (void)
+{
+  // A short loop with branches, as in a typical driver handler.
+  uint32_t value = fast_bench_value;
+  for (unsigned int i = 0; i < 8; ++i)
+    {
+      value = (value & 1u) ? (value >> 1) ^ 0xEDB88320u : (value >> 1);
+    }
+  fast_bench_value = value;
+}
+
+static void
+__attribute__((noinline))
+fast_bench_flash_handler (void)
+{
+  fast_bench_body ();
+}
+
+static void OS_FAST_CODE
+fast_bench_ram_handler (void)
+{
+  fast_bench_body ();
+}
+
+static void
+fast_bench_isr (void* arg)
+{
+  if (SCB->VTOR != (uint32_t) fast_vectors)
+    {
+      // Not relocated, or replaced by irq_stats_start().
+      return;
+    }
+
+  fast_vectors_handler_t previous = fast_vectors_set_handler (
+      PendSV_IRQn, (fast_vectors_handler_t) arg);
+
+  // The benchmarks run with the interrupts disabled; open a window
+  // for the pending PendSV to be taken.
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  __enable_irq ();
+  __ISB ();
+  __disable_irq ();
+
+  fast_vectors_set_handler (PendSV_IRQn, previous);
+}
+
+static void
+fast_bench_call (void* arg)
+{
+  ((fast_vectors_handler_t) arg) ();
+}
+
+static bench_t fast_benches[] =
+  {
+    { "fast_isr_flash", fast_bench_isr, (void*) fast_bench_flash_handler,
+    NULL },
+    { "fast_isr_ram", fast_bench_isr, (void*) fast_bench_ram_handler, NULL },
+    { "fast_call_flash", fast_bench_call, (void*) fast_bench_flash_handler,
+    NULL },
+    { "fast_call_ram", fast_bench_call, (void*) fast_bench_ram_handler, NULL },
+  };
+
+static void
+__attribute__((constructor))
+fast_bench_register (void)
+{
+  for (size_t i = 0; i < sizeof(fast_benches) / sizeof(fast_benches[0]); ++i)
+    {
+      bench_register (&fast_benches[i]);
+    }
+}
+
+#endif // defined(OS_USE_BENCH)
+
+// ----------------------------------------------------------------------------
+
+#endif // defined(OS_USE_FAST_VECTORS)
@@ -0,0 +1,288 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_IRQ_STATS)
+
+#include "cortexm/IrqStats.h"
+#include "cmsis_device.h"
+#include "diag/Trace.h"
+
+#include <string.h>
+
+// ----------------------------------------------------------------------------
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define IRQ_STATS_USE_DWT
+#elif !defined(__VTOR_PRESENT) || (__VTOR_PRESENT == 0)
+#error "OS_USE_IRQ_STATS requires a relocatable vector table"
+#endif
+
+// The first exception handled by the dispatcher.
+#define IRQ_STATS_FIRST (16 + SysTick_IRQn)
+
+typedef void
+(*irq_stats_handler_t) (void);
+
+// Provided by the linker script.
+extern unsigned int __vectors_start;
+extern unsigned int __vectors_end;
+
+// VTOR requires the table to be aligned to its size.
+static irq_stats_handler_t irq_stats_vectors[OS_INTEGER_IRQ_STATS_VECTORS]
+__attribute__((aligned(OS_INTEGER_IRQ_STATS_VECTORS * 4)));
+
+static irq_stats_handler_t irq_stats_handlers[OS_INTEGER_IRQ_STATS_VECTORS];
+static irq_stats_probe_t irq_stats_probes[OS_INTEGER_IRQ_STATS_VECTORS];
+static irq_stats_t irq_stats[OS_INTEGER_IRQ_STATS_VECTORS];
+
+// The cycles spent in the handlers nested in the current one.
+static uint32_t irq_stats_nested;
+
+static uint32_t irq_stats_saved_vtor;
+
+// ----------------------------------------------------------------------------
+
+static inline uint32_t
+__attribute__((always_inline))
+irq_stats_read_cycles (void)
+{
+#if defined(IRQ_STATS_USE_DWT)
+  return DWT->CYCCNT;
+#else
+  return SysTick->VAL;
+#endif
+}
+
+static inline uint32_t
+__attribute__((always_inline))
+irq_stats_elapsed (uint32_t begin, uint32_t end)
+{
+#if defined(IRQ_STATS_USE_DWT)
+  return end - begin;
+#else
+  // SysTick counts down, from LOAD to 0.
+  return (begin >= end) ? begin - end : begin + SysTick->LOAD + 1u - end;
+#endif
+}
+
+static uint32_t
+irq_stats_systick_probe (void)
+{
+  // The interrupt is requested when the counter reloads.
+  return SysTick->LOAD - SysTick->VAL;
+}
+
+static void
+irq_stats_dispatch (void)
+{
+  uint32_t begin = irq_stats_read_cycles ();
+  uint32_t exception = __get_IPSR () & 0x1FFu;
+
+  irq_stats_probe_t probe = irq_stats_probes[exception];
+  uint32_t latency = (probe != NULL) ? probe () : 0;
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+  uint32_t outer = irq_stats_nested;
+  irq_stats_nested = 0;
+  __set_PRIMASK (primask);
+
+  irq_stats_handlers[exception] ();
+
+  __disable_irq ();
+  uint32_t elapsed = irq_stats_elapsed (begin, irq_stats_read_cycles ());
+  uint32_t cycles = elapsed - irq_stats_nested;
+  irq_stats_nested = outer + elapsed;
+
+  irq_stats_t* stats = &irq_stats[exception];
+  stats->count++;
+  stats->total_cycles += cycles;
+  if (cycles > stats->max_cycles)
+    {
+      stats->max_cycles = cycles;
+    }
+  if (probe != NULL)
+    {
+      unsigned int bucket = 0;
+      for (latency >>= 5;
+          latency != 0 && bucket < OS_INTEGER_IRQ_STATS_BUCKETS - 1;
+          latency >>= 1)
+        {
+          ++bucket;
+        }
+      stats->latency[bucket]++;
+    }
+  __set_PRIMASK (primask);
+}
+
+static int
+irq_stats_index (int irq)
+{
+  int index = irq + 16;
+  if (index < IRQ_STATS_FIRST || index >= OS_INTEGER_IRQ_STATS_VECTORS)
+    {
+      return -1;
+    }
+  return index;
+}
+
+// ----------------------------------------------------------------------------
+
+int
+irq_stats_start (void)
+{
+  // Start from the active table, which may have been relocated.
+  irq_stats_handler_t* active = (irq_stats_handler_t*) SCB->VTOR;
+  size_t count = (size_t) (&__vectors_end - &__vectors_start);
+  if (count > OS_INTEGER_IRQ_STATS_VECTORS)
+    {
+      return -1;
+    }
+
+#if defined(IRQ_STATS_USE_DWT)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if (__CORTEX_M == 0x07U)
+  // Unlock the DWT registers.
+  DWT->LAR = 0xC5ACCE55;
+#endif
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  if (SCB->VTOR == (uint32_t) irq_stats_vectors)
+    {
+      // Already started.
+      __set_PRIMASK (primask);
+      return 0;
+    }
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      irq_stats_vectors[i] = active[i];
+      if (i >= IRQ_STATS_FIRST)
+        {
+          irq_stats_handlers[i] = active[i];
+          irq_stats_vectors[i] = irq_stats_dispatch;
+        }
+    }
+  if (irq_stats_probes[IRQ_STATS_FIRST] == NULL)
+    {
+      irq_stats_probes[IRQ_STATS_FIRST] = irq_stats_systick_probe;
+    }
+
+  irq_stats_saved_vtor = SCB->VTOR;
+  __DSB ();
+  SCB->VTOR = (uint32_t) irq_stats_vectors;
+  __DSB ();
+  __ISB ();
+
+  __set_PRIMASK (primask);
+  return 0;
+}
+
+void
+irq_stats_stop (void)
+{
+  if (SCB->VTOR == (uint32_t) irq_stats_vectors)
+    {
+      SCB->VTOR = irq_stats_saved_vtor;
+      __DSB ();
+      __ISB ();
+    }
+}
+
+void
+irq_stats_reset (void)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  memset (irq_stats, 0, sizeof(irq_stats));
+
+  __set_PRIMASK (primask);
+}
+
+void
+irq_stats_get (int irq, irq_stats_t* stats)
+{
+  int index = irq_stats_index (irq);
+  if (index < 0)
+    {
+      memset (stats, 0, sizeof(*stats));
+      return;
+    }
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  *stats = irq_stats[index];
+
+  __set_PRIMASK (primask);
+}
+
+void
+irq_stats_set_probe (int irq, irq_stats_probe_t probe)
+{
+  int index = irq_stats_index (irq);
+  if (index >= 0)
+    {
+      irq_stats_probes[index] = probe;
+    }
+}
+
+void
+irq_stats_dump (void)
+{
+  trace_printf ("# irq,count,avg,max,latency...\n");
+  for (int irq = IRQ_STATS_FIRST - 16; irq < OS_INTEGER_IRQ_STATS_VECTORS - 16;
+      ++irq)
+    {
+      irq_stats_t stats;
+      irq_stats_get (irq, &stats);
+      if (stats.count == 0)
+        {
+          continue;
+        }
+
+      trace_printf ("irq,%d,%u,%u,%u", irq, (unsigned int) stats.count,
+                    (unsigned int) (stats.total_cycles / stats.count),
+                    (unsigned int) stats.max_cycles);
+      for (int i = 0; i < OS_INTEGER_IRQ_STATS_BUCKETS; ++i)
+        {
+          trace_printf (",%u", (unsigned int) stats.latency[i]);
+        }
+      trace_printf ("\n");
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // defined(OS_USE_IRQ_STATS)
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+#include "cmsis_device.h"
+#include "cortexm/LazyBss.h"
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// The .lazybss section always uses the first entry.
+#if !defined(OS_INTEGER_LAZY_BSS_MAX_REGIONS)
+#define OS_INTEGER_LAZY_BSS_MAX_REGIONS (4)
+#endif
+
+// The regions are cleared in chunks of this size, with the interrupts
+// disabled, so an interrupt handler calling lazy_bss_ensure() never
+// sees a partly cleared chunk.
+#if !defined(OS_INTEGER_LAZY_BSS_CHUNK_SIZE)
+#define OS_INTEGER_LAZY_BSS_CHUNK_SIZE (256)
+#endif
+
+// Defined in the linker script; weak, so older scripts without
+// the .lazybss section still link (the region is then empty).
+extern unsigned int __lazybss_start__ __attribute__((weak));
+extern unsigned int __lazybss_end__ __attribute__((weak));
+
+typedef struct
+{
+  uint8_t* cleared; // everything below was cleared
+  uint8_t* end;
+} lazy_bss_region_t;
+
+// In .data, so it is valid right after the startup.
+static lazy_bss_region_t lazy_bss_regions[OS_INTEGER_LAZY_BSS_MAX_REGIONS] =
+  {
+    { (uint8_t*) &__lazybss_start__, (uint8_t*) &__lazybss_end__ } };
+
+// ----------------------------------------------------------------------------
+
+// Clear from the region watermark up to limit, chunk by chunk.
+static void
+_lazy_bss_clear_region (lazy_bss_region_t* r, uint8_t* limit)
+{
+  for (;;)
+    {
+      uint32_t primask = __get_PRIMASK ();
+      __disable_irq ();
+
+      uint8_t* p = r->cleared;
+      if (p >= limit)
+        {
+          __set_PRIMASK (primask);
+          return;
+        }
+
+      uint8_t* chunk_end = p + OS_INTEGER_LAZY_BSS_CHUNK_SIZE;
+      if (chunk_end > limit)
+        {
+          chunk_end = limit;
+        }
+
+      // Word by word while possible; the section is word aligned,
+      // but the registered regions might not be.
+      for (; p < chunk_end && ((uintptr_t) p & 3) != 0; ++p)
+        {
+          *p = 0;
+        }
+      for (; p + 4 <= chunk_end; p += 4)
+        {
+          *(uint32_t*) p = 0;
+        }
+      for (; p < chunk_end; ++p)
+        {
+          *p = 0;
+        }
+      r->cleared = chunk_end;
+
+      __set_PRIMASK (primask);
+    }
+}
+
+int
+lazy_bss_register (void* begin, size_t size)
+{
+  int ret = -1;
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  for (int i = 1; i < OS_INTEGER_LAZY_BSS_MAX_REGIONS; ++i)
+    {
+      lazy_bss_region_t* r = &lazy_bss_regions[i];
+      if (r->cleared == r->end)
+        {
+          // Free, or completely cleared.
+          r->cleared = (uint8_t*) begin;
+          r->end = (uint8_t*) begin + size;
+          ret = 0;
+          break;
+        }
+    }
+
+  __set_PRIMASK (primask);
+  return ret;
+}
+
+size_t
+lazy_bss_clear (size_t max_bytes)
+{
+  size_t pending = 0;
+
+  for (int i = 0; i < OS_INTEGER_LAZY_BSS_MAX_REGIONS; ++i)
+    {
+      lazy_bss_region_t* r = &lazy_bss_regions[i];
+      size_t left = (size_t) (r->end - r->cleared);
+      if (left > max_bytes)
+        {
+          left = max_bytes;
+        }
+      if (left > 0)
+        {
+          _lazy_bss_clear_region (r, r->cleared + left);
+          max_bytes -= left;
+        }
+      pending += (size_t) (r->end - r->cleared);
+    }
+
+  return pending;
+}
+
+void
+lazy_bss_ensure (void* begin, size_t size)
+{
+  uint8_t* b = (uint8_t*) begin;
+  uint8_t* e = b + size;
+
+  for (int i = 0; i < OS_INTEGER_LAZY_BSS_MAX_REGIONS; ++i)
+    {
+      lazy_bss_region_t* r = &lazy_bss_regions[i];
+      if (b < r->end && e > r->cleared)
+        {
+          // Clear everything up to the end of the range.
+          _lazy_bss_clear_region (r, (e < r->end) ? e : r->end);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
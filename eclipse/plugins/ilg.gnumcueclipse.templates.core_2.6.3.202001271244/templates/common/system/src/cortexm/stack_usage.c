@@ -0,0 +1,188 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_STACK_USAGE)
+
+#include "cortexm/StackUsage.h"
+#include "cortexm/ExceptionHandlers.h"
+#include "cmsis_device.h"
+#include "diag/Trace.h"
+
+// ----------------------------------------------------------------------------
+
+// Defined in the linker script.
+extern unsigned int __Main_Stack_Limit;
+extern unsigned int __stack;
+
+// In .data, so the main stack is valid right after the startup.
+static stack_usage_t stack_usage_stacks[OS_INTEGER_STACK_USAGE_MAX_STACKS] =
+  {
+    { "main", (uint32_t*) &__Main_Stack_Limit, (uint32_t*) &__stack,
+        (uint32_t*) &__stack, (uint32_t*) &__stack } };
+
+static int stack_usage_count = 1;
+
+// ----------------------------------------------------------------------------
+
+// Return the stack with the lowest top above sp, or NULL; the
+// main stack is not searched.
+static stack_usage_t*
+_stack_usage_find_process (uint32_t* sp)
+{
+  stack_usage_t* found = NULL;
+  for (int i = 1; i < stack_usage_count; ++i)
+    {
+      stack_usage_t* s = &stack_usage_stacks[i];
+      if (sp < s->top && (found == NULL || s->top < found->top))
+        {
+          found = s;
+        }
+    }
+  return found;
+}
+
+static void
+_stack_usage_sample (stack_usage_t* s, uint32_t* sp)
+{
+  if (sp < s->lowest_sp)
+    {
+      s->lowest_sp = sp;
+      if (sp < s->bottom)
+        {
+          stack_usage_overflow (s, (uint32_t) sp);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void
+stack_usage_paint (void* bottom, size_t size)
+{
+  uint32_t* p = (uint32_t*) bottom;
+  uint32_t* end = p + size / 4;
+  while (p < end)
+    {
+      *p++ = STACK_USAGE_PAINT;
+    }
+}
+
+int
+stack_usage_register (const char* name, void* bottom, size_t size)
+{
+  int ret = -1;
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  if (stack_usage_count < OS_INTEGER_STACK_USAGE_MAX_STACKS)
+    {
+      stack_usage_t* s = &stack_usage_stacks[stack_usage_count];
+      s->name = name;
+      s->bottom = (uint32_t*) bottom;
+      s->top = s->bottom + size / 4;
+      s->high_water = s->top;
+      s->lowest_sp = s->top;
+      ret = stack_usage_count++;
+    }
+
+  __set_PRIMASK (primask);
+  return ret;
+}
+
+size_t
+stack_usage_high_water (int index)
+{
+  if (index < 0 || index >= stack_usage_count)
+    {
+      return 0;
+    }
+
+  // The words above the previous mark were already found modified,
+  // so only the part below it is scanned.
+  stack_usage_t* s = &stack_usage_stacks[index];
+  uint32_t* p = s->bottom;
+  uint32_t* mark = s->high_water;
+  while (p < mark && *p == STACK_USAGE_PAINT)
+    {
+      ++p;
+    }
+  s->high_water = p;
+
+  return (size_t) (s->top - p) * 4;
+}
+
+void
+stack_usage_tick (void)
+{
+  // In a handler, the main stack includes the exception frame.
+  _stack_usage_sample (&stack_usage_stacks[0], (uint32_t*) __get_MSP ());
+
+  uint32_t* psp = (uint32_t*) __get_PSP ();
+  stack_usage_t* s = _stack_usage_find_process (psp);
+  if (s != NULL)
+    {
+      _stack_usage_sample (s, psp);
+    }
+}
+
+void
+__attribute__((weak))
+stack_usage_overflow (const stack_usage_t* stack, uint32_t sp)
+{
+  static int reported;
+  if (!reported)
+    {
+      reported = 1;
+      trace_printf ("Stack '%s' overflow, sp=%p, bottom=%p\n", stack->name,
+                    (void*) sp, stack->bottom);
+#if defined(DEBUG)
+      __DEBUG_BKPT();
+#endif
+    }
+}
+
+void
+stack_usage_dump (void)
+{
+  trace_printf ("# stack,size,used,sampled\n");
+  for (int i = 0; i < stack_usage_count; ++i)
+    {
+      stack_usage_t* s = &stack_usage_stacks[i];
+      size_t used = stack_usage_high_water (i);
+      trace_printf ("stack,%s,%u,%u,%u\n", s->name,
+                    (unsigned int) ((s->top - s->bottom) * 4),
+                    (unsigned int) used,
+                    (unsigned int) ((s->top - s->lowest_sp) * 4));
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // defined(OS_USE_STACK_USAGE)
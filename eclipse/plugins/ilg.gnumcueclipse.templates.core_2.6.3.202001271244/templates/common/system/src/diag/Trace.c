@@ -34,12 +34,32 @@
 #include "diag/Trace.h"
 #include "string.h"
 
+// By default trace_printf() uses a small local formatter, which
+// supports only integers, characters, strings and pointers, but is
+// reentrant, does not allocate memory and needs only a small stack.
+// Define OS_USE_TRACE_PRINTF_NEWLIB to use the full newlib vsnprintf()
+// (for example for floating point values).
+
+#if defined(OS_USE_TRACE_PRINTF_NEWLIB)
+
 #ifndef OS_INTEGER_TRACE_PRINTF_TMP_ARRAY_SIZE
 #define OS_INTEGER_TRACE_PRINTF_TMP_ARRAY_SIZE (128)
 #endif
 
+#else
+
+// The formatted output is passed to trace_write() in chunks
+// of this size; the buffer is allocated on the stack.
+#ifndef OS_INTEGER_TRACE_PRINTF_CHUNK_SIZE
+#define OS_INTEGER_TRACE_PRINTF_CHUNK_SIZE (32)
+#endif
+
+#endif // defined(OS_USE_TRACE_PRINTF_NEWLIB)
+
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_TRACE_PRINTF_NEWLIB)
+
 int
 trace_printf(const char* format, ...)
 {
@@ -48,8 +68,6 @@ trace_printf(const char* format, ...)
 
   va_start (ap, format);
 
-  // TODO: rewrite it to no longer use newlib, it is way too heavy
-
   static char buf[OS_INTEGER_TRACE_PRINTF_TMP_ARRAY_SIZE];
 
   // Print to the local buffer
@@ -64,6 +82,315 @@ trace_printf(const char* format, ...)
   return ret;
 }
 
+#else
+
+// The local formatter supports:
+// - the conversions %d, %i, %u, %x, %X, %o, %c, %s, %p and %%
+// - the flags '-' (left justify), '0' (zero padding), '#', '+' and ' '
+// - the field width (including '*') and the precision (minimum number
+//   of digits, or maximum number of characters for strings)
+// - the length modifiers hh, h, l, z, t and j; ll is consumed, but
+//   only the low 32-bits are printed, to avoid the 64-bit division
+//   library code.
+
+typedef struct
+{
+  char buf[OS_INTEGER_TRACE_PRINTF_CHUNK_SIZE];
+  size_t len;
+  int count;
+} trace_printf_out_t;
+
+static void
+_trace_printf_flush (trace_printf_out_t* out)
+{
+  if (out->len > 0)
+    {
+      trace_write (out->buf, out->len);
+      out->len = 0;
+    }
+}
+
+static void
+_trace_printf_putc (trace_printf_out_t* out, char c)
+{
+  if (out->len == sizeof(out->buf))
+    {
+      _trace_printf_flush (out);
+    }
+  out->buf[out->len++] = c;
+  out->count++;
+}
+
+static void
+_trace_printf_pad (trace_printf_out_t* out, char c, int n)
+{
+  for (; n > 0; --n)
+    {
+      _trace_printf_putc (out, c);
+    }
+}
+
+static void
+_trace_printf_field (trace_printf_out_t* out, const char* prefix,
+                     const char* s, int len, int zeros, int width,
+                     int left)
+{
+  int plen = (int) strlen (prefix);
+  int pad = width - plen - zeros - len;
+
+  if (!left)
+    {
+      _trace_printf_pad (out, ' ', pad);
+    }
+  while (*prefix != '\0')
+    {
+      _trace_printf_putc (out, *prefix++);
+    }
+  _trace_printf_pad (out, '0', zeros);
+  for (int i = 0; i < len; ++i)
+    {
+      _trace_printf_putc (out, s[i]);
+    }
+  if (left)
+    {
+      _trace_printf_pad (out, ' ', pad);
+    }
+}
+
+static int
+_trace_vprintf (const char* format, va_list ap)
+{
+  trace_printf_out_t out;
+  out.len = 0;
+  out.count = 0;
+
+  for (const char* p = format; *p != '\0'; ++p)
+    {
+      if (*p != '%')
+        {
+          _trace_printf_putc (&out, *p);
+          continue;
+        }
+
+      // Flags.
+      int left = 0;
+      int zero = 0;
+      int alt = 0;
+      char sign = '\0';
+      for (;; ++p)
+        {
+          if (p[1] == '-')
+            left = 1;
+          else if (p[1] == '0')
+            zero = 1;
+          else if (p[1] == '#')
+            alt = 1;
+          else if (p[1] == '+')
+            sign = '+';
+          else if (p[1] == ' ')
+            sign = (sign == '+') ? '+' : ' ';
+          else
+            break;
+        }
+      ++p;
+
+      // Width.
+      int width = 0;
+      if (*p == '*')
+        {
+          width = va_arg(ap, int);
+          if (width < 0)
+            {
+              left = 1;
+              width = -width;
+            }
+          ++p;
+        }
+      for (; *p >= '0' && *p <= '9'; ++p)
+        {
+          width = width * 10 + (*p - '0');
+        }
+
+      // Precision.
+      int precision = -1;
+      if (*p == '.')
+        {
+          ++p;
+          precision = 0;
+          if (*p == '*')
+            {
+              precision = va_arg(ap, int);
+              ++p;
+            }
+          for (; *p >= '0' && *p <= '9'; ++p)
+            {
+              precision = precision * 10 + (*p - '0');
+            }
+        }
+
+      // Length modifiers.
+      int longs = 0;
+      for (;; ++p)
+        {
+          if (*p == 'l')
+            longs++;
+          else if (*p != 'h' && *p != 'z' && *p != 't' && *p != 'j')
+            break;
+        }
+
+      char digits[12];
+      unsigned long value;
+      unsigned int base = 10;
+      const char* prefix = "";
+      int upper = 0;
+
+      switch (*p)
+        {
+        case '%':
+          _trace_printf_putc (&out, '%');
+          continue;
+
+        case 'c':
+          digits[0] = (char) va_arg(ap, int);
+          _trace_printf_field (&out, "", digits, 1, 0, width, left);
+          continue;
+
+        case 's':
+          {
+            const char* s = va_arg(ap, const char*);
+            if (s == NULL)
+              {
+                s = "(null)";
+              }
+            int len = 0;
+            while (s[len] != '\0' && (precision < 0 || len < precision))
+              {
+                ++len;
+              }
+            _trace_printf_field (&out, "", s, len, 0, width, left);
+          }
+          continue;
+
+        case 'p':
+          value = (unsigned long) va_arg(ap, void*);
+          base = 16;
+          prefix = "0x";
+          break;
+
+        case 'd':
+        case 'i':
+          {
+            long v;
+            if (longs >= 2)
+              v = (long) va_arg(ap, long long);
+            else if (longs == 1)
+              v = va_arg(ap, long);
+            else
+              v = va_arg(ap, int);
+            if (v < 0)
+              {
+                prefix = "-";
+                value = -(unsigned long) v;
+              }
+            else
+              {
+                prefix = (sign == '+') ? "+" : ((sign == ' ') ? " " : "");
+                value = (unsigned long) v;
+              }
+          }
+          break;
+
+        case 'X':
+          upper = 1;
+          // Fall through.
+        case 'x':
+        case 'o':
+        case 'u':
+          if (longs >= 2)
+            value = (unsigned long) va_arg(ap, unsigned long long);
+          else if (longs == 1)
+            value = va_arg(ap, unsigned long);
+          else
+            value = va_arg(ap, unsigned int);
+          if (*p == 'o')
+            {
+              base = 8;
+              prefix = (alt && (value != 0 || precision == 0)) ? "0" : "";
+            }
+          else if (*p != 'u')
+            {
+              base = 16;
+              prefix = (alt && value != 0) ? (upper ? "0X" : "0x") : "";
+            }
+          break;
+
+        default:
+          // Unknown conversion; print it as is.
+          _trace_printf_putc (&out, '%');
+          if (*p == '\0')
+            {
+              --p;
+            }
+          else
+            {
+              _trace_printf_putc (&out, *p);
+            }
+          continue;
+        }
+
+      // Convert the number, last digit first; with a precision of 0,
+      // the value 0 is printed as no digits at all.
+      int len = 0;
+      char* d = digits + sizeof(digits);
+      if (value != 0 || precision != 0)
+        {
+          do
+            {
+              unsigned int r = (unsigned int) (value % base);
+              *--d = (char) ((r < 10) ?
+                  ('0' + r) : ((upper ? 'A' : 'a') + r - 10));
+              ++len;
+              value /= base;
+            }
+          while (value != 0);
+        }
+
+      int zeros = 0;
+      if (precision >= 0)
+        {
+          zeros = precision - len;
+        }
+      else if (zero && !left)
+        {
+          zeros = width - len - (int) strlen (prefix);
+        }
+      if (zeros < 0)
+        {
+          zeros = 0;
+        }
+
+      _trace_printf_field (&out, prefix, d, len, zeros, width, left);
+    }
+
+  _trace_printf_flush (&out);
+  return out.count;
+}
+
+int
+trace_printf(const char* format, ...)
+{
+  int ret;
+  va_list ap;
+
+  va_start (ap, format);
+  ret = _trace_vprintf (format, ap);
+  va_end (ap);
+
+  return ret;
+}
+
+#endif // defined(OS_USE_TRACE_PRINTF_NEWLIB)
+
 int
 trace_puts(const char *s)
 {
@@ -95,4 +422,132 @@ trace_dump_args(int argc, char* argv[])
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include "diag/Bench.h"
+
+// The same line printed with trace_printf() and with the newlib
+// vsnprintf() followed by trace_write(), as with
+// OS_USE_TRACE_PRINTF_NEWLIB (then both are the same). The times
+// include the output, so compare them on a fast channel (ITM); the
+// semihosting calls take much longer than the formatting.
+//
+// With OS_USE_STACK_USAGE, the first warm-up run measures the main
+// stack used by the call instead, reported as "stack" in bytes: the
+// free part of the stack is painted before and scanned after, with
+// the interrupts disabled.
+
+#if OS_INTEGER_BENCH_WARMUP < 1
+#error "The trace benchmarks measure the stack in the first warm-up run"
+#endif
+
+#define TRACE_BENCH_FORMAT "# trace,%s,%5d,0x%08x,%c\n"
+#define TRACE_BENCH_ARGS "bench", -1234, 0xCAFEu, '!'
+
+static int
+trace_bench_newlib_printf (const char* format, ...)
+{
+  int ret;
+  va_list ap;
+
+  va_start (ap, format);
+
+  static char buf[128];
+
+  ret = vsnprintf (buf, sizeof(buf), format, ap);
+  if (ret > 0)
+    {
+      ret = trace_write (buf, (size_t)ret);
+    }
+
+  va_end (ap);
+  return ret;
+}
+
+static void
+trace_bench_printf (void)
+{
+  trace_printf (TRACE_BENCH_FORMAT, TRACE_BENCH_ARGS);
+}
+
+static void
+trace_bench_vsnprintf (void)
+{
+  trace_bench_newlib_printf (TRACE_BENCH_FORMAT, TRACE_BENCH_ARGS);
+}
+
+#if defined(OS_USE_STACK_USAGE)
+
+#include "cortexm/StackUsage.h"
+#include "cmsis_device.h"
+
+// The bottom of the main stack; defined in linker script.
+extern unsigned int __Main_Stack_Limit;
+
+// Return the bytes of main stack used by the function.
+static uint32_t
+__attribute__((noinline))
+trace_bench_stack (void
+(*function) (void))
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  // Remember the deepest use so far, the paint would hide it.
+  stack_usage_high_water (0);
+
+  // The benchmarks run on the main stack; leave some room for
+  // the frame of stack_usage_paint().
+  uint32_t* sp = (uint32_t*) __get_MSP ();
+  uint32_t* bottom = (uint32_t*) &__Main_Stack_Limit;
+  stack_usage_paint (bottom, (size_t) (sp - 16 - bottom) * 4);
+
+  function ();
+
+  uint32_t* p = bottom;
+  while (p < sp && *p == STACK_USAGE_PAINT)
+    {
+      ++p;
+    }
+
+  __set_PRIMASK (primask);
+  return (uint32_t) (sp - p) * 4;
+}
+
+#endif // defined(OS_USE_STACK_USAGE)
+
+static void
+trace_bench_run (void
+(*function) (void), uint32_t* stack __attribute__((unused)))
+{
+#if defined(OS_USE_STACK_USAGE)
+  if (*stack == 0)
+    {
+      *stack = trace_bench_stack (function);
+      return;
+    }
+  bench_report ("stack", *stack);
+#endif
+  function ();
+}
+
+static uint32_t trace_bench_printf_stack;
+static uint32_t trace_bench_vsnprintf_stack;
+
+BENCH(trace_printf)
+{
+  trace_bench_run (trace_bench_printf, &trace_bench_printf_stack);
+}
+
+BENCH(trace_printf_vsnprintf)
+{
+  trace_bench_run (trace_bench_vsnprintf, &trace_bench_vsnprintf_stack);
+}
+
+#endif // defined(OS_USE_BENCH)
+
+// ----------------------------------------------------------------------------
+
 #endif // TRACE
@@ -41,6 +41,17 @@
 //#define OS_USE_TRACE_SEMIHOSTING_DEBUG
 //#define OS_USE_TRACE_SEMIHOSTING_STDOUT
 
+// Optionally, the ITM output can be deferred via a RAM ring buffer
+// (see below).
+
+//#define OS_USE_TRACE_ITM_DEFERRED
+//#define OS_USE_TRACE_ITM_DEFERRED_PENDSV
+
+// Optionally, the semihosting output can be collected in a RAM buffer
+// and sent with a single host call per line (see below).
+
+//#define OS_USE_TRACE_SEMIHOSTING_BUFFERED
+
 #if !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
 #if defined(OS_USE_TRACE_ITM)
 #undef OS_USE_TRACE_ITM
@@ -48,6 +59,19 @@
 #endif // defined(OS_USE_TRACE_ITM)
 #endif // !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
 
+#if defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV) && !defined(OS_USE_TRACE_ITM_DEFERRED)
+#define OS_USE_TRACE_ITM_DEFERRED
+#endif
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED) && !defined(OS_USE_TRACE_ITM)
+#undef OS_USE_TRACE_ITM_DEFERRED
+#undef OS_USE_TRACE_ITM_DEFERRED_PENDSV
+#endif
+
+#if defined(OS_USE_TRACE_SEMIHOSTING_BUFFERED) && !(defined(OS_USE_TRACE_SEMIHOSTING_STDOUT) || defined(OS_USE_TRACE_SEMIHOSTING_DEBUG))
+#undef OS_USE_TRACE_SEMIHOSTING_BUFFERED
+#endif
+
 #if defined(OS_DEBUG_SEMIHOSTING_FAULTS)
 #if defined(OS_USE_TRACE_SEMIHOSTING_STDOUT) || defined(OS_USE_TRACE_SEMIHOSTING_DEBUG)
 #error "Cannot debug semihosting using semihosting trace; use OS_USE_TRACE_ITM"
@@ -60,7 +84,18 @@
 
 #if defined(OS_USE_TRACE_ITM)
 static ssize_t
-_trace_write_itm (const char* buf, size_t nbyte);
+_trace_write_itm (unsigned int port, const char* buf, size_t nbyte);
+
+static unsigned int
+_trace_channel_port (trace_channel_t channel);
+#endif
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED)
+static ssize_t
+_trace_write_itm_deferred (const char* buf, size_t nbyte);
+
+static void
+_trace_flush_itm_deferred (int wait);
 #endif
 
 #if defined(OS_USE_TRACE_SEMIHOSTING_STDOUT)
@@ -73,12 +108,26 @@ static ssize_t
 _trace_write_semihosting_debug(const char* buf, size_t nbyte);
 #endif
 
+#if defined(OS_USE_TRACE_SEMIHOSTING_BUFFERED)
+static ssize_t
+_trace_write_semihosting_buffered (const char* buf, size_t nbyte);
+
+static void
+_trace_flush_semihosting_buffered (void);
+#endif
+
 // ----------------------------------------------------------------------------
 
 void
 trace_initialize(void)
 {
   // For regular ITM / semihosting, no inits required.
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV)
+  // The drain must not delay any other interrupt, so use the
+  // lowest possible priority.
+  NVIC_SetPriority (PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+#endif
 }
 
 // ----------------------------------------------------------------------------
@@ -90,8 +139,13 @@ ssize_t
 trace_write (const char* buf __attribute__((unused)),
 	     size_t nbyte __attribute__((unused)))
 {
-#if defined(OS_USE_TRACE_ITM)
-  return _trace_write_itm (buf, nbyte);
+#if defined(OS_USE_TRACE_ITM_DEFERRED)
+  return _trace_write_itm_deferred (buf, nbyte);
+#elif defined(OS_USE_TRACE_ITM)
+  return _trace_write_itm (_trace_channel_port (trace_channel_text), buf,
+                           nbyte);
+#elif defined(OS_USE_TRACE_SEMIHOSTING_BUFFERED)
+  return _trace_write_semihosting_buffered (buf, nbyte);
 #elif defined(OS_USE_TRACE_SEMIHOSTING_STDOUT)
   return _trace_write_semihosting_stdout(buf, nbyte);
 #elif defined(OS_USE_TRACE_SEMIHOSTING_DEBUG)
@@ -101,6 +155,51 @@ trace_write (const char* buf __attribute__((unused)),
   return -1;
 }
 
+// Write binary data to a specific channel. With ITM, each channel goes
+// to its own stimulus port, so the host can separate the streams
+// without parsing the text. Without ITM there is only the text
+// channel, and writing to the other channels returns -1.
+//
+// Only the text channel is buffered in the deferred configuration;
+// the other channels are always sent directly.
+
+ssize_t
+trace_write_channel (trace_channel_t channel, const void* buf, size_t nbyte)
+{
+  if (channel == trace_channel_text)
+    {
+      return trace_write ((const char*) buf, nbyte);
+    }
+
+#if defined(OS_USE_TRACE_ITM)
+  if (channel < trace_channel_count)
+    {
+      return _trace_write_itm (_trace_channel_port (channel),
+                               (const char*) buf, nbyte);
+    }
+#endif
+
+  return -1;
+}
+
+// Called from the application idle loop (or from PendSV) to push
+// the buffered output to the device; a no-op for unbuffered channels.
+// It is also called from the fault handlers, before halting, so
+// there the deferred ITM output waits for the port instead of
+// leaving the data in the ring.
+
+void
+trace_flush (void)
+{
+#if defined(OS_USE_TRACE_ITM_DEFERRED)
+  // IPSR 2..6 are NMI, HardFault, MemManage, BusFault and UsageFault.
+  uint32_t ipsr = __get_IPSR ();
+  _trace_flush_itm_deferred ((ipsr >= 2 && ipsr <= 6) ? 2 : 0);
+#elif defined(OS_USE_TRACE_SEMIHOSTING_BUFFERED)
+  _trace_flush_semihosting_buffered ();
+#endif
+}
+
 // ----------------------------------------------------------------------------
 
 #if defined(OS_USE_TRACE_ITM)
@@ -120,32 +219,444 @@ trace_write (const char* buf __attribute__((unused)),
 #define OS_INTEGER_TRACE_ITM_STIMULUS_PORT     (0)
 #endif
 
+#if !defined(OS_INTEGER_TRACE_ITM_EVENTS_PORT)
+#define OS_INTEGER_TRACE_ITM_EVENTS_PORT       (1)
+#endif
+
+#if !defined(OS_INTEGER_TRACE_ITM_COUNTERS_PORT)
+#define OS_INTEGER_TRACE_ITM_COUNTERS_PORT     (2)
+#endif
+
+// The stimulus port used by each channel; can be changed at run time
+// with trace_route_channel().
+static volatile uint8_t trace_channel_ports[trace_channel_count] =
+  {
+    OS_INTEGER_TRACE_ITM_STIMULUS_PORT, // trace_channel_text
+    OS_INTEGER_TRACE_ITM_EVENTS_PORT, // trace_channel_events
+    OS_INTEGER_TRACE_ITM_COUNTERS_PORT, // trace_channel_counters
+  };
+
+void
+trace_route_channel (trace_channel_t channel, unsigned int port)
+{
+  if ((channel < trace_channel_count) && (port < 32))
+    {
+      trace_channel_ports[channel] = (uint8_t) port;
+    }
+}
+
+static unsigned int
+_trace_channel_port (trace_channel_t channel)
+{
+  return trace_channel_ports[channel];
+}
+
+// The stimulus port accepts 8, 16 or 32-bit writes, each generating
+// a single SWO packet, so sending words is up to four times faster than
+// sending bytes. The bytes are packed in little endian order, which
+// is the order in which the decoders expect them.
+
 static ssize_t
-_trace_write_itm (const char* buf, size_t nbyte)
+_trace_write_itm (unsigned int port, const char* buf, size_t nbyte)
 {
-  for (size_t i = 0; i < nbyte; i++)
+  const uint8_t* p = (const uint8_t*) buf;
+  size_t i = 0;
+
+  while (i < nbyte)
     {
       // Check if ITM or the stimulus port are not enabled
       if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0)
-	  || ((ITM->TER & (1UL << OS_INTEGER_TRACE_ITM_STIMULUS_PORT)) == 0))
+	  || ((ITM->TER & (1UL << port)) == 0))
 	{
 	  return (ssize_t)i; // return the number of sent characters (may be 0)
 	}
 
       // Wait until STIMx is ready...
-      while (ITM->PORT[OS_INTEGER_TRACE_ITM_STIMULUS_PORT].u32 == 0)
+      while (ITM->PORT[port].u32 == 0)
 	;
-      // then send data, one byte at a time
-      ITM->PORT[OS_INTEGER_TRACE_ITM_STIMULUS_PORT].u8 = (uint8_t) (*buf++);
+      // then send data, as wide as possible
+      size_t togo = nbyte - i;
+      if (togo >= 4)
+        {
+          ITM->PORT[port].u32 = (uint32_t) p[i]
+              | ((uint32_t) p[i + 1] << 8) | ((uint32_t) p[i + 2] << 16)
+              | ((uint32_t) p[i + 3] << 24);
+          i += 4;
+        }
+      else if (togo >= 2)
+        {
+          ITM->PORT[port].u16 = (uint16_t) (p[i] | (p[i + 1] << 8));
+          i += 2;
+        }
+      else
+        {
+          ITM->PORT[port].u8 = p[i];
+          i += 1;
+        }
     }
 
   return (ssize_t)nbyte; // all characters successfully sent
 }
 
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include "diag/Bench.h"
+
+// The time to send 64 bytes to the text stimulus port, one byte per
+// write and packed in words; the cycles per byte are the median / 64
+// and the throughput is SystemCoreClock / (cycles per byte), printed
+// by the runner as "# bench,clock". The payload is a comment line,
+// ignored by the scripts parsing the results.
+//
+// Both are limited by the SWO clock once the ITM FIFO is full;
+// without a debugger enabling the port, nothing is sent and the
+// results are meaningless.
+
+static const char trace_bench_payload[] =
+  "# trace_itm bench payload, 64 bytes, ignored by the parsers....\n";
+
+#define TRACE_BENCH_SIZE (sizeof(trace_bench_payload) - 1)
+
+static void
+trace_bench_itm_bytes (void* arg __attribute__((unused)))
+{
+  unsigned int port = _trace_channel_port (trace_channel_text);
+  if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0)
+      || ((ITM->TER & (1UL << port)) == 0))
+    {
+      return;
+    }
+
+  for (size_t i = 0; i < TRACE_BENCH_SIZE; ++i)
+    {
+      while (ITM->PORT[port].u32 == 0)
+        ;
+      ITM->PORT[port].u8 = (uint8_t) trace_bench_payload[i];
+    }
+}
+
+static void
+trace_bench_itm_words (void* arg __attribute__((unused)))
+{
+  _trace_write_itm (_trace_channel_port (trace_channel_text),
+                    trace_bench_payload, TRACE_BENCH_SIZE);
+}
+
+static bench_t trace_benches[] =
+  {
+    { "trace_itm_bytes_64", trace_bench_itm_bytes, NULL, NULL },
+    { "trace_itm_words_64", trace_bench_itm_words, NULL, NULL },
+  };
+
+static void
+__attribute__((constructor))
+trace_bench_register (void)
+{
+  for (size_t i = 0; i < sizeof(trace_benches) / sizeof(trace_benches[0]);
+      ++i)
+    {
+      bench_register (&trace_benches[i]);
+    }
+}
+
+#endif // defined(OS_USE_BENCH)
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED)
+
+// In the deferred configuration, trace_write() does not wait for the
+// stimulus port; it only reserves space in a RAM ring buffer and copies
+// the bytes, so it can be safely called from interrupt handlers and
+// time critical loops.
+//
+// Multiple producers (thread and nested interrupts) reserve space with
+// LDREX/STREX, without disabling interrupts. Since on a single core
+// a preempted producer cannot resume until the preempting one is done,
+// the reserved bytes are made visible to the consumer only when the
+// outermost producer completes.
+//
+// The consumer, trace_flush(), sends packed words to the stimulus port
+// while it is ready, and returns as soon as it would have to wait.
+// With OS_USE_TRACE_ITM_DEFERRED_PENDSV, trace_write() also pends
+// PendSV, which drains the buffer at the lowest priority.
+//
+// When the buffer is full, the entire trace_write() call is discarded
+// and counted; the statistics are available via trace_get_ring_stats().
+
+#if !defined(OS_INTEGER_TRACE_ITM_RING_SIZE)
+#define OS_INTEGER_TRACE_ITM_RING_SIZE     (1024)
+#endif
+
+#if (OS_INTEGER_TRACE_ITM_RING_SIZE & (OS_INTEGER_TRACE_ITM_RING_SIZE - 1)) != 0
+#error "OS_INTEGER_TRACE_ITM_RING_SIZE must be a power of 2"
+#endif
+
+#define TRACE_RING_MASK (OS_INTEGER_TRACE_ITM_RING_SIZE - 1)
+
+static uint8_t trace_ring[OS_INTEGER_TRACE_ITM_RING_SIZE];
+
+// Free running indices; the ring position is obtained by masking.
+static volatile uint32_t trace_ring_reserved; // next free byte (producers)
+static volatile uint32_t trace_ring_committed; // end of data ready to send
+static volatile uint32_t trace_ring_tail; // next byte to send (consumer)
+
+static volatile uint32_t trace_ring_writers; // nested producers
+static volatile uint32_t trace_ring_draining; // consumer busy (owner)
+static volatile uint32_t trace_ring_flush_missed; // flush during drain
+
+static trace_ring_stats_t trace_ring_stats;
+
+static inline uint32_t
+__attribute__((always_inline))
+_trace_atomic_add (volatile uint32_t* p, uint32_t val)
+{
+  uint32_t n;
+  do
+    {
+      n = __LDREXW (p) + val;
+    }
+  while (__STREXW (n, p) != 0);
+
+  return n;
+}
+
+static inline uint32_t
+__attribute__((always_inline))
+_trace_atomic_swap (volatile uint32_t* p, uint32_t val)
+{
+  uint32_t old;
+  do
+    {
+      old = __LDREXW (p);
+    }
+  while (__STREXW (val, p) != 0);
+
+  return old;
+}
+
+static ssize_t
+_trace_write_itm_deferred (const char* buf, size_t nbyte)
+{
+  if (nbyte == 0)
+    {
+      return 0;
+    }
+
+  _trace_atomic_add (&trace_ring_writers, 1);
+
+  uint32_t head;
+  uint32_t used;
+  int accepted = 1;
+  do
+    {
+      head = __LDREXW (&trace_ring_reserved);
+      used = head - trace_ring_tail;
+      if (nbyte > OS_INTEGER_TRACE_ITM_RING_SIZE - used)
+        {
+          __CLREX ();
+          accepted = 0;
+          break;
+        }
+    }
+  while (__STREXW (head + nbyte, &trace_ring_reserved) != 0);
+
+  if (accepted)
+    {
+      for (size_t i = 0; i < nbyte; ++i)
+        {
+          trace_ring[(head + i) & TRACE_RING_MASK] = (uint8_t) buf[i];
+        }
+
+      // Statistics only; a lost update under preemption is harmless.
+      if (used + nbyte > trace_ring_stats.high_water)
+        {
+          trace_ring_stats.high_water = used + nbyte;
+        }
+    }
+  else
+    {
+      trace_ring_stats.dropped_writes++;
+      trace_ring_stats.dropped_bytes += nbyte;
+    }
+
+  // Make the copied bytes visible before publishing the new end.
+  __DMB ();
+
+  if (_trace_atomic_add (&trace_ring_writers, (uint32_t) -1) == 0)
+    {
+      // Outermost producer; publish everything reserved so far.
+      // A producer preempting this one may already have published
+      // a more recent end; never move the committed index back,
+      // since the consumer may have already sent up to it.
+      uint32_t end = trace_ring_reserved;
+      uint32_t committed;
+      do
+        {
+          committed = __LDREXW (&trace_ring_committed);
+          if ((int32_t) (end - committed) <= 0)
+            {
+              __CLREX ();
+              break;
+            }
+        }
+      while (__STREXW (end, &trace_ring_committed) != 0);
+    }
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV)
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+
+  return accepted ? (ssize_t) nbyte : 0;
+}
+
+// Send the committed bytes to the stimulus port, as 32-bit words,
+// plus a possible tail of single bytes. If wait is 0, return as soon
+// as the port is busy; otherwise wait until all bytes are sent.
+// A wait of 2 is used by the fault handlers, which also take over
+// a drain in progress, so the last messages are not lost.
+
+static void
+_trace_flush_itm_deferred (int wait)
+{
+  // Single consumer; the owner is identified by the value stored in
+  // trace_ring_draining (1 for the normal flushes, 2 for the fault
+  // handlers).
+  uint32_t owner = (wait == 2) ? 2 : 1;
+  uint32_t previous = _trace_atomic_swap (&trace_ring_draining, owner);
+  if (previous != 0)
+    {
+      if (previous == 2 || owner != 2)
+        {
+          // A drain is already in progress (for example the thread
+          // mode flush was preempted by PendSV); remember the request,
+          // the owner will pass it on when done.
+          trace_ring_draining = previous;
+          trace_ring_flush_missed = 1;
+          return;
+        }
+      // A fault interrupted the drain, which may never resume;
+      // take over from the last released position. The preempted
+      // drain notices the change of owner and gives up.
+    }
+
+  unsigned int port = _trace_channel_port (trace_channel_text);
+  uint32_t tail = trace_ring_tail;
+  uint32_t end = trace_ring_committed;
+
+  while (tail != end)
+    {
+      if (trace_ring_draining != owner)
+        {
+          // Taken over by a fault handler; the tail belongs to it now.
+          return;
+        }
+
+      // If ITM or the stimulus port are not enabled, discard the
+      // pending data, as the unbuffered version does.
+      if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0)
+          || ((ITM->TER & (1UL << port)) == 0))
+        {
+          tail = end;
+          break;
+        }
+
+      if (ITM->PORT[port].u32 == 0)
+        {
+          if (wait)
+            {
+              continue;
+            }
+          break;
+        }
+
+      uint32_t togo = end - tail;
+      if (togo >= 4)
+        {
+          // Assemble the word byte by byte, the ring may wrap.
+          uint32_t w = (uint32_t) trace_ring[tail & TRACE_RING_MASK];
+          w |= (uint32_t) trace_ring[(tail + 1) & TRACE_RING_MASK] << 8;
+          w |= (uint32_t) trace_ring[(tail + 2) & TRACE_RING_MASK] << 16;
+          w |= (uint32_t) trace_ring[(tail + 3) & TRACE_RING_MASK] << 24;
+          ITM->PORT[port].u32 = w;
+          tail += 4;
+        }
+      else if (togo >= 2)
+        {
+          uint16_t h = (uint16_t) trace_ring[tail & TRACE_RING_MASK];
+          h |= (uint16_t) (trace_ring[(tail + 1) & TRACE_RING_MASK] << 8);
+          ITM->PORT[port].u16 = h;
+          tail += 2;
+        }
+      else
+        {
+          ITM->PORT[port].u8 = trace_ring[tail & TRACE_RING_MASK];
+          tail += 1;
+        }
+
+      // Release the space as soon as possible.
+      trace_ring_tail = tail;
+
+      if (tail == end)
+        {
+          // Pick up data committed in the meantime.
+          end = trace_ring_committed;
+        }
+    }
+
+  if (trace_ring_draining != owner)
+    {
+      return;
+    }
+  trace_ring_tail = tail;
+  trace_ring_draining = 0;
+
+  if (trace_ring_flush_missed)
+    {
+      trace_ring_flush_missed = 0;
+#if defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV)
+      // Pass the missed request to PendSV, which waits for the port.
+      SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+    }
+}
+
+void
+trace_get_ring_stats (trace_ring_stats_t* stats)
+{
+  *stats = trace_ring_stats;
+}
+
+#if defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV)
+
+// Overrides the weak definition in exception_handlers.c.
+// Running at the lowest priority, it can wait for the stimulus port
+// without delaying other interrupts.
+void
+PendSV_Handler (void)
+{
+  _trace_flush_itm_deferred (1);
+}
+
+#endif // defined(OS_USE_TRACE_ITM_DEFERRED_PENDSV)
+
+#endif // defined(OS_USE_TRACE_ITM_DEFERRED)
+
 #endif // defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
 
 #endif // OS_USE_TRACE_ITM
 
+#if !defined(OS_USE_TRACE_ITM)
+
+void
+trace_route_channel (trace_channel_t channel __attribute__((unused)),
+                     unsigned int port __attribute__((unused)))
+{
+  // Channels are meaningful only for ITM.
+}
+
+#endif // !defined(OS_USE_TRACE_ITM)
+
 // ----------------------------------------------------------------------------
 
 #if defined(OS_USE_TRACE_SEMIHOSTING_DEBUG) || defined(OS_USE_TRACE_SEMIHOSTING_STDOUT)
@@ -268,6 +779,95 @@ _trace_write_semihosting_debug (const char* buf, size_t nbyte)
 
 #endif // OS_USE_TRACE_SEMIHOSTING_DEBUG
 
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_TRACE_SEMIHOSTING_BUFFERED)
+
+// Each semihosting call is a BKPT that halts the core until the
+// debugger services it, which takes milliseconds regardless of the
+// amount of data. In the buffered mode the output is collected in
+// a RAM buffer and passed to the host with a single call when a line
+// is complete, when the buffer is full, or when trace_flush() is
+// called. The fault handlers call trace_flush() before halting,
+// so the last messages are not lost.
+
+#if !defined(OS_INTEGER_TRACE_SEMIHOSTING_BUFFER_SIZE)
+#define OS_INTEGER_TRACE_SEMIHOSTING_BUFFER_SIZE (256)
+#endif
+
+// One more byte for the SYS_WRITE0 terminator.
+static char trace_semihosting_buf[OS_INTEGER_TRACE_SEMIHOSTING_BUFFER_SIZE + 1];
+static size_t trace_semihosting_len;
+
+// Must be called with the interrupts disabled.
+static void
+_trace_send_semihosting_buffered (void)
+{
+  if (trace_semihosting_len == 0)
+    {
+      return;
+    }
+
+#if defined(OS_USE_TRACE_SEMIHOSTING_STDOUT)
+  _trace_write_semihosting_stdout (trace_semihosting_buf,
+                                   trace_semihosting_len);
+#else
+  // Terminated, so it goes out with a single SYS_WRITE0.
+  trace_semihosting_buf[trace_semihosting_len] = '\0';
+  _trace_write_semihosting_debug (trace_semihosting_buf,
+                                  trace_semihosting_len);
+#endif
+  trace_semihosting_len = 0;
+}
+
+static ssize_t
+_trace_write_semihosting_buffered (const char* buf, size_t nbyte)
+{
+  int eol = 0;
+
+  // The buffer is shared with the interrupt handlers; the host
+  // call halts the core anyway, so keeping the interrupts disabled
+  // while sending does not add any latency.
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  for (size_t i = 0; i < nbyte; ++i)
+    {
+      if (trace_semihosting_len == OS_INTEGER_TRACE_SEMIHOSTING_BUFFER_SIZE)
+        {
+          _trace_send_semihosting_buffered ();
+        }
+      trace_semihosting_buf[trace_semihosting_len++] = buf[i];
+      if (buf[i] == '\n')
+        {
+          eol = 1;
+        }
+    }
+
+  // Send all complete lines of this call at once.
+  if (eol)
+    {
+      _trace_send_semihosting_buffered ();
+    }
+
+  __set_PRIMASK (primask);
+
+  return (ssize_t) nbyte;
+}
+
+static void
+_trace_flush_semihosting_buffered (void)
+{
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  _trace_send_semihosting_buffered ();
+
+  __set_PRIMASK (primask);
+}
+
+#endif // OS_USE_TRACE_SEMIHOSTING_BUFFERED
+
 #endif // TRACE
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,188 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+#if defined(TRACE)
+
+#include <stdarg.h>
+#include "cmsis_device.h"
+#include "diag/Trace.h"
+#if defined(OS_USE_TRACE_LOG_TIMESTAMPS)
+#include "cortexm/Clock.h"
+#endif
+
+// ----------------------------------------------------------------------------
+
+// The deferred formatting backend for trace_log().
+//
+// Each call sends a packet of 32-bit little endian words on the
+// events channel (ITM stimulus port 1 by default):
+// - word 0: bits 31..24 the number of arguments, bit 23 set if a
+//   timestamp follows, bits 22..0 the offset of the format string in
+//   the .trace_fmt section
+// - with OS_USE_TRACE_LOG_TIMESTAMPS defined, two words with the
+//   clock_now_ns() value, low word first
+// - the arguments, as passed
+//
+// No formatting is done on the target, and the format strings do not
+// use flash space, so a call costs only the packet write.
+//
+// The packets are decoded on the host by scripts/trace_log_decode.py,
+// which reads the format strings from the ELF file.
+
+#define TRACE_LOG_OFFSET_MASK (0x007FFFFFUL)
+#define TRACE_LOG_TIMESTAMP (0x00800000UL)
+
+#if defined(OS_USE_TRACE_LOG_TIMESTAMPS)
+#define TRACE_LOG_HEADER_WORDS (3)
+#else
+#define TRACE_LOG_HEADER_WORDS (1)
+#endif
+
+// The packets must not be interleaved on the port, but the port may
+// be slow, so the interrupts are disabled only to append the packet to
+// a small queue of words; the outermost caller then sends the queue
+// with the interrupts enabled, including the packets added by the
+// interrupts that preempted it. When the queue is full, the packet is
+// dropped.
+
+#if !defined(OS_INTEGER_TRACE_LOG_QUEUE_WORDS)
+#define OS_INTEGER_TRACE_LOG_QUEUE_WORDS (64)
+#endif
+
+#if (OS_INTEGER_TRACE_LOG_QUEUE_WORDS & (OS_INTEGER_TRACE_LOG_QUEUE_WORDS - 1)) != 0
+#error "OS_INTEGER_TRACE_LOG_QUEUE_WORDS must be a power of 2"
+#endif
+
+#define TRACE_LOG_QUEUE_MASK (OS_INTEGER_TRACE_LOG_QUEUE_WORDS - 1)
+
+static uint32_t trace_log_queue[OS_INTEGER_TRACE_LOG_QUEUE_WORDS];
+
+// Free running indices; the queue position is obtained by masking.
+static volatile uint32_t trace_log_head; // next free word
+static volatile uint32_t trace_log_tail; // next word to send
+static volatile uint32_t trace_log_sending; // a caller is sending
+
+// Packets dropped because the queue was full; for the debugger.
+static volatile uint32_t trace_log_dropped;
+
+void
+trace_log_write (uint32_t format, unsigned int nargs, ...)
+{
+  uint32_t packet[TRACE_LOG_HEADER_WORDS + TRACE_LOG_MAX_ARGS];
+
+  if (nargs > TRACE_LOG_MAX_ARGS)
+    {
+      nargs = TRACE_LOG_MAX_ARGS;
+    }
+
+  packet[0] = ((uint32_t) nargs << 24) | (format & TRACE_LOG_OFFSET_MASK);
+
+  va_list ap;
+  va_start (ap, nargs);
+  for (unsigned int i = 0; i < nargs; ++i)
+    {
+      // On Cortex-M, integers, characters and pointers are all
+      // passed as 32-bit words.
+      packet[TRACE_LOG_HEADER_WORDS + i] = va_arg (ap, unsigned int);
+    }
+  va_end (ap);
+
+  uint32_t words = TRACE_LOG_HEADER_WORDS + nargs;
+
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+#if defined(OS_USE_TRACE_LOG_TIMESTAMPS)
+  // Taken inside the critical section, so the timestamps of the
+  // packets are in order.
+  uint64_t now = clock_now_ns ();
+  packet[0] |= TRACE_LOG_TIMESTAMP;
+  packet[1] = (uint32_t) now;
+  packet[2] = (uint32_t) (now >> 32);
+#endif
+
+  uint32_t head = trace_log_head;
+  if (words <= OS_INTEGER_TRACE_LOG_QUEUE_WORDS - (head - trace_log_tail))
+    {
+      for (uint32_t i = 0; i < words; ++i)
+        {
+          trace_log_queue[(head + i) & TRACE_LOG_QUEUE_MASK] = packet[i];
+        }
+      trace_log_head = head + words;
+    }
+  else
+    {
+      trace_log_dropped++;
+    }
+
+  int outermost = (trace_log_sending == 0);
+  trace_log_sending = 1;
+
+  __set_PRIMASK (primask);
+
+  if (!outermost)
+    {
+      // The preempted caller sends the packet.
+      return;
+    }
+
+  for (;;)
+    {
+      uint32_t tail = trace_log_tail;
+      uint32_t count = trace_log_head - tail;
+      if (count == 0)
+        {
+          __disable_irq ();
+          if (trace_log_head == tail)
+            {
+              trace_log_sending = 0;
+              __set_PRIMASK (primask);
+              break;
+            }
+          __set_PRIMASK (primask);
+          continue;
+        }
+
+      // Up to the end of the queue; the rest on the next iteration.
+      uint32_t index = tail & TRACE_LOG_QUEUE_MASK;
+      if (count > OS_INTEGER_TRACE_LOG_QUEUE_WORDS - index)
+        {
+          count = OS_INTEGER_TRACE_LOG_QUEUE_WORDS - index;
+        }
+
+      // If the port is not enabled, the words are discarded.
+      trace_write_channel (trace_channel_events, &trace_log_queue[index],
+                           count * sizeof(trace_log_queue[0]));
+      trace_log_tail = tail + count;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // TRACE
@@ -70,3 +70,60 @@ extern "C"
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_CXX_LIGHT_GUARDS)
+
+// Guards for the static local objects, when compiled with thread safe
+// statics, for single core applications. The library versions use a
+// mutex and a condition variable; these only mark the initialisation
+// in progress, to catch the recursive initialisations (or the
+// initialisations started again from an interrupt handler), which
+// abort. The compiler checks the initialised flag inline, so the
+// usual cost of a guarded object is one load and one branch.
+//
+// The guard is 32-bit on ARM EABI, with bit 0 as the initialised
+// flag; the second byte is used for the in progress flag.
+
+#include <cxxabi.h>
+
+namespace __cxxabiv1
+{
+  extern "C"
+  {
+    int
+    __cxa_guard_acquire(__guard* guard)
+    {
+      unsigned char* bytes = reinterpret_cast<unsigned char*>(guard);
+      if ((bytes[0] & 1) != 0)
+        {
+          return 0;
+        }
+      if (bytes[1] != 0)
+        {
+          trace_puts(__func__);
+          abort();
+        }
+      bytes[1] = 1;
+      return 1;
+    }
+
+    void
+    __cxa_guard_release(__guard* guard)
+    {
+      unsigned char* bytes = reinterpret_cast<unsigned char*>(guard);
+      bytes[1] = 0;
+      bytes[0] = 1;
+    }
+
+    void
+    __cxa_guard_abort(__guard* guard)
+    {
+      unsigned char* bytes = reinterpret_cast<unsigned char*>(guard);
+      bytes[1] = 0;
+    }
+  }
+}
+
+#endif // defined(OS_USE_CXX_LIGHT_GUARDS)
+
+// ----------------------------------------------------------------------------
+
@@ -0,0 +1,341 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2014 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------------------------------------------------------------------
+
+// Optional pool based operator new/delete, described in cortexm/Pool.h.
+// Without OS_USE_CXX_POOLS, the library operators (using malloc())
+// are linked; the benchmarks at the end are built in both cases, to
+// compare the two.
+
+// ----------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include "cmsis_device.h"
+#include "cortexm/Pool.h"
+#include "diag/Trace.h"
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_CXX_POOLS)
+
+#define POOL_MAX_SIZE (8u << (OS_INTEGER_POOL_CLASSES - 1))
+#define POOL_PAGES (OS_INTEGER_POOL_ARENA_SIZE / OS_INTEGER_POOL_PAGE_SIZE)
+
+#if (OS_INTEGER_POOL_PAGE_SIZE % POOL_MAX_SIZE) != 0
+#error "OS_INTEGER_POOL_PAGE_SIZE must be a multiple of the largest class"
+#endif
+
+#if (POOL_PAGES < 1) || (POOL_PAGES > 255)
+#error "Unsupported OS_INTEGER_POOL_ARENA_SIZE/OS_INTEGER_POOL_PAGE_SIZE"
+#endif
+
+namespace
+{
+  struct pool_block_t
+  {
+    pool_block_t* next;
+  };
+
+  // Aligned to 8, as required by the EABI.
+  alignas(8) std::uint8_t pool_arena[POOL_PAGES * OS_INTEGER_POOL_PAGE_SIZE];
+
+  std::uint8_t* const pool_arena_end = pool_arena + sizeof(pool_arena);
+
+  // The pages are taken from the arena begin, the arena allocations
+  // from the end.
+  std::uint8_t* pool_pages_end = pool_arena;
+  std::uint8_t* pool_arena_top = pool_arena_end;
+
+  std::uint8_t pool_page_class[POOL_PAGES];
+  pool_block_t* pool_free_lists[OS_INTEGER_POOL_CLASSES];
+
+  unsigned int pool_class_allocated[OS_INTEGER_POOL_CLASSES];
+  unsigned int pool_fallback_allocations;
+
+  // Give a new page to a class and return its first block;
+  // called with the interrupts disabled.
+  pool_block_t*
+  pool_new_page(unsigned int cls)
+  {
+    std::uint8_t* page = pool_pages_end;
+    if (page + OS_INTEGER_POOL_PAGE_SIZE > pool_arena_top)
+      {
+        return nullptr;
+      }
+    pool_pages_end = page + OS_INTEGER_POOL_PAGE_SIZE;
+    pool_page_class[(page - pool_arena) / OS_INTEGER_POOL_PAGE_SIZE] =
+        static_cast<std::uint8_t>(cls);
+
+    // Link all blocks; the last one ends the (empty) list.
+    std::size_t size = 8u << cls;
+    pool_block_t* first = reinterpret_cast<pool_block_t*>(page);
+    pool_block_t* block = first;
+    for (std::uint8_t* p = page + size; p < pool_pages_end; p += size)
+      {
+        block->next = reinterpret_cast<pool_block_t*>(p);
+        block = block->next;
+      }
+    block->next = nullptr;
+
+    return first;
+  }
+}
+
+void*
+pool_alloc(std::size_t size)
+{
+  pool_block_t* block = nullptr;
+
+  std::uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (size <= POOL_MAX_SIZE)
+    {
+      unsigned int cls =
+          (size <= 8) ?
+              0 : 32u - __builtin_clz(static_cast<unsigned int>(size - 1)) - 3u;
+
+      block = pool_free_lists[cls];
+      if (block == nullptr)
+        {
+          block = pool_new_page(cls);
+        }
+      if (block != nullptr)
+        {
+          pool_free_lists[cls] = block->next;
+          pool_class_allocated[cls]++;
+        }
+    }
+  if (block == nullptr)
+    {
+      // Too large, or the arena is exhausted.
+      pool_fallback_allocations++;
+    }
+
+  __set_PRIMASK(primask);
+
+  if (block == nullptr)
+    {
+      return std::malloc(size);
+    }
+  return block;
+}
+
+void
+pool_free(void* ptr)
+{
+  std::uint8_t* p = static_cast<std::uint8_t*>(ptr);
+  if (p < pool_arena || p >= pool_arena_end)
+    {
+      std::free(ptr);
+      return;
+    }
+
+  std::uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  // The arena allocations cannot be freed, and are ignored.
+  if (p < pool_pages_end)
+    {
+      unsigned int cls = pool_page_class[(p - pool_arena)
+          / OS_INTEGER_POOL_PAGE_SIZE];
+      pool_block_t* block = reinterpret_cast<pool_block_t*>(p);
+      block->next = pool_free_lists[cls];
+      pool_free_lists[cls] = block;
+      pool_class_allocated[cls]--;
+    }
+
+  __set_PRIMASK(primask);
+}
+
+void*
+pool_arena_alloc(std::size_t size, std::size_t align)
+{
+  void* ret = nullptr;
+
+  std::uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  std::uintptr_t top = reinterpret_cast<std::uintptr_t>(pool_arena_top);
+  if (size <= top - reinterpret_cast<std::uintptr_t>(pool_pages_end))
+    {
+      top = (top - size) & ~(static_cast<std::uintptr_t>(align) - 1);
+      if (top >= reinterpret_cast<std::uintptr_t>(pool_pages_end))
+        {
+          pool_arena_top = reinterpret_cast<std::uint8_t*>(top);
+          ret = pool_arena_top;
+        }
+    }
+
+  __set_PRIMASK(primask);
+  return ret;
+}
+
+void
+pool_get_stats(pool_stats_t* stats)
+{
+  std::uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  stats->arena_bytes = sizeof(pool_arena);
+  stats->arena_used_bytes = static_cast<std::size_t>((pool_pages_end
+      - pool_arena) + (pool_arena_end - pool_arena_top));
+  for (unsigned int i = 0; i < OS_INTEGER_POOL_CLASSES; ++i)
+    {
+      stats->class_allocated[i] = pool_class_allocated[i];
+    }
+  stats->fallback_allocations = pool_fallback_allocations;
+
+  __set_PRIMASK(primask);
+}
+
+// ----------------------------------------------------------------------------
+
+// Without exceptions, an allocation failure is fatal.
+
+void*
+operator new(std::size_t size)
+{
+  void* ptr = pool_alloc(size);
+  if (ptr == nullptr)
+    {
+      trace_puts(__func__);
+      std::abort();
+    }
+  return ptr;
+}
+
+void*
+operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return pool_alloc(size);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return pool_alloc(size);
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  pool_free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+  pool_free(ptr);
+}
+
+void
+operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+  pool_free(ptr);
+}
+
+void
+operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+  pool_free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+  pool_free(ptr);
+}
+
+void
+operator delete[](void* ptr, std::size_t) noexcept
+{
+  pool_free(ptr);
+}
+
+#endif // defined(__cpp_sized_deallocation)
+
+#endif // defined(OS_USE_CXX_POOLS)
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_BENCH)
+
+#include "diag/Bench.h"
+
+// A new/delete pair; the delete of the previous run is done first,
+// so the allocator does not always get back the block it just freed.
+
+namespace
+{
+  void* bench_previous;
+
+  void
+  bench_new_delete(void* arg)
+  {
+    void* ptr = operator new(reinterpret_cast<std::size_t>(arg));
+    BENCH_KEEP(ptr);
+    operator delete(bench_previous);
+    bench_previous = ptr;
+  }
+
+  bench_t benches[] =
+    {
+      { "cxx_new_delete_16", bench_new_delete, reinterpret_cast<void*>(16),
+          nullptr },
+      { "cxx_new_delete_64", bench_new_delete, reinterpret_cast<void*>(64),
+          nullptr },
+      { "cxx_new_delete_256", bench_new_delete, reinterpret_cast<void*>(256),
+          nullptr },
+    };
+
+  struct BenchRegistrar
+  {
+    BenchRegistrar()
+    {
+      for (auto& bench : benches)
+        {
+          bench_register(&bench);
+        }
+    }
+  } benchRegistrar;
+}
+
+#endif // defined(OS_USE_BENCH)
+
+// ----------------------------------------------------------------------------
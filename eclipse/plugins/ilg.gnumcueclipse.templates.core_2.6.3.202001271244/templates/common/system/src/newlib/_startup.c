@@ -45,6 +45,16 @@
 // If OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS is defined, the
 // code is capable of initialising multiple regions.
 //
+// If OS_USE_STACK_USAGE is defined, the free part of the main stack
+// is painted first, to measure its usage later (see
+// cortexm/StackUsage.h).
+//
+// If OS_INCLUDE_STARTUP_PROFILER is defined, the duration of each
+// step (including each static constructor), up to the call to main(),
+// is measured with the DWT cycle counter; main() displays the table
+// via the trace device with __startup_profiler_dump()
+// (see diag/StartupProfiler.h).
+//
 // The normal configuration is standalone, with all support
 // functions implemented locally.
 //
@@ -62,9 +72,46 @@
 #define OS_INCLUDE_STARTUP_GUARD_CHECKS (1)
 #endif
 
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+#if !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+#undef OS_INCLUDE_STARTUP_PROFILER
+#warning "The startup profiler needs the DWT cycle counter"
+#endif
+#endif
+
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+
+#include <inttypes.h>
+#include "cmsis_device.h"
+#include "diag/Trace.h"
+#include "diag/StartupProfiler.h"
+
+#if !defined(OS_INTEGER_STARTUP_PROFILER_RECORDS)
+#define OS_INTEGER_STARTUP_PROFILER_RECORDS (32)
+#endif
+
+#endif // defined(OS_INCLUDE_STARTUP_PROFILER)
+
+#if defined(OS_USE_STACK_USAGE)
+
+#include "cortexm/StackUsage.h"
+
+// The bottom of the main stack; defined in linker script.
+extern unsigned int __Main_Stack_Limit;
+
+#endif // defined(OS_USE_STACK_USAGE)
+
 // ----------------------------------------------------------------------------
 
 #if !defined(OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS)
+#if defined(OS_USE_FAST_ISRS)
+#error "The fast sections (cortexm/FastCode.h) need OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS"
+#endif
+// The fast sections are not initialised either; the linker script
+// checks that they are empty when this (absolute, so never garbage
+// collected) symbol is defined.
+__asm__ (".global __startup_single_ram_section\n"
+    ".set __startup_single_ram_section, 1");
 // Begin address for the initialisation values of the .data section.
 // defined in linker script
 extern unsigned int _sidata;
@@ -120,6 +167,9 @@ __initialize_data (unsigned int* from, unsigned int* region_begin,
 void
 __initialize_bss (unsigned int* region_begin, unsigned int* region_end);
 
+void
+__initialize_bss_region (unsigned int* region_begin, unsigned int* region_end);
+
 void
 __run_init_array (void);
 
@@ -132,16 +182,52 @@ __initialize_hardware_early (void);
 void
 __initialize_hardware (void);
 
+#if defined(OS_USE_STACK_USAGE)
+void
+__paint_main_stack (void);
+#endif
+
 // ----------------------------------------------------------------------------
 
+// The regions are processed in blocks of 8 words, with multiple
+// register loads/stores (LDM/STM), and the remaining words one by one.
+// The registers r3-r6 are used for the data since they are available
+// on all Cortex-M cores; r7 is avoided, since it may be the
+// frame pointer.
+
+#if defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define OS_STARTUP_INIT_LDM_STM
+#endif
+
 inline void
 __attribute__((always_inline))
 __initialize_data (unsigned int* from, unsigned int* region_begin,
 		   unsigned int* region_end)
 {
-  // Iterate and copy word by word.
   // It is assumed that the pointers are word aligned.
   unsigned int *p = region_begin;
+
+#if defined(OS_STARTUP_INIT_LDM_STM)
+  unsigned int* blocks_end = p + ((region_end - p) & ~7);
+  if (p < blocks_end)
+    {
+      __asm__ volatile (
+          "1:                       \n"
+          " ldmia %[from]!, {r3-r6} \n"
+          " stmia %[p]!, {r3-r6}    \n"
+          " ldmia %[from]!, {r3-r6} \n"
+          " stmia %[p]!, {r3-r6}    \n"
+          " cmp %[p], %[end]        \n"
+          " bcc 1b                  \n"
+
+          : [from] "+l" (from), [p] "+l" (p) /* Outputs */
+          : [end] "l" (blocks_end) /* Inputs */
+          : "r3", "r4", "r5", "r6", "cc", "memory" /* Clobbers */
+      );
+    }
+#endif
+
+  // Copy the rest word by word.
   while (p < region_end)
     *p++ = *from++;
 }
@@ -150,13 +236,158 @@ inline void
 __attribute__((always_inline))
 __initialize_bss (unsigned int* region_begin, unsigned int* region_end)
 {
-  // Iterate and clear word by word.
   // It is assumed that the pointers are word aligned.
   unsigned int *p = region_begin;
+
+#if defined(OS_STARTUP_INIT_LDM_STM)
+  unsigned int* blocks_end = p + ((region_end - p) & ~7);
+  if (p < blocks_end)
+    {
+      __asm__ volatile (
+          " movs r3, #0             \n"
+          " movs r4, #0             \n"
+          " movs r5, #0             \n"
+          " movs r6, #0             \n"
+          "1:                       \n"
+          " stmia %[p]!, {r3-r6}    \n"
+          " stmia %[p]!, {r3-r6}    \n"
+          " cmp %[p], %[end]        \n"
+          " bcc 1b                  \n"
+
+          : [p] "+l" (p) /* Outputs */
+          : [end] "l" (blocks_end) /* Inputs */
+          : "r3", "r4", "r5", "r6", "cc", "memory" /* Clobbers */
+      );
+    }
+#endif
+
+  // Clear the rest word by word.
   while (p < region_end)
     *p++ = 0;
 }
 
+#if defined(OS_USE_STACK_USAGE)
+
+// Fill the main stack below the current stack pointer with the
+// pattern. Inlined and without calls, so nothing else is pushed
+// there; the pointer is volatile to prevent the loop from being
+// replaced by a call to memset().
+inline void
+__attribute__((always_inline))
+__paint_main_stack (void)
+{
+  unsigned int* sp;
+  __asm__ volatile ("mov %0, sp" : "=r" (sp));
+
+  for (volatile unsigned int* p = &__Main_Stack_Limit; p < sp; ++p)
+    *p = STACK_USAGE_PAINT;
+}
+
+#endif // defined(OS_USE_STACK_USAGE)
+
+#if defined(OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS)
+
+// Called for each BSS region listed in the linker tables. It can be
+// redefined by the application, for example to clear large regions
+// in external RAM with a DMA channel; in this case the DMA must
+// be configured in __initialize_hardware_early(), and the function
+// must return only after the region was cleared.
+
+void __attribute__((weak))
+__initialize_bss_region (unsigned int* region_begin, unsigned int* region_end)
+{
+  __initialize_bss (region_begin, region_end);
+}
+
+#endif // defined(OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS)
+
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+
+typedef struct
+{
+  const char* name;
+  void (*function) (void); // for the static constructors
+  uint32_t cycles; // since _start()
+} __startup_profiler_record_t;
+
+// Not in .bss, since the first records are taken before the data
+// and bss sections are initialised.
+static __startup_profiler_record_t __attribute__ ((section(".noinit")))
+__startup_profiler_records[OS_INTEGER_STARTUP_PROFILER_RECORDS];
+static unsigned int __attribute__ ((section(".noinit")))
+__startup_profiler_count;
+// The steps not recorded because the table was full.
+static unsigned int __attribute__ ((section(".noinit")))
+__startup_profiler_dropped;
+
+static inline void
+__attribute__((always_inline))
+__startup_profiler_start (void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  __startup_profiler_count = 0;
+  __startup_profiler_dropped = 0;
+}
+
+static inline void
+__attribute__((always_inline))
+__startup_profiler_record (const char* name, void (*function) (void))
+{
+  uint32_t cycles = DWT->CYCCNT;
+  if (__startup_profiler_count < OS_INTEGER_STARTUP_PROFILER_RECORDS)
+    {
+      __startup_profiler_record_t* r =
+          &__startup_profiler_records[__startup_profiler_count++];
+      r->name = name;
+      r->function = function;
+      r->cycles = cycles;
+    }
+  else
+    {
+      __startup_profiler_dropped++;
+    }
+}
+
+void
+__startup_profiler_dump (void)
+{
+  trace_printf ("Startup profile (cycles):\n");
+  trace_printf ("     total      delta  step\n");
+
+  uint32_t previous = 0;
+  for (unsigned int i = 0; i < __startup_profiler_count; ++i)
+    {
+      __startup_profiler_record_t* r = &__startup_profiler_records[i];
+      trace_printf ("%10" PRIu32 " %10" PRIu32 "  %s", r->cycles,
+                    r->cycles - previous, r->name);
+      if (r->function != NULL)
+        {
+          trace_printf (" %p", r->function);
+        }
+      trace_printf ("\n");
+      previous = r->cycles;
+    }
+
+  if (__startup_profiler_dropped != 0)
+    {
+      trace_printf ("%u more steps not recorded, "
+                    "increase OS_INTEGER_STARTUP_PROFILER_RECORDS\n",
+                    __startup_profiler_dropped);
+    }
+}
+
+#define __STARTUP_PROFILE(name, function) \
+  __startup_profiler_record (name, function)
+
+#else
+
+#define __STARTUP_PROFILE(name, function)
+
+#endif // defined(OS_INCLUDE_STARTUP_PROFILER)
+
 // These magic symbols are provided by the linker.
 extern void
 (*__preinit_array_start[]) (void) __attribute__((weak));
@@ -181,7 +412,10 @@ __run_init_array (void)
 
   count = __preinit_array_end - __preinit_array_start;
   for (i = 0; i < count; i++)
-    __preinit_array_start[i] ();
+    {
+      __preinit_array_start[i] ();
+      __STARTUP_PROFILE("preinit_array", __preinit_array_start[i]);
+    }
 
   // If you need to run the code in the .init section, please use
   // the startup files, since this requires the code in crti.o and crtn.o
@@ -190,7 +424,10 @@ __run_init_array (void)
 
   count = __init_array_end - __init_array_start;
   for (i = 0; i < count; i++)
-    __init_array_start[i] ();
+    {
+      __init_array_start[i] ();
+      __STARTUP_PROFILE("init_array", __init_array_start[i]);
+    }
 }
 
 // Run all the cleanup routines (mainly static destructors).
@@ -245,6 +482,14 @@ void __attribute__ ((section(".after_vectors"),noreturn,weak))
 _start (void)
 {
 
+#if defined(OS_USE_STACK_USAGE)
+  __paint_main_stack ();
+#endif
+
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+  __startup_profiler_start ();
+#endif
+
   // Initialise hardware right after reset, to switch clock to higher
   // frequency and have the rest of the initialisations run faster.
   //
@@ -255,6 +500,7 @@ _start (void)
   // initialised before filling the BSS section.
 
   __initialize_hardware_early ();
+  __STARTUP_PROFILE("__initialize_hardware_early()", NULL);
 
   // Use Old Style DATA and BSS section initialisation,
   // that will manage a single BSS sections.
@@ -281,6 +527,7 @@ _start (void)
     }
 
 #endif
+  __STARTUP_PROFILE("data", NULL);
 
 #if defined(DEBUG) && (OS_INCLUDE_STARTUP_GUARD_CHECKS)
   if ((__data_begin_guard != DATA_BEGIN_GUARD_VALUE)
@@ -307,9 +554,10 @@ _start (void)
     {
       unsigned int* region_begin = (unsigned int*) (*p++);
       unsigned int* region_end = (unsigned int*) (*p++);
-      __initialize_bss (region_begin, region_end);
+      __initialize_bss_region (region_begin, region_end);
     }
 #endif
+  __STARTUP_PROFILE("bss", NULL);
 
 #if defined(DEBUG) && (OS_INCLUDE_STARTUP_GUARD_CHECKS)
   if ((__bss_begin_guard != 0) || (__bss_end_guard != 0))
@@ -322,15 +570,18 @@ _start (void)
   // Hook to continue the initialisations. Usually compute and store the
   // clock frequency in the global CMSIS variable, cleared above.
   __initialize_hardware ();
+  __STARTUP_PROFILE("__initialize_hardware()", NULL);
 
   // Get the argc/argv (useful in semihosting configurations).
   int argc;
   char** argv;
   __initialize_args (&argc, &argv);
+  __STARTUP_PROFILE("__initialize_args()", NULL);
 
   // Call the standard library initialisation (mandatory for C++ to
   // execute the constructors for the static objects).
   __run_init_array ();
+  __STARTUP_PROFILE("main()", NULL);
 
   // Call the main entry point, and save the exit code.
   int code = main (argc, argv);
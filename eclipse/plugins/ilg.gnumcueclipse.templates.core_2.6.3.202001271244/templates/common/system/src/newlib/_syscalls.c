@@ -426,6 +426,11 @@ error (int);
 static int
 get_errno (void);
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+static void
+fdcache_flush_all (void);
+#endif
+
 // ----------------------------------------------------------------------------
 
 #define ARGS_BUF_ARRAY_SIZE 80
@@ -541,6 +546,11 @@ _exit (int status)
    signum, so that the SWI handler can distinguish the two calls.
    Note: The RDI implementation of _kill throws away both its
    arguments.  */
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  /* Do not lose the data pending in the write-behind buffers. */
+  fdcache_flush_all ();
+#endif
+
   report_exception (
       status == 0 ? ADP_Stopped_ApplicationExit : ADP_Stopped_RunTimeError);
 }
@@ -562,10 +572,50 @@ struct fdent
 {
   int handle;
   int pos;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  struct fdcache* cache;
+#endif
 };
 
 #define MAX_OPEN_FILES 20
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+
+/* Each semihosting call traps to the debugger, which takes much
+ longer than the transfer itself, so with OS_USE_SEMIHOSTING_FILE_CACHE
+ the regular files get a buffer which is used for reading ahead
+ full blocks and for collecting consecutive writes.
+
+ The buffers are allocated statically, and are assigned when a
+ file is opened; files opened when all buffers are in use, the
+ terminal and the files opened in append mode are not buffered.
+
+ The cached data is tagged with its file offset, so it stays valid
+ after lseek(); the write-behind data is sent to the host before
+ lseek(), fstat(), close() and _exit(). */
+
+#if !defined(OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE)
+#define OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE (512)
+#endif
+
+#if !defined(OS_INTEGER_SEMIHOSTING_FILE_CACHES)
+#define OS_INTEGER_SEMIHOSTING_FILE_CACHES (4)
+#endif
+
+struct fdcache
+{
+  struct fdent* owner; /* NULL if the buffer is free. */
+  int start; /* File offset of data[0]. */
+  int len; /* Bytes read ahead, or pending write. */
+  int dirty; /* The data is pending write. */
+  int hostpos; /* Host file position, -1 if not known. */
+  char data[OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE];
+};
+
+static struct fdcache fdcaches[OS_INTEGER_SEMIHOSTING_FILE_CACHES];
+
+#endif /* defined(OS_USE_SEMIHOSTING_FILE_CACHE) */
+
 /* User file descriptors (fd) are integer indexes into
  the openfiles[] array. Error checking is done by using
  findslot().
@@ -692,6 +742,9 @@ initialise_monitor_handles (void)
   for (i = 0; i < MAX_OPEN_FILES; i++)
     {
       openfiles[i].handle = -1;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+      openfiles[i].cache = NULL;
+#endif
     }
 
   openfiles[0].handle = monitor_stdin;
@@ -728,6 +781,239 @@ checkerror (int result)
   return result;
 }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+
+static void
+fdcache_attach (struct fdent* pfd)
+{
+  for (int i = 0; i < OS_INTEGER_SEMIHOSTING_FILE_CACHES; i++)
+    {
+      struct fdcache* c = &fdcaches[i];
+      if (c->owner == NULL)
+        {
+          c->owner = pfd;
+          c->start = 0;
+          c->len = 0;
+          c->dirty = 0;
+          c->hostpos = 0;
+          pfd->cache = c;
+          return;
+        }
+    }
+}
+
+static void
+fdcache_detach (struct fdent* pfd)
+{
+  pfd->cache->owner = NULL;
+  pfd->cache = NULL;
+}
+
+/* Move the host file position, only if needed. */
+static int
+fdcache_seek_host (struct fdent* pfd, int pos)
+{
+  struct fdcache* c = pfd->cache;
+  if (c->hostpos == pos)
+    {
+      return 0;
+    }
+
+  int block[2];
+  block[0] = pfd->handle;
+  block[1] = pos;
+  if (checkerror (call_host (SEMIHOSTING_SYS_SEEK, block)) < 0)
+    {
+      c->hostpos = -1;
+      return -1;
+    }
+
+  c->hostpos = pos;
+  return 0;
+}
+
+/* Send the write-behind data to the host. */
+static int
+fdcache_flush (struct fdent* pfd)
+{
+  struct fdcache* c = pfd->cache;
+  if (!c->dirty)
+    {
+      return 0;
+    }
+
+  int len = c->len;
+  c->dirty = 0;
+  c->len = 0;
+
+  if (fdcache_seek_host (pfd, c->start) < 0)
+    {
+      return -1;
+    }
+
+  int res = _swiwrite (pfd->handle, c->data, len);
+  if (res < 0)
+    {
+      c->hostpos = -1;
+      return -1;
+    }
+
+  c->hostpos += len - res;
+  if (res != 0)
+    {
+      /* The error is reported later than the write() that caused it. */
+      errno = EIO;
+      return -1;
+    }
+
+  return 0;
+}
+
+static void
+fdcache_flush_all (void)
+{
+  for (int i = 0; i < OS_INTEGER_SEMIHOSTING_FILE_CACHES; i++)
+    {
+      if (fdcaches[i].owner != NULL)
+        {
+          fdcache_flush (fdcaches[i].owner);
+        }
+    }
+}
+
+static int
+fdcache_read (struct fdent* pfd, char* ptr, int len)
+{
+  struct fdcache* c = pfd->cache;
+  if (fdcache_flush (pfd) < 0)
+    {
+      return -1;
+    }
+
+  int done = 0;
+  while (done < len)
+    {
+      int pos = pfd->pos;
+      if (pos >= c->start && pos < c->start + c->len)
+        {
+          /* Hit, copy from the buffer. */
+          int n = c->start + c->len - pos;
+          if (n > len - done)
+            {
+              n = len - done;
+            }
+          memcpy (ptr + done, c->data + (pos - c->start), (size_t) n);
+          done += n;
+          pfd->pos += n;
+          continue;
+        }
+
+      if (fdcache_seek_host (pfd, pos) < 0)
+        {
+          return (done > 0) ? done : -1;
+        }
+
+      int togo = len - done;
+      if (togo >= OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE)
+        {
+          /* Large reads go directly to the user buffer. */
+          int res = _swiread (pfd->handle, ptr + done, togo);
+          if (res == -1)
+            {
+              c->hostpos = -1;
+              return (done > 0) ? done : -1;
+            }
+          c->hostpos += togo - res;
+          pfd->pos += togo - res;
+          done += togo - res;
+          break;
+        }
+
+      /* Miss, read ahead a full block. */
+      int res = _swiread (pfd->handle, c->data,
+                          OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE);
+      if (res == -1)
+        {
+          c->len = 0;
+          c->hostpos = -1;
+          return (done > 0) ? done : -1;
+        }
+      c->start = pos;
+      c->len = OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE - res;
+      c->hostpos = pos + c->len;
+      if (c->len == 0)
+        {
+          /* End of file. */
+          break;
+        }
+    }
+
+  return done;
+}
+
+static int
+fdcache_write (struct fdent* pfd, char* ptr, int len)
+{
+  struct fdcache* c = pfd->cache;
+
+  /* Only consecutive writes are collected. */
+  if (c->dirty && (pfd->pos != c->start + c->len))
+    {
+      if (fdcache_flush (pfd) < 0)
+        {
+          return -1;
+        }
+    }
+
+  if (!c->dirty)
+    {
+      /* Drop the read-ahead data, it may overlap the new data. */
+      c->start = pfd->pos;
+      c->len = 0;
+    }
+
+  if (c->len + len > OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE)
+    {
+      if (fdcache_flush (pfd) < 0)
+        {
+          return -1;
+        }
+
+      if (len >= OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE)
+        {
+          /* Large writes go directly to the host. */
+          if (fdcache_seek_host (pfd, pfd->pos) < 0)
+            {
+              return -1;
+            }
+          int res = _swiwrite (pfd->handle, ptr, len);
+          if (res < 0)
+            {
+              c->hostpos = -1;
+              return -1;
+            }
+          c->hostpos += len - res;
+          pfd->pos += len - res;
+          if ((len - res) == 0)
+            {
+              return error (0);
+            }
+          return len - res;
+        }
+
+      c->start = pfd->pos;
+    }
+
+  memcpy (c->data + c->len, ptr, (size_t) len);
+  c->len += len;
+  c->dirty = 1;
+  pfd->pos += len;
+
+  return len;
+}
+
+#endif /* defined(OS_USE_SEMIHOSTING_FILE_CACHE) */
+
 /* fh, is a valid internal file handle.
  ptr, is a null terminated string.
  len, is the length in bytes to read.
@@ -760,6 +1046,13 @@ _read (int fd, char* ptr, int len)
       return -1;
     }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  if (pfd->cache != NULL)
+    {
+      return fdcache_read (pfd, ptr, len);
+    }
+#endif
+
   res = _swiread (pfd->handle, ptr, len);
 
   if (res == -1)
@@ -796,6 +1089,15 @@ _swilseek (int fd, int ptr, int dir)
       return -1;
     }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  /* SEEK_END needs the host file length, which does not include
+   the write-behind data. */
+  if ((pfd->cache != NULL) && (fdcache_flush (pfd) < 0))
+    {
+      return -1;
+    }
+#endif
+
   /* Convert SEEK_CUR to SEEK_SET */
   if (dir == SEEK_CUR)
     {
@@ -825,6 +1127,20 @@ _swilseek (int fd, int ptr, int dir)
       ptr += res;
     }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  if (pfd->cache != NULL)
+    {
+      if (ptr < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      /* The host position is set by the next transfer, if needed. */
+      pfd->pos = ptr;
+      return ptr;
+    }
+#endif
+
   /* This code only does absolute seeks.  */
   block[0] = pfd->handle;
   block[1] = ptr;
@@ -876,6 +1192,13 @@ _write (int fd, char* ptr, int len)
       return -1;
     }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  if (pfd->cache != NULL)
+    {
+      return fdcache_write (pfd, ptr, len);
+    }
+#endif
+
   res = _swiwrite (pfd->handle, ptr, len);
 
   /* Clearly an error. */
@@ -961,6 +1284,13 @@ _swiopen (const char* path, int flags)
     {
       openfiles[fd].handle = fh;
       openfiles[fd].pos = 0;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+      openfiles[fd].cache = NULL;
+      if (!(flags & O_APPEND) && (strcmp (path, ":tt") != 0))
+        {
+          fdcache_attach (&openfiles[fd]);
+        }
+#endif
       return fd;
     }
   else
@@ -1003,6 +1333,21 @@ _close (int fd)
       return 0;
     }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  if (pfd->cache != NULL)
+    {
+      /* Report the write-behind errors, but close the file anyway. */
+      int flushed = fdcache_flush (pfd);
+      fdcache_detach (pfd);
+      res = _swiclose (pfd->handle);
+      if (res == 0)
+        {
+          pfd->handle = -1;
+        }
+      return (flushed < 0) ? -1 : res;
+    }
+#endif
+
   /* Attempt to close the handle. */
   res = _swiclose (pfd->handle);
 
@@ -1038,6 +1383,13 @@ _swistat (int fd, struct stat* st)
    with 1024 byte blocks. */
   st->st_mode |= S_IFCHR;
   st->st_blksize = 1024;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  /* The host file length does not include the write-behind data. */
+  if ((pfd->cache != NULL) && (fdcache_flush (pfd) < 0))
+    {
+      return -1;
+    }
+#endif
   res = checkerror (call_host (SEMIHOSTING_SYS_FLEN, &pfd->handle));
   if (res == -1)
     {
@@ -1235,6 +1587,97 @@ getcwd (char *buf, size_t size)
   return buf;
 }
 
+#if defined(OS_USE_BENCH)
+
+// ----- Benchmarks -----------------------------------------------------------
+
+#include "diag/Bench.h"
+
+/* Write, read back and randomly read a 4 KB file on the host, in
+ requests of 64 bytes; each run opens and closes the file, and the
+ random reads run after the write, in the registration order. The
+ bytes transferred by a run are reported, so the throughput is
+ bytes * clock / cycles (the clock is printed before the results);
+ 0 bytes means the host did not open the file. Compare the results
+ with and without OS_USE_SEMIHOSTING_FILE_CACHE.
+
+ The file is left in the current folder of the debugger. */
+
+#define SYSCALLS_BENCH_FILE "semihosting-bench.tmp"
+#define SYSCALLS_BENCH_SIZE (4096)
+#define SYSCALLS_BENCH_CHUNK (64)
+
+static char syscalls_bench_buffer[SYSCALLS_BENCH_CHUNK];
+
+BENCH(semihosting_write_4k)
+{
+  int bytes = 0;
+  int fd = _open (SYSCALLS_BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC);
+  if (fd >= 0)
+    {
+      for (int i = 0; i < SYSCALLS_BENCH_SIZE / SYSCALLS_BENCH_CHUNK; ++i)
+        {
+          int ret = _write (fd, syscalls_bench_buffer, SYSCALLS_BENCH_CHUNK);
+          if (ret > 0)
+            {
+              bytes += ret;
+            }
+        }
+      _close (fd);
+    }
+  bench_report ("bytes", (uint32_t) bytes);
+}
+
+BENCH(semihosting_read_4k)
+{
+  int bytes = 0;
+  int fd = _open (SYSCALLS_BENCH_FILE, O_RDONLY);
+  if (fd >= 0)
+    {
+      for (int i = 0; i < SYSCALLS_BENCH_SIZE / SYSCALLS_BENCH_CHUNK; ++i)
+        {
+          int ret = _read (fd, syscalls_bench_buffer, SYSCALLS_BENCH_CHUNK);
+          if (ret > 0)
+            {
+              bytes += ret;
+            }
+        }
+      _close (fd);
+    }
+  bench_report ("bytes", (uint32_t) bytes);
+}
+
+BENCH(semihosting_seek_read_4k)
+{
+  int bytes = 0;
+  int fd = _open (SYSCALLS_BENCH_FILE, O_RDONLY);
+  if (fd >= 0)
+    {
+      /* The same pseudo-random sequence of chunks in each run. */
+      uint32_t seed = 1;
+      for (int i = 0; i < SYSCALLS_BENCH_SIZE / SYSCALLS_BENCH_CHUNK; ++i)
+        {
+          seed = seed * 1103515245u + 12345u;
+          int pos = (int) ((seed >> 16)
+              % (SYSCALLS_BENCH_SIZE / SYSCALLS_BENCH_CHUNK))
+              * SYSCALLS_BENCH_CHUNK;
+          if (_lseek (fd, pos, SEEK_SET) == pos)
+            {
+              int ret = _read (fd, syscalls_bench_buffer,
+                               SYSCALLS_BENCH_CHUNK);
+              if (ret > 0)
+                {
+                  bytes += ret;
+                }
+            }
+        }
+      _close (fd);
+    }
+  bench_report ("bytes", (uint32_t) bytes);
+}
+
+#endif // defined(OS_USE_BENCH)
+
 #endif // defined OS_USE_SEMIHOSTING
 
 #endif // __STDC_HOSTED__ == 1
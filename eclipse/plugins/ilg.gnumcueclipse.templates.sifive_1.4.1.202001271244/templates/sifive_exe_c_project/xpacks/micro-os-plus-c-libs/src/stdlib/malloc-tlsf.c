@@ -0,0 +1,731 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_HEAP_TLSF)
+
+#include <micro-os-plus/startup/initialize-hooks.h>
+#include <micro-os-plus/architecture.h>
+#include <newlib/heap.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <reent.h>
+
+// ----------------------------------------------------------------------------
+
+// A replacement for the newlib malloc(), which is not deterministic
+// and takes its memory from _sbrk(). The allocator is described in
+// newlib/heap.h; the newlib reentrant entry points (_malloc_r & co)
+// are also defined, so the library version is never linked.
+//
+// The functions newlib defines in the same module as its malloc
+// (mallinfo(), malloc_stats(), malloc_trim()) are not available;
+// use heap_get_stats() instead.
+
+#if (OS_INTEGER_HEAP_SL_LOG2 > 5) || (HEAP_CLASSES > 32) || (HEAP_CLASSES < 1)
+#error "Unsupported OS_INTEGER_HEAP_SL_LOG2/OS_INTEGER_HEAP_FL_MAX"
+#endif
+
+#define HEAP_ALIGN ((size_t) 1 << HEAP_ALIGN_LOG2)
+
+#define HEAP_SL_COUNT (1u << OS_INTEGER_HEAP_SL_LOG2)
+#define HEAP_FL_SHIFT (OS_INTEGER_HEAP_SL_LOG2 + HEAP_ALIGN_LOG2)
+#define HEAP_SMALL_SIZE ((size_t) 1 << HEAP_FL_SHIFT)
+
+typedef struct heap_block_s
+{
+  // The payload size; bit 0 is set while the block is free.
+  size_t size;
+  // The previous block in the same region, or NULL for the first one.
+  struct heap_block_s* prev_phys;
+
+  // Valid only while the block is free, they use the payload.
+  struct heap_block_s* next_free;
+  struct heap_block_s* prev_free;
+} heap_block_t;
+
+#define HEAP_BLOCK_FREE ((size_t) 1)
+
+#define HEAP_HEADER_SIZE (offsetof(heap_block_t, next_free))
+#define HEAP_MIN_PAYLOAD (sizeof(heap_block_t) - HEAP_HEADER_SIZE)
+#define HEAP_MAX_PAYLOAD (((size_t) 1 << OS_INTEGER_HEAP_FL_MAX) - HEAP_ALIGN)
+
+// Each region ends with a zero size, never free, sentinel block.
+#define HEAP_REGION_OVERHEAD (2 * HEAP_HEADER_SIZE)
+
+static struct
+{
+  uint32_t fl_bitmap;
+  uint32_t sl_bitmap[HEAP_CLASSES];
+  heap_block_t* free_lists[HEAP_CLASSES][HEAP_SL_COUNT];
+
+  heap_stats_t stats;
+} heap;
+
+// ----------------------------------------------------------------------------
+
+static inline __attribute__((always_inline)) riscv_arch_register_t
+_heap_lock (void)
+{
+  return riscv_csr_clear_mstatus_bits (RISCV_CSR_MSTATUS_MIE);
+}
+
+static inline __attribute__((always_inline)) void
+_heap_unlock (riscv_arch_register_t mstatus)
+{
+  if (mstatus & RISCV_CSR_MSTATUS_MIE)
+    {
+      riscv_csr_set_mstatus_bits (RISCV_CSR_MSTATUS_MIE);
+    }
+}
+
+// Index of the most significant bit set.
+static inline unsigned int
+_heap_fls (size_t x)
+{
+  return (unsigned int) (sizeof(unsigned long) * 8 - 1)
+      - (unsigned int) __builtin_clzl ((unsigned long) x);
+}
+
+static inline size_t
+_heap_block_size (const heap_block_t* block)
+{
+  return block->size & ~HEAP_BLOCK_FREE;
+}
+
+static inline void*
+_heap_block_payload (heap_block_t* block)
+{
+  return (char*) block + HEAP_HEADER_SIZE;
+}
+
+static inline heap_block_t*
+_heap_payload_block (void* ptr)
+{
+  return (heap_block_t*) ((char*) ptr - HEAP_HEADER_SIZE);
+}
+
+static inline heap_block_t*
+_heap_block_next (heap_block_t* block)
+{
+  return (heap_block_t*) ((char*) _heap_block_payload (block)
+      + _heap_block_size (block));
+}
+
+// Round a request up to a valid payload size; the caller
+// must check it against HEAP_MAX_PAYLOAD first.
+static inline size_t
+_heap_adjust_size (size_t size)
+{
+  if (size < HEAP_MIN_PAYLOAD)
+    {
+      return HEAP_MIN_PAYLOAD;
+    }
+  return (size + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+}
+
+// The list where a block of this size is kept.
+static void
+_heap_mapping_insert (size_t size, unsigned int* fl, unsigned int* sl)
+{
+  if (size < HEAP_SMALL_SIZE)
+    {
+      *fl = 0;
+      *sl = (unsigned int) (size >> HEAP_ALIGN_LOG2);
+    }
+  else
+    {
+      unsigned int f = _heap_fls (size);
+      *sl = (unsigned int) (size >> (f - OS_INTEGER_HEAP_SL_LOG2))
+          ^ HEAP_SL_COUNT;
+      *fl = f - (HEAP_FL_SHIFT - 1);
+    }
+}
+
+// The first list where all blocks are large enough for this size;
+// rounding up avoids searching inside the lists.
+static void
+_heap_mapping_search (size_t size, unsigned int* fl, unsigned int* sl)
+{
+  if (size >= HEAP_SMALL_SIZE)
+    {
+      size += ((size_t) 1 << (_heap_fls (size) - OS_INTEGER_HEAP_SL_LOG2))
+          - 1;
+    }
+  _heap_mapping_insert (size, fl, sl);
+}
+
+static heap_block_t*
+_heap_find_free (size_t size)
+{
+  unsigned int fl;
+  unsigned int sl;
+  _heap_mapping_search (size, &fl, &sl);
+  if (fl >= HEAP_CLASSES)
+    {
+      return NULL;
+    }
+
+  uint32_t sl_map = heap.sl_bitmap[fl] & (~0u << sl);
+  if (sl_map == 0)
+    {
+      // Nothing left in this class, take the next non empty one.
+      uint32_t fl_map =
+          (fl + 1 < 32) ? (heap.fl_bitmap & (~0u << (fl + 1))) : 0;
+      if (fl_map == 0)
+        {
+          return NULL;
+        }
+      fl = (unsigned int) __builtin_ctz (fl_map);
+      sl_map = heap.sl_bitmap[fl];
+    }
+  sl = (unsigned int) __builtin_ctz (sl_map);
+
+  return heap.free_lists[fl][sl];
+}
+
+static void
+_heap_insert_free (heap_block_t* block)
+{
+  unsigned int fl;
+  unsigned int sl;
+  _heap_mapping_insert (_heap_block_size (block), &fl, &sl);
+
+  heap_block_t* head = heap.free_lists[fl][sl];
+  block->next_free = head;
+  block->prev_free = NULL;
+  if (head != NULL)
+    {
+      head->prev_free = block;
+    }
+  heap.free_lists[fl][sl] = block;
+  heap.fl_bitmap |= (1u << fl);
+  heap.sl_bitmap[fl] |= (1u << sl);
+
+  block->size |= HEAP_BLOCK_FREE;
+  heap.stats.free_blocks++;
+  heap.stats.free_bytes += _heap_block_size (block);
+}
+
+static void
+_heap_remove_free (heap_block_t* block)
+{
+  unsigned int fl;
+  unsigned int sl;
+  _heap_mapping_insert (_heap_block_size (block), &fl, &sl);
+
+  if (block->next_free != NULL)
+    {
+      block->next_free->prev_free = block->prev_free;
+    }
+  if (block->prev_free != NULL)
+    {
+      block->prev_free->next_free = block->next_free;
+    }
+  else
+    {
+      heap.free_lists[fl][sl] = block->next_free;
+      if (block->next_free == NULL)
+        {
+          heap.sl_bitmap[fl] &= ~(1u << sl);
+          if (heap.sl_bitmap[fl] == 0)
+            {
+              heap.fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+
+  block->size &= ~HEAP_BLOCK_FREE;
+  heap.stats.free_blocks--;
+  heap.stats.free_bytes -= _heap_block_size (block);
+}
+
+// Merge a no longer used block with its free neighbours
+// and add the result to the free lists.
+static void
+_heap_release (heap_block_t* block)
+{
+  heap_block_t* prev = block->prev_phys;
+  if (prev != NULL && (prev->size & HEAP_BLOCK_FREE))
+    {
+      _heap_remove_free (prev);
+      prev->size += HEAP_HEADER_SIZE + _heap_block_size (block);
+      block = prev;
+      _heap_block_next (block)->prev_phys = block;
+    }
+
+  heap_block_t* next = _heap_block_next (block);
+  if (next->size & HEAP_BLOCK_FREE)
+    {
+      _heap_remove_free (next);
+      block->size += HEAP_HEADER_SIZE + _heap_block_size (next);
+      _heap_block_next (block)->prev_phys = block;
+    }
+
+  _heap_insert_free (block);
+}
+
+// Shrink a used block to the given size, if the remaining
+// space is large enough to be a block by itself.
+static void
+_heap_trim (heap_block_t* block, size_t size)
+{
+  size_t block_size = _heap_block_size (block);
+  if (block_size < size + HEAP_HEADER_SIZE + HEAP_MIN_PAYLOAD)
+    {
+      return;
+    }
+
+  heap_block_t* rest = (heap_block_t*) ((char*) _heap_block_payload (block)
+      + size);
+  rest->size = block_size - size - HEAP_HEADER_SIZE;
+  rest->prev_phys = block;
+  block->size = size;
+  _heap_block_next (rest)->prev_phys = rest;
+
+  _heap_release (rest);
+}
+
+static void
+_heap_account_alloc (heap_block_t* block)
+{
+  unsigned int fl;
+  unsigned int sl;
+  _heap_mapping_insert (_heap_block_size (block), &fl, &sl);
+
+  heap.stats.class_allocated[fl]++;
+  heap.stats.allocated_blocks++;
+  heap.stats.used_bytes += HEAP_HEADER_SIZE + _heap_block_size (block);
+  if (heap.stats.used_bytes > heap.stats.max_used_bytes)
+    {
+      heap.stats.max_used_bytes = heap.stats.used_bytes;
+    }
+}
+
+static void
+_heap_account_free (heap_block_t* block)
+{
+  unsigned int fl;
+  unsigned int sl;
+  _heap_mapping_insert (_heap_block_size (block), &fl, &sl);
+
+  heap.stats.class_allocated[fl]--;
+  heap.stats.allocated_blocks--;
+  heap.stats.used_bytes -= HEAP_HEADER_SIZE + _heap_block_size (block);
+}
+
+static void
+_heap_add_region_locked (char* begin, char* end)
+{
+  begin = (char*) (((uintptr_t) begin + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1));
+  end = (char*) ((uintptr_t) end & ~(HEAP_ALIGN - 1));
+
+  // Regions too large for one block are split in several ones.
+  while (end > begin
+      && (size_t) (end - begin) >= HEAP_REGION_OVERHEAD + HEAP_MIN_PAYLOAD)
+    {
+      size_t size = (size_t) (end - begin) - HEAP_REGION_OVERHEAD;
+      if (size > HEAP_MAX_PAYLOAD)
+        {
+          size = HEAP_MAX_PAYLOAD;
+        }
+
+      heap_block_t* block = (heap_block_t*) begin;
+      block->size = size;
+      block->prev_phys = NULL;
+
+      heap_block_t* sentinel = _heap_block_next (block);
+      sentinel->size = 0;
+      sentinel->prev_phys = block;
+
+      heap.stats.total_bytes += HEAP_HEADER_SIZE + size;
+      _heap_insert_free (block);
+
+      begin = (char*) sentinel + HEAP_HEADER_SIZE;
+    }
+}
+
+static void*
+_heap_malloc_locked (size_t size)
+{
+  heap_block_t* block = NULL;
+  if (size <= HEAP_MAX_PAYLOAD)
+    {
+      size = _heap_adjust_size (size);
+      block = _heap_find_free (size);
+    }
+  if (block == NULL)
+    {
+      heap.stats.failed_allocations++;
+      return NULL;
+    }
+
+  _heap_remove_free (block);
+  _heap_trim (block, size);
+  _heap_account_alloc (block);
+
+  return _heap_block_payload (block);
+}
+
+static void*
+_heap_malloc (size_t size)
+{
+  riscv_arch_register_t mstatus = _heap_lock ();
+  void* ptr = _heap_malloc_locked (size);
+  _heap_unlock (mstatus);
+
+  return ptr;
+}
+
+static void
+_heap_free (void* ptr)
+{
+  if (ptr == NULL)
+    {
+      return;
+    }
+
+  heap_block_t* block = _heap_payload_block (ptr);
+
+  riscv_arch_register_t mstatus = _heap_lock ();
+  _heap_account_free (block);
+  _heap_release (block);
+  _heap_unlock (mstatus);
+}
+
+static void*
+_heap_realloc (void* ptr, size_t size)
+{
+  if (ptr == NULL)
+    {
+      return _heap_malloc (size);
+    }
+  if (size == 0)
+    {
+      _heap_free (ptr);
+      return NULL;
+    }
+  if (size > HEAP_MAX_PAYLOAD)
+    {
+      return NULL;
+    }
+
+  heap_block_t* block = _heap_payload_block (ptr);
+  size_t adjusted = _heap_adjust_size (size);
+
+  riscv_arch_register_t mstatus = _heap_lock ();
+
+  size_t block_size = _heap_block_size (block);
+  heap_block_t* next = _heap_block_next (block);
+  if (adjusted <= block_size
+      || ((next->size & HEAP_BLOCK_FREE)
+          && block_size + HEAP_HEADER_SIZE + _heap_block_size (next)
+              >= adjusted))
+    {
+      // Resize in place, shrinking or taking from the next block.
+      _heap_account_free (block);
+      if (adjusted > block_size)
+        {
+          _heap_remove_free (next);
+          block->size += HEAP_HEADER_SIZE + _heap_block_size (next);
+          _heap_block_next (block)->prev_phys = block;
+        }
+      _heap_trim (block, adjusted);
+      _heap_account_alloc (block);
+
+      _heap_unlock (mstatus);
+      return ptr;
+    }
+
+  _heap_unlock (mstatus);
+
+  // Move it; the copy is done with the interrupts enabled.
+  void* new_ptr = _heap_malloc (size);
+  if (new_ptr != NULL)
+    {
+      memcpy (new_ptr, ptr, block_size);
+      _heap_free (ptr);
+    }
+  return new_ptr;
+}
+
+static void*
+_heap_memalign (size_t alignment, size_t size)
+{
+  if (alignment <= HEAP_ALIGN)
+    {
+      return _heap_malloc (size);
+    }
+  if ((alignment & (alignment - 1)) != 0 || size > HEAP_MAX_PAYLOAD
+      || alignment > HEAP_MAX_PAYLOAD)
+    {
+      return NULL;
+    }
+
+  size_t adjusted = _heap_adjust_size (size);
+  // Leave room for a free block before the aligned payload.
+  size_t gap_min = HEAP_HEADER_SIZE + HEAP_MIN_PAYLOAD;
+
+  riscv_arch_register_t mstatus = _heap_lock ();
+
+  char* ptr = _heap_malloc_locked (adjusted + alignment + gap_min);
+  if (ptr != NULL)
+    {
+      char* aligned = (char*) (((uintptr_t) ptr + alignment - 1)
+          & ~(alignment - 1));
+      if (aligned != ptr && (size_t) (aligned - ptr) < gap_min)
+        {
+          aligned = (char*) (((uintptr_t) ptr + gap_min + alignment - 1)
+              & ~(alignment - 1));
+        }
+
+      heap_block_t* block = _heap_payload_block (ptr);
+      _heap_account_free (block);
+
+      if (aligned != ptr)
+        {
+          // Give back the space before the aligned payload.
+          size_t gap = (size_t) (aligned - ptr);
+          heap_block_t* aligned_block = _heap_payload_block (aligned);
+          aligned_block->size = _heap_block_size (block) - gap;
+          aligned_block->prev_phys = block;
+          _heap_block_next (aligned_block)->prev_phys = aligned_block;
+          block->size = gap - HEAP_HEADER_SIZE;
+          _heap_release (block);
+
+          block = aligned_block;
+        }
+
+      _heap_trim (block, adjusted);
+      _heap_account_alloc (block);
+      ptr = aligned;
+    }
+
+  _heap_unlock (mstatus);
+  return ptr;
+}
+
+static size_t
+_heap_usable_size (void* ptr)
+{
+  if (ptr == NULL)
+    {
+      return 0;
+    }
+  return _heap_block_size (_heap_payload_block (ptr));
+}
+
+// ----------------------------------------------------------------------------
+
+// Called by the startup code, before the static constructors.
+void
+os_startup_initialize_free_store (void* heap_address, size_t heap_size_bytes)
+{
+  heap_add_region (heap_address, heap_size_bytes);
+}
+
+int
+heap_add_region (void* begin, size_t size)
+{
+  riscv_arch_register_t mstatus = _heap_lock ();
+  size_t total_bytes = heap.stats.total_bytes;
+  _heap_add_region_locked ((char*) begin, (char*) begin + size);
+  int ret = (heap.stats.total_bytes == total_bytes) ? -1 : 0;
+
+  _heap_unlock (mstatus);
+  return ret;
+}
+
+void
+heap_get_stats (heap_stats_t* stats)
+{
+  riscv_arch_register_t mstatus = _heap_lock ();
+  *stats = heap.stats;
+
+  // The largest free block is in the highest non empty list.
+  size_t largest = 0;
+  if (heap.fl_bitmap != 0)
+    {
+      unsigned int fl = _heap_fls (heap.fl_bitmap);
+      unsigned int sl = _heap_fls (heap.sl_bitmap[fl]);
+      for (heap_block_t* block = heap.free_lists[fl][sl]; block != NULL;
+          block = block->next_free)
+        {
+          if (_heap_block_size (block) > largest)
+            {
+              largest = _heap_block_size (block);
+            }
+        }
+    }
+
+  _heap_unlock (mstatus);
+
+  stats->largest_free_bytes = largest;
+  stats->fragmentation =
+      (stats->free_bytes != 0) ?
+          (unsigned int) (100
+              - (uint64_t) largest * 100 / stats->free_bytes) :
+          0;
+}
+
+// ----------------------------------------------------------------------------
+
+void*
+malloc (size_t size)
+{
+  void* ptr = _heap_malloc (size);
+  if (ptr == NULL)
+    {
+      errno = ENOMEM;
+    }
+  return ptr;
+}
+
+void
+free (void* ptr)
+{
+  _heap_free (ptr);
+}
+
+void*
+calloc (size_t count, size_t size)
+{
+  if (size != 0 && count > SIZE_MAX / size)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  void* ptr = malloc (count * size);
+  if (ptr != NULL)
+    {
+      memset (ptr, 0, count * size);
+    }
+  return ptr;
+}
+
+void*
+realloc (void* ptr, size_t size)
+{
+  void* new_ptr = _heap_realloc (ptr, size);
+  if (new_ptr == NULL && size != 0)
+    {
+      errno = ENOMEM;
+    }
+  return new_ptr;
+}
+
+void*
+memalign (size_t alignment, size_t size)
+{
+  void* ptr = _heap_memalign (alignment, size);
+  if (ptr == NULL)
+    {
+      errno = ENOMEM;
+    }
+  return ptr;
+}
+
+size_t
+malloc_usable_size (void* ptr)
+{
+  return _heap_usable_size (ptr);
+}
+
+// The reentrant versions, called by the newlib internals.
+
+void*
+_malloc_r (struct _reent* r, size_t size)
+{
+  void* ptr = _heap_malloc (size);
+  if (ptr == NULL)
+    {
+      r->_errno = ENOMEM;
+    }
+  return ptr;
+}
+
+void
+_free_r (struct _reent* r __attribute__((unused)), void* ptr)
+{
+  _heap_free (ptr);
+}
+
+void*
+_calloc_r (struct _reent* r, size_t count, size_t size)
+{
+  void* ptr = NULL;
+  if (size == 0 || count <= SIZE_MAX / size)
+    {
+      ptr = _heap_malloc (count * size);
+    }
+  if (ptr == NULL)
+    {
+      r->_errno = ENOMEM;
+    }
+  else
+    {
+      memset (ptr, 0, count * size);
+    }
+  return ptr;
+}
+
+void*
+_realloc_r (struct _reent* r, void* ptr, size_t size)
+{
+  void* new_ptr = _heap_realloc (ptr, size);
+  if (new_ptr == NULL && size != 0)
+    {
+      r->_errno = ENOMEM;
+    }
+  return new_ptr;
+}
+
+void*
+_memalign_r (struct _reent* r, size_t alignment, size_t size)
+{
+  void* ptr = _heap_memalign (alignment, size);
+  if (ptr == NULL)
+    {
+      r->_errno = ENOMEM;
+    }
+  return ptr;
+}
+
+size_t
+_malloc_usable_size_r (struct _reent* r __attribute__((unused)), void* ptr)
+{
+  return _heap_usable_size (ptr);
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // defined(OS_USE_HEAP_TLSF)
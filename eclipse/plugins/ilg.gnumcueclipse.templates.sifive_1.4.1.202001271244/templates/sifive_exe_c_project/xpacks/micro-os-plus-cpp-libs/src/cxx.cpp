@@ -78,6 +78,60 @@ extern "C"
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_CXX_LIGHT_GUARDS)
+
+// Guards for the static local objects, for single core applications
+// compiled with thread safe statics. Instead of the library mutex and
+// condition variable, the second byte of the guard marks the
+// initialisation in progress, to catch the recursive initialisations
+// (or those started again from an interrupt handler), which abort.
+// The compiler checks the first byte inline, so a guarded object
+// usually costs one load and one branch.
+
+#include <cxxabi.h>
+
+namespace __cxxabiv1
+{
+  extern "C"
+  {
+    int
+    __cxa_guard_acquire (__guard* guard)
+    {
+      unsigned char* bytes = reinterpret_cast<unsigned char*> (guard);
+      if (bytes[0] != 0)
+        {
+          return 0;
+        }
+      if (bytes[1] != 0)
+        {
+          os::trace::puts (__func__);
+          abort ();
+        }
+      bytes[1] = 1;
+      return 1;
+    }
+
+    void
+    __cxa_guard_release (__guard* guard)
+    {
+      unsigned char* bytes = reinterpret_cast<unsigned char*> (guard);
+      bytes[1] = 0;
+      bytes[0] = 1;
+    }
+
+    void
+    __cxa_guard_abort (__guard* guard)
+    {
+      unsigned char* bytes = reinterpret_cast<unsigned char*> (guard);
+      bytes[1] = 0;
+    }
+  }
+}
+
+#endif // defined(OS_USE_CXX_LIGHT_GUARDS)
+
+// ----------------------------------------------------------------------------
+
 void *__dso_handle __attribute__ ((weak));
 
 // ----------------------------------------------------------------------------
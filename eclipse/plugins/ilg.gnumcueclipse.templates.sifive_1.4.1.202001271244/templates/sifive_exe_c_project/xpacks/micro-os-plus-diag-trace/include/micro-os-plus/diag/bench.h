@@ -0,0 +1,159 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MICRO_OS_PLUS_DIAG_BENCH_H_
+#define MICRO_OS_PLUS_DIAG_BENCH_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif /* __cplusplus */
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Microbenchmarks, enabled by OS_USE_BENCH.
+ *
+ * A benchmark is defined with `BENCH(name) { body }` (or registered
+ * with `bench_register()`, for example to pass a parameter), and
+ * `bench_run_all()` runs all of them: `OS_INTEGER_BENCH_WARMUP` times
+ * without measuring, then `OS_INTEGER_BENCH_REPETITIONS` times, each
+ * run timed separately, with the `mcycle` counter and the interrupts
+ * disabled.
+ *
+ * The results are printed on the trace output, one line per
+ * benchmark, easy to parse by a script:
+ *   bench,<name>,<repetitions>,<min>,<median>,<max>
+ * The values are in cycles, with the measurement overhead subtracted.
+ * A benchmark may attach one more result with `bench_report()`, for
+ * example a throughput or a stack size, printed after its line as
+ *   # bench,<name>,<label>,<value>
+ */
+
+#if !defined(OS_INTEGER_BENCH_WARMUP)
+#define OS_INTEGER_BENCH_WARMUP (4)
+#endif
+
+// Odd, so the median is one of the samples.
+#if !defined(OS_INTEGER_BENCH_REPETITIONS)
+#define OS_INTEGER_BENCH_REPETITIONS (31)
+#endif
+
+// Prevent the compiler from optimising away a computed value.
+#define BENCH_KEEP(value) __asm__ volatile ("" : : "g" (value) : "memory")
+
+typedef struct bench_s
+{
+  const char* name;
+  void
+  (*function) (void* arg);
+  void* arg;
+  struct bench_s* next;
+} bench_t;
+
+#if defined(OS_USE_BENCH)
+
+// Registered before main(), by a static constructor.
+#define BENCH(name) \
+  static void \
+  bench_function_##name (void* arg); \
+  static bench_t bench_##name = \
+    { #name, bench_function_##name, NULL, NULL }; \
+  static void __attribute__((constructor)) \
+  bench_register_##name (void) \
+  { \
+    bench_register (&bench_##name); \
+  } \
+  static void \
+  bench_function_##name (void* arg __attribute__((unused)))
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* defined(__cplusplus) */
+
+  /**
+   * @brief Add a benchmark at the end of the list; the object must
+   * not be destroyed.
+   */
+  void
+  bench_register (bench_t* bench);
+
+  /**
+   * @brief Run all benchmarks.
+   * @return The number of benchmarks.
+   */
+  int
+  bench_run_all (void);
+
+  /**
+   * @brief Set the extra result of the running benchmark; the last
+   * value is printed. The label must be a static string.
+   */
+  void
+  bench_report (const char* label, uint32_t value);
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
+#else /* !defined(OS_USE_BENCH) */
+
+#define BENCH(name) \
+  static void __attribute__((unused)) \
+  bench_function_##name (void* arg __attribute__((unused)))
+
+static inline void
+__attribute__((always_inline))
+bench_register (bench_t* bench __attribute__((unused)))
+{
+}
+
+static inline int
+__attribute__((always_inline))
+bench_run_all (void)
+{
+  return 0;
+}
+
+static inline void
+__attribute__((always_inline))
+bench_report (const char* label __attribute__((unused)),
+              uint32_t value __attribute__((unused)))
+{
+}
+
+#endif /* defined(OS_USE_BENCH) */
+
+// ----------------------------------------------------------------------------
+
+#endif /* MICRO_OS_PLUS_DIAG_BENCH_H_ */
@@ -0,0 +1,157 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2015 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(OS_USE_BENCH)
+
+#include <micro-os-plus/architecture.h>
+#include <micro-os-plus/diag/bench.h>
+#include <micro-os-plus/diag/trace.h>
+
+// ----------------------------------------------------------------------------
+
+static bench_t* bench_first;
+static bench_t* bench_last;
+
+static uint32_t bench_samples[OS_INTEGER_BENCH_REPETITIONS];
+
+// The extra result of the running benchmark, if any.
+static const char* bench_label;
+static uint32_t bench_value;
+
+// ----------------------------------------------------------------------------
+
+static void
+bench_empty (void* arg __attribute__((unused)))
+{
+}
+
+// Return the min, median and max of the samples of one benchmark.
+static void
+bench_measure (bench_t* bench, uint32_t* result)
+{
+  for (int i = 0; i < OS_INTEGER_BENCH_WARMUP; ++i)
+    {
+      bench->function (bench->arg);
+    }
+
+  for (int i = 0; i < OS_INTEGER_BENCH_REPETITIONS; ++i)
+    {
+      riscv_arch_register_t mstatus = riscv_csr_clear_mstatus_bits (
+          RISCV_CSR_MSTATUS_MIE);
+
+      // 32-bits are enough for a run.
+      uint32_t begin = riscv_csr_read_mcycle_low ();
+      bench->function (bench->arg);
+      uint32_t end = riscv_csr_read_mcycle_low ();
+
+      if (mstatus & RISCV_CSR_MSTATUS_MIE)
+        {
+          riscv_csr_set_mstatus_bits (RISCV_CSR_MSTATUS_MIE);
+        }
+
+      // Insert in order.
+      uint32_t cycles = end - begin;
+      int j = i;
+      for (; j > 0 && bench_samples[j - 1] > cycles; --j)
+        {
+          bench_samples[j] = bench_samples[j - 1];
+        }
+      bench_samples[j] = cycles;
+    }
+
+  result[0] = bench_samples[0];
+  result[1] = bench_samples[OS_INTEGER_BENCH_REPETITIONS / 2];
+  result[2] = bench_samples[OS_INTEGER_BENCH_REPETITIONS - 1];
+}
+
+// ----------------------------------------------------------------------------
+
+void
+bench_report (const char* label, uint32_t value)
+{
+  bench_label = label;
+  bench_value = value;
+}
+
+void
+bench_register (bench_t* bench)
+{
+  bench->next = NULL;
+  if (bench_last == NULL)
+    {
+      bench_first = bench;
+    }
+  else
+    {
+      bench_last->next = bench;
+    }
+  bench_last = bench;
+}
+
+int
+bench_run_all (void)
+{
+  trace_printf ("# bench,cycles,mcycle\n");
+
+  // The cost of an empty function call, subtracted from all results.
+  bench_t empty =
+    { "empty", bench_empty, NULL, NULL };
+  uint32_t overhead[3];
+  bench_measure (&empty, overhead);
+
+  trace_printf ("# bench,name,repetitions,min,median,max\n");
+
+  int count = 0;
+  for (bench_t* bench = bench_first; bench != NULL; bench = bench->next)
+    {
+      uint32_t result[3];
+      bench_label = NULL;
+      bench_measure (bench, result);
+      for (int i = 0; i < 3; ++i)
+        {
+          result[i] = (result[i] > overhead[0]) ? result[i] - overhead[0] : 0;
+        }
+
+      trace_printf ("bench,%s,%u,%u,%u,%u\n", bench->name,
+                    (unsigned int) OS_INTEGER_BENCH_REPETITIONS,
+                    (unsigned int) result[0], (unsigned int) result[1],
+                    (unsigned int) result[2]);
+      if (bench_label != NULL)
+        {
+          trace_printf ("# bench,%s,%s,%u\n", bench->name, bench_label,
+                        (unsigned int) bench_value);
+        }
+      ++count;
+    }
+
+  trace_printf ("# bench,done,%d\n", count);
+  return count;
+}
+
+// ----------------------------------------------------------------------------
+
+#endif /* defined(OS_USE_BENCH) */
@@ -33,10 +33,26 @@
 #include <cstdio>
 #include <cstring>
 
+// By default vprintf() uses a small local formatter, which supports
+// only integers, characters, strings and pointers, but is reentrant,
+// does not allocate memory and needs only a small stack.
+// Define OS_USE_TRACE_PRINTF_NEWLIB to use the full newlib vsnprintf().
+
+#if defined(OS_USE_TRACE_PRINTF_NEWLIB)
+
 #ifndef OS_INTEGER_TRACE_PRINTF_TMP_ARRAY_SIZE
 #define OS_INTEGER_TRACE_PRINTF_TMP_ARRAY_SIZE (200)
 #endif
 
+#else
+
+// The formatted output is passed to write() in chunks of this size.
+#ifndef OS_INTEGER_TRACE_PRINTF_CHUNK_SIZE
+#define OS_INTEGER_TRACE_PRINTF_CHUNK_SIZE (32)
+#endif
+
+#endif /* defined(OS_USE_TRACE_PRINTF_NEWLIB) */
+
 // ----------------------------------------------------------------------------
 
 namespace os
@@ -82,15 +98,14 @@ namespace os
       return ret;
     }
 
+#if defined(OS_USE_TRACE_PRINTF_NEWLIB)
+
     int __attribute__((weak))
     vprintf (const char* format, std::va_list args)
     {
       // Caution: allocated on the stack!
       char buf[OS_INTEGER_TRACE_PRINTF_TMP_ARRAY_SIZE];
 
-      // TODO: possibly rewrite it to no longer use newlib,
-      // (although the nano version is no longer very heavy).
-
       // Print to the local buffer
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wformat-nonliteral"
@@ -104,6 +119,316 @@ namespace os
       return ret;
     }
 
+#else
+
+    namespace
+    {
+      // Collects the formatted characters and passes them to write()
+      // in small chunks.
+      class printf_output
+      {
+      public:
+
+        void
+        put (char c)
+        {
+          if (len_ == sizeof(buf_))
+            {
+              flush ();
+            }
+          buf_[len_++] = c;
+          ++count_;
+        }
+
+        void
+        pad (char c, int n)
+        {
+          for (; n > 0; --n)
+            {
+              put (c);
+            }
+        }
+
+        void
+        field (const char* prefix, const char* s, int len, int zeros,
+               int width, bool left)
+        {
+          int padding = width - static_cast<int> (std::strlen (prefix))
+              - zeros - len;
+
+          if (!left)
+            {
+              pad (' ', padding);
+            }
+          while (*prefix != '\0')
+            {
+              put (*prefix++);
+            }
+          pad ('0', zeros);
+          for (int i = 0; i < len; ++i)
+            {
+              put (s[i]);
+            }
+          if (left)
+            {
+              pad (' ', padding);
+            }
+        }
+
+        void
+        flush (void)
+        {
+          if (len_ > 0)
+            {
+              write (buf_, len_);
+              len_ = 0;
+            }
+        }
+
+        int
+        count (void) const
+        {
+          return count_;
+        }
+
+      private:
+
+        char buf_[OS_INTEGER_TRACE_PRINTF_CHUNK_SIZE];
+        std::size_t len_ = 0;
+        int count_ = 0;
+      };
+    } /* namespace */
+
+    /**
+     * @details
+     * The local formatter supports:
+     * - the conversions %d, %i, %u, %x, %X, %o, %c, %s, %p and %%
+     * - the flags '-', '0', '#', '+' and ' '
+     * - the field width and precision (including '*')
+     * - the length modifiers hh, h, l, ll, z, t and j; the values
+     *   are converted as `unsigned long`, so on 32-bit cores
+     *   only the low 32-bits of ll values are printed.
+     */
+    int __attribute__((weak))
+    vprintf (const char* format, std::va_list args)
+    {
+      printf_output out;
+
+      for (const char* p = format; *p != '\0'; ++p)
+        {
+          if (*p != '%')
+            {
+              out.put (*p);
+              continue;
+            }
+
+          // Flags.
+          bool left = false;
+          bool zero = false;
+          bool alt = false;
+          char sign = '\0';
+          for (;; ++p)
+            {
+              if (p[1] == '-')
+                left = true;
+              else if (p[1] == '0')
+                zero = true;
+              else if (p[1] == '#')
+                alt = true;
+              else if (p[1] == '+')
+                sign = '+';
+              else if (p[1] == ' ')
+                sign = (sign == '+') ? '+' : ' ';
+              else
+                break;
+            }
+          ++p;
+
+          // Width.
+          int width = 0;
+          if (*p == '*')
+            {
+              width = va_arg(args, int);
+              if (width < 0)
+                {
+                  left = true;
+                  width = -width;
+                }
+              ++p;
+            }
+          for (; *p >= '0' && *p <= '9'; ++p)
+            {
+              width = width * 10 + (*p - '0');
+            }
+
+          // Precision.
+          int precision = -1;
+          if (*p == '.')
+            {
+              ++p;
+              precision = 0;
+              if (*p == '*')
+                {
+                  precision = va_arg(args, int);
+                  ++p;
+                }
+              for (; *p >= '0' && *p <= '9'; ++p)
+                {
+                  precision = precision * 10 + (*p - '0');
+                }
+            }
+
+          // Length modifiers.
+          int longs = 0;
+          for (;; ++p)
+            {
+              if (*p == 'l')
+                ++longs;
+              else if (*p != 'h' && *p != 'z' && *p != 't' && *p != 'j')
+                break;
+            }
+
+          char digits[24];
+          unsigned long value;
+          unsigned int base = 10;
+          const char* prefix = "";
+          bool upper = false;
+
+          switch (*p)
+            {
+            case '%':
+              out.put ('%');
+              continue;
+
+            case 'c':
+              digits[0] = static_cast<char> (va_arg(args, int));
+              out.field ("", digits, 1, 0, width, left);
+              continue;
+
+            case 's':
+              {
+                const char* s = va_arg(args, const char*);
+                if (s == nullptr)
+                  {
+                    s = "(null)";
+                  }
+                int len = 0;
+                while (s[len] != '\0' && (precision < 0 || len < precision))
+                  {
+                    ++len;
+                  }
+                out.field ("", s, len, 0, width, left);
+              }
+              continue;
+
+            case 'p':
+              value = reinterpret_cast<unsigned long> (va_arg(args, void*));
+              base = 16;
+              prefix = "0x";
+              break;
+
+            case 'd':
+            case 'i':
+              {
+                long v;
+                if (longs >= 2)
+                  v = static_cast<long> (va_arg(args, long long));
+                else if (longs == 1)
+                  v = va_arg(args, long);
+                else
+                  v = va_arg(args, int);
+                if (v < 0)
+                  {
+                    prefix = "-";
+                    value = -static_cast<unsigned long> (v);
+                  }
+                else
+                  {
+                    prefix = (sign == '+') ? "+" : ((sign == ' ') ? " " : "");
+                    value = static_cast<unsigned long> (v);
+                  }
+              }
+              break;
+
+            case 'X':
+              upper = true;
+              // Fall through.
+            case 'x':
+            case 'o':
+            case 'u':
+              if (longs >= 2)
+                value = static_cast<unsigned long> (va_arg(
+                    args, unsigned long long));
+              else if (longs == 1)
+                value = va_arg(args, unsigned long);
+              else
+                value = va_arg(args, unsigned int);
+              if (*p == 'o')
+                {
+                  base = 8;
+                  prefix = (alt && (value != 0 || precision == 0)) ? "0" : "";
+                }
+              else if (*p != 'u')
+                {
+                  base = 16;
+                  prefix = (alt && value != 0) ? (upper ? "0X" : "0x") : "";
+                }
+              break;
+
+            default:
+              // Unknown conversion; print it as is.
+              out.put ('%');
+              if (*p == '\0')
+                {
+                  --p;
+                }
+              else
+                {
+                  out.put (*p);
+                }
+              continue;
+            }
+
+          // Convert the number, last digit first; with a precision of 0,
+          // the value 0 is printed as no digits at all.
+          int len = 0;
+          char* d = digits + sizeof(digits);
+          if (value != 0 || precision != 0)
+            {
+              do
+                {
+                  unsigned int r = static_cast<unsigned int> (value % base);
+                  *--d = static_cast<char> (
+                      (r < 10) ? ('0' + r) : ((upper ? 'A' : 'a') + r - 10));
+                  ++len;
+                  value /= base;
+                }
+              while (value != 0);
+            }
+
+          int zeros = 0;
+          if (precision >= 0)
+            {
+              zeros = precision - len;
+            }
+          else if (zero && !left)
+            {
+              zeros = width - len - static_cast<int> (std::strlen (prefix));
+            }
+          if (zeros < 0)
+            {
+              zeros = 0;
+            }
+
+          out.field (prefix, d, len, zeros, width, left);
+        }
+
+      out.flush ();
+      return out.count ();
+    }
+
+#endif /* defined(OS_USE_TRACE_PRINTF_NEWLIB) */
+
     int __attribute__((weak))
     puts (const char* s)
     {
@@ -253,4 +578,135 @@ trace_dump_args (int argc, char* argv[])
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_BENCH)
+
+#include <micro-os-plus/architecture.h>
+#include <micro-os-plus/diag/bench.h>
+
+/*
+ * The same line printed with trace::printf() and with the newlib
+ * vsnprintf() followed by trace::write(), as with
+ * OS_USE_TRACE_PRINTF_NEWLIB (then both are the same). The times
+ * include the output, so compare them on a fast channel; the
+ * semihosting calls take much longer than the formatting.
+ *
+ * The first warm-up run measures the stack used by the call instead,
+ * reported as "stack", in bytes: the free part of the stack, from
+ * its bottom (__heap_end__) to the stack pointer, is painted before
+ * and scanned after, with the interrupts disabled.
+ */
+
+#if OS_INTEGER_BENCH_WARMUP < 1
+#error "The trace benchmarks measure the stack in the first warm-up run"
+#endif
+
+#define TRACE_BENCH_FORMAT "# trace,%s,%5d,0x%08x,%c\n"
+#define TRACE_BENCH_ARGS "bench", -1234, 0xCAFEu, '!'
+
+#define TRACE_BENCH_PAINT (0xCCCCCCCCu)
+
+// The bottom of the stack; defined in the linker script.
+extern uint32_t __heap_end__;
+
+namespace
+{
+  int
+  bench_newlib_printf (const char* format, ...)
+  {
+    std::va_list args;
+    va_start(args, format);
+
+    // Allocated on the stack, as in the newlib vprintf().
+    char buf[200];
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    int ret = ::vsnprintf (buf, sizeof(buf), format, args);
+#pragma GCC diagnostic pop
+    if (ret > 0)
+      {
+        ret = static_cast<int> (trace::write (buf, static_cast<size_t> (ret)));
+      }
+
+    va_end(args);
+    return ret;
+  }
+
+  void
+  bench_printf (void)
+  {
+    trace::printf (TRACE_BENCH_FORMAT, TRACE_BENCH_ARGS);
+  }
+
+  void
+  bench_vsnprintf (void)
+  {
+    bench_newlib_printf (TRACE_BENCH_FORMAT, TRACE_BENCH_ARGS);
+  }
+
+  // Return the bytes of stack used by the function.
+  uint32_t
+  __attribute__((noinline))
+  bench_stack (void
+  (*function) (void))
+  {
+    riscv_arch_register_t mstatus = riscv_csr_clear_mstatus_bits (
+        RISCV_CSR_MSTATUS_MIE);
+
+    uint32_t* sp;
+    __asm__ volatile ("mv %0, sp" : "=r" (sp));
+
+    // Leave some room for the frames of the calls below.
+    uint32_t* bottom = &__heap_end__;
+    for (uint32_t* p = bottom; p < sp - 16; ++p)
+      {
+        *p = TRACE_BENCH_PAINT;
+      }
+
+    function ();
+
+    uint32_t* p = bottom;
+    while (p < sp && *p == TRACE_BENCH_PAINT)
+      {
+        ++p;
+      }
+
+    if (mstatus & RISCV_CSR_MSTATUS_MIE)
+      {
+        riscv_csr_set_mstatus_bits (RISCV_CSR_MSTATUS_MIE);
+      }
+    return static_cast<uint32_t> (sp - p) * 4;
+  }
+
+  void
+  bench_run (void
+  (*function) (void), uint32_t* stack)
+  {
+    if (*stack == 0)
+      {
+        *stack = bench_stack (function);
+        return;
+      }
+    bench_report ("stack", *stack);
+    function ();
+  }
+
+  uint32_t bench_printf_stack;
+  uint32_t bench_vsnprintf_stack;
+} /* namespace */
+
+BENCH(trace_printf)
+{
+  bench_run (bench_printf, &bench_printf_stack);
+}
+
+BENCH(trace_printf_vsnprintf)
+{
+  bench_run (bench_vsnprintf, &bench_vsnprintf_stack);
+}
+
+#endif /* defined(OS_USE_BENCH) */
+
+// ----------------------------------------------------------------------------
+
 #endif /* defined(TRACE) */
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RISCV_ARCH_IRQ_STATS_H_
+#define RISCV_ARCH_IRQ_STATS_H_
+
+#include <riscv-arch/arch-types.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Per interrupt statistics, enabled by OS_USE_IRQ_STATS.
+ *
+ * After `riscv_irq_stats_start()`, the trap handler counts the entries
+ * and measures the `mcycle` cycles spent in each local and global
+ * (PLIC) interrupt handler. When not started, or after
+ * `riscv_irq_stats_stop()`, the overhead is a single test.
+ *
+ * The entry latency (the cycles from the event to the handler) is
+ * known only for the sources with a probe: the machine timer has one
+ * by default (with the RTC resolution), other sources can register
+ * theirs. The latencies are kept in a histogram, bucket 0 for less
+ * than 32 cycles, bucket n for less than 32 << n, and the last one for
+ * the rest.
+ */
+
+#if !defined(OS_INTEGER_IRQ_STATS_BUCKETS)
+#define OS_INTEGER_IRQ_STATS_BUCKETS (10)
+#endif
+
+typedef struct riscv_irq_stats_s
+{
+  uint32_t count;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint32_t latency[OS_INTEGER_IRQ_STATS_BUCKETS];
+} riscv_irq_stats_t;
+
+/*
+ * Return the cycles elapsed since the event that triggered
+ * the interrupt.
+ */
+typedef uint32_t
+(*riscv_irq_stats_probe_t) (void);
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* defined(__cplusplus) */
+
+  void
+  riscv_irq_stats_start (void);
+
+  void
+  riscv_irq_stats_stop (void);
+
+  void
+  riscv_irq_stats_reset (void);
+
+  /*
+   * Return false if the number is not valid.
+   */
+  bool
+  riscv_irq_stats_get_local (uint32_t number, riscv_irq_stats_t* stats);
+
+  bool
+  riscv_irq_stats_get_global (uint32_t number, riscv_irq_stats_t* stats);
+
+  void
+  riscv_irq_stats_set_global_probe (uint32_t number,
+                                    riscv_irq_stats_probe_t probe);
+
+  /*
+   * Print the sources with at least one entry on the trace output.
+   */
+  void
+  riscv_irq_stats_dump (void);
+
+  /*
+   * Called by the trap handler; the index is the local interrupt
+   * number, or the global number after all local ones.
+   */
+  void
+  riscv_irq_stats_dispatch (riscv_core_trap_handler_ptr_t handler,
+                            uint32_t index);
+
+  extern bool riscv_irq_stats_enabled;
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* RISCV_ARCH_IRQ_STATS_H_ */
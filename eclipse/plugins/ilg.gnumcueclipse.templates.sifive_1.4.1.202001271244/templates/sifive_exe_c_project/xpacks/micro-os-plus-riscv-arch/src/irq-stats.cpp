@@ -0,0 +1,216 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(OS_USE_IRQ_STATS)
+
+#include <micro-os-plus/board.h>
+#include <micro-os-plus/diag/trace.h>
+#include <riscv-arch/irq-stats.h>
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+bool riscv_irq_stats_enabled;
+
+// Anonymous namespace, visible only in this file.
+namespace
+{
+  constexpr uint32_t local_count = RISCV_INTERRUPTS_LOCAL_LAST_NUMBER + 1;
+  constexpr uint32_t global_count = RISCV_INTERRUPTS_GLOBAL_LAST_NUMBER + 1;
+
+  riscv_irq_stats_t stats_[local_count + global_count];
+  riscv_irq_stats_probe_t global_probes_[global_count];
+
+  // The CPU cycles per RTC tick.
+  uint32_t rtc_cycles_;
+
+  uint32_t
+  machine_timer_probe_ (void)
+  {
+    // The interrupt is requested when mtime reaches mtimecmp.
+    return (riscv_device_read_mtime_low ()
+        - riscv_device_read_mtimecmp_low ()) * rtc_cycles_;
+  }
+
+  bool
+  get_ (uint32_t index, riscv_irq_stats_t* stats)
+  {
+    riscv_arch_register_t mstatus = riscv_csr_clear_mstatus_bits (
+        RISCV_CSR_MSTATUS_MIE);
+
+    *stats = stats_[index];
+
+    if (mstatus & RISCV_CSR_MSTATUS_MIE)
+      {
+        riscv_csr_set_mstatus_bits (RISCV_CSR_MSTATUS_MIE);
+      }
+    return true;
+  }
+
+  void
+  dump_ (const char* kind, uint32_t number, const riscv_irq_stats_t* stats)
+  {
+    trace_printf ("irq,%s%u,%u,%u,%u", kind, static_cast<unsigned> (number),
+                  static_cast<unsigned> (stats->count),
+                  static_cast<unsigned> (stats->total_cycles / stats->count),
+                  static_cast<unsigned> (stats->max_cycles));
+    for (uint32_t i = 0; i < OS_INTEGER_IRQ_STATS_BUCKETS; ++i)
+      {
+        trace_printf (",%u", static_cast<unsigned> (stats->latency[i]));
+      }
+    trace_printf ("\n");
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void
+riscv_irq_stats_dispatch (riscv_core_trap_handler_ptr_t handler,
+                          uint32_t index)
+{
+  // The traps are not nested, the interrupts are disabled.
+  uint32_t begin = riscv_csr_read_mcycle_low ();
+
+  riscv_irq_stats_probe_t probe = nullptr;
+  if (index == riscv_interrupt_local_machine_timer)
+    {
+      probe = machine_timer_probe_;
+    }
+  else if (index >= local_count)
+    {
+      probe = global_probes_[index - local_count];
+    }
+  uint32_t latency = (probe != nullptr) ? probe () : 0;
+
+  handler ();
+
+  uint32_t cycles = riscv_csr_read_mcycle_low () - begin;
+
+  riscv_irq_stats_t* stats = &stats_[index];
+  stats->count++;
+  stats->total_cycles += cycles;
+  if (cycles > stats->max_cycles)
+    {
+      stats->max_cycles = cycles;
+    }
+  if (probe != nullptr)
+    {
+      uint32_t bucket = 0;
+      for (latency >>= 5;
+          latency != 0 && bucket < OS_INTEGER_IRQ_STATS_BUCKETS - 1;
+          latency >>= 1)
+        {
+          ++bucket;
+        }
+      stats->latency[bucket]++;
+    }
+}
+
+void
+riscv_irq_stats_start (void)
+{
+  rtc_cycles_ = riscv_core_get_running_frequency_hz ()
+      / riscv_board_get_rtc_frequency_hz ();
+  riscv_irq_stats_enabled = true;
+}
+
+void
+riscv_irq_stats_stop (void)
+{
+  riscv_irq_stats_enabled = false;
+}
+
+void
+riscv_irq_stats_reset (void)
+{
+  riscv_arch_register_t mstatus = riscv_csr_clear_mstatus_bits (
+      RISCV_CSR_MSTATUS_MIE);
+
+  std::memset (stats_, 0, sizeof(stats_));
+
+  if (mstatus & RISCV_CSR_MSTATUS_MIE)
+    {
+      riscv_csr_set_mstatus_bits (RISCV_CSR_MSTATUS_MIE);
+    }
+}
+
+bool
+riscv_irq_stats_get_local (uint32_t number, riscv_irq_stats_t* stats)
+{
+  if (number >= local_count)
+    {
+      return false;
+    }
+  return get_ (number, stats);
+}
+
+bool
+riscv_irq_stats_get_global (uint32_t number, riscv_irq_stats_t* stats)
+{
+  if (number >= global_count)
+    {
+      return false;
+    }
+  return get_ (local_count + number, stats);
+}
+
+void
+riscv_irq_stats_set_global_probe (uint32_t number,
+                                  riscv_irq_stats_probe_t probe)
+{
+  if (number < global_count)
+    {
+      global_probes_[number] = probe;
+    }
+}
+
+void
+riscv_irq_stats_dump (void)
+{
+  trace_printf ("# irq,count,avg,max,latency...\n");
+  for (uint32_t i = 0; i < local_count + global_count; ++i)
+    {
+      riscv_irq_stats_t stats;
+      get_ (i, &stats);
+      if (stats.count != 0)
+        {
+          if (i < local_count)
+            {
+              dump_ ("local", i, &stats);
+            }
+          else
+            {
+              dump_ ("global", i - local_count, &stats);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#endif /* defined(OS_USE_IRQ_STATS) */
@@ -27,6 +27,9 @@
 
 #include <micro-os-plus/device.h>
 #include <micro-os-plus/diag/trace.h>
+#if defined(OS_USE_IRQ_STATS)
+#include <riscv-arch/irq-stats.h>
+#endif /* defined(OS_USE_IRQ_STATS) */
 
 #include <stddef.h>
 #include <stdbool.h>
@@ -86,6 +89,15 @@ namespace riscv
           if (index <= (RISCV_INTERRUPTS_LOCAL_LAST_NUMBER))
             {
               // Call the local device interrupt handler via the pointer.
+#if defined(OS_USE_IRQ_STATS)
+              if (riscv_irq_stats_enabled)
+                {
+                  riscv_irq_stats_dispatch (
+                      riscv::core::local_interrupt_handlers[index],
+                      static_cast<uint32_t> (index));
+                  return;
+                }
+#endif /* defined(OS_USE_IRQ_STATS) */
               riscv::core::local_interrupt_handlers[index] ();
 
               return;
@@ -149,6 +161,16 @@ namespace riscv
       if (int_num <= RISCV_INTERRUPTS_GLOBAL_LAST_NUMBER)
         {
           // Call the global interrupt handler via the pointer.
+#if defined(OS_USE_IRQ_STATS)
+          if (riscv_irq_stats_enabled)
+            {
+              riscv_irq_stats_dispatch (
+                  riscv::core::global_interrupt_handlers[int_num],
+                  static_cast<uint32_t> (RISCV_INTERRUPTS_LOCAL_LAST_NUMBER
+                      + 1 + int_num));
+            }
+          else
+#endif /* defined(OS_USE_IRQ_STATS) */
           riscv::core::global_interrupt_handlers[int_num] ();
 
           // Acknowledge the interrupt in the PLIC.
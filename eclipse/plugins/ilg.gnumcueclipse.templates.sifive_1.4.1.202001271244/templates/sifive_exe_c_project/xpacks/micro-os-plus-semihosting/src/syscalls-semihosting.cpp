@@ -84,6 +84,9 @@ namespace
   {
     int handle;
     off_t pos;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    struct file_cache* cache;
+#endif
   };
 
 #pragma GCC diagnostic pop
@@ -114,6 +117,68 @@ namespace
    */
   struct file opened_files[OS_INTEGER_SEMIHOSTING_MAX_OPEN_FILES];
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+
+  /*
+   * Each semihosting call traps to the debugger, which takes much
+   * longer than the transfer itself, so with OS_USE_SEMIHOSTING_FILE_CACHE
+   * the regular files get a buffer which is used for reading ahead
+   * full blocks and for collecting consecutive writes.
+   *
+   * The buffers are allocated statically, and are assigned when a
+   * file is opened; files opened when all buffers are in use, the
+   * terminal and the files opened in append mode are not buffered.
+   *
+   * The cached data is tagged with its file offset, so it stays valid
+   * after lseek(); the write-behind data is sent to the host before
+   * lseek(), fstat(), fsync(), close() and os_terminate().
+   */
+
+#if !defined(OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE)
+#define OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE (512)
+#endif
+
+#if !defined(OS_INTEGER_SEMIHOSTING_FILE_CACHES)
+#define OS_INTEGER_SEMIHOSTING_FILE_CACHES (4)
+#endif
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  struct file_cache
+  {
+    struct file* owner; // nullptr if the buffer is free.
+    off_t start; // File offset of data[0].
+    size_t len; // Bytes read ahead, or pending write.
+    bool dirty; // The data is pending write.
+    off_t host_pos; // Host file position, -1 if not known.
+    char data[OS_INTEGER_SEMIHOSTING_FILE_CACHE_BLOCK_SIZE];
+  };
+
+#pragma GCC diagnostic pop
+
+  struct file_cache file_caches[OS_INTEGER_SEMIHOSTING_FILE_CACHES];
+
+  void
+  cache_attach (struct file* pfd);
+
+  void
+  cache_detach (struct file* pfd);
+
+  int
+  cache_flush (struct file* pfd);
+
+  void
+  cache_flush_all (void);
+
+  ssize_t
+  cache_read (struct file* pfd, void* buf, size_t nbyte);
+
+  ssize_t
+  cache_write (struct file* pfd, const void* buf, size_t nbyte);
+
+#endif /* defined(OS_USE_SEMIHOSTING_FILE_CACHE) */
+
   struct file*
   find_slot (int fd);
 
@@ -214,6 +279,259 @@ namespace
     return result;
   }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+
+  // Return the number of bytes *not* transferred, or -1.
+  int
+  host_transfer (int operation, int handle, const void* buf, size_t nbyte)
+  {
+    field_t fields[3];
+    fields[0] = (field_t) (size_t) handle;
+    fields[1] = (field_t) buf;
+    fields[2] = (field_t) nbyte;
+
+    return check_error (os::semihosting::call_host (operation, fields));
+  }
+
+  void
+  cache_attach (struct file* pfd)
+  {
+    for (auto& c : file_caches)
+      {
+        if (c.owner == nullptr)
+          {
+            c.owner = pfd;
+            c.start = 0;
+            c.len = 0;
+            c.dirty = false;
+            c.host_pos = 0;
+            pfd->cache = &c;
+            return;
+          }
+      }
+  }
+
+  void
+  cache_detach (struct file* pfd)
+  {
+    pfd->cache->owner = nullptr;
+    pfd->cache = nullptr;
+  }
+
+  /**
+   * Move the host file position, only if needed.
+   */
+  int
+  cache_seek_host (struct file* pfd, off_t pos)
+  {
+    struct file_cache* c = pfd->cache;
+    if (c->host_pos == pos)
+      {
+        return 0;
+      }
+
+    field_t fields[2];
+    fields[0] = (field_t) (size_t) pfd->handle;
+    fields[1] = (field_t) pos;
+    if (check_error (os::semihosting::call_host (SEMIHOSTING_SYS_SEEK, fields))
+        < 0)
+      {
+        c->host_pos = -1;
+        return -1;
+      }
+
+    c->host_pos = pos;
+    return 0;
+  }
+
+  /**
+   * Send the write-behind data to the host.
+   */
+  int
+  cache_flush (struct file* pfd)
+  {
+    struct file_cache* c = pfd->cache;
+    if (!c->dirty)
+      {
+        return 0;
+      }
+
+    size_t len = c->len;
+    c->dirty = false;
+    c->len = 0;
+
+    if (cache_seek_host (pfd, c->start) < 0)
+      {
+        return -1;
+      }
+
+    int res = host_transfer (SEMIHOSTING_SYS_WRITE, pfd->handle, c->data,
+                             len);
+    if (res < 0)
+      {
+        c->host_pos = -1;
+        return -1;
+      }
+
+    c->host_pos += (off_t) (len - (size_t) res);
+    if (res != 0)
+      {
+        // The error is reported later than the write() that caused it.
+        errno = EIO;
+        return -1;
+      }
+
+    return 0;
+  }
+
+  void
+  cache_flush_all (void)
+  {
+    for (auto& c : file_caches)
+      {
+        if (c.owner != nullptr)
+          {
+            cache_flush (c.owner);
+          }
+      }
+  }
+
+  ssize_t
+  cache_read (struct file* pfd, void* buf, size_t nbyte)
+  {
+    struct file_cache* c = pfd->cache;
+    if (cache_flush (pfd) < 0)
+      {
+        return -1;
+      }
+
+    char* p = static_cast<char*> (buf);
+    size_t done = 0;
+    while (done < nbyte)
+      {
+        off_t pos = pfd->pos;
+        if (pos >= c->start && pos < c->start + (off_t) c->len)
+          {
+            // Hit, copy from the buffer.
+            size_t n = (size_t) (c->start + (off_t) c->len - pos);
+            if (n > nbyte - done)
+              {
+                n = nbyte - done;
+              }
+            std::memcpy (p + done, c->data + (pos - c->start), n);
+            done += n;
+            pfd->pos += (off_t) n;
+            continue;
+          }
+
+        if (cache_seek_host (pfd, pos) < 0)
+          {
+            return (done > 0) ? (ssize_t) done : -1;
+          }
+
+        size_t togo = nbyte - done;
+        if (togo >= sizeof(c->data))
+          {
+            // Large reads go directly to the user buffer.
+            int res = host_transfer (SEMIHOSTING_SYS_READ, pfd->handle,
+                                     p + done, togo);
+            if (res == -1)
+              {
+                c->host_pos = -1;
+                return (done > 0) ? (ssize_t) done : -1;
+              }
+            c->host_pos += (off_t) (togo - (size_t) res);
+            pfd->pos += (off_t) (togo - (size_t) res);
+            done += togo - (size_t) res;
+            break;
+          }
+
+        // Miss, read ahead a full block.
+        int res = host_transfer (SEMIHOSTING_SYS_READ, pfd->handle, c->data,
+                                 sizeof(c->data));
+        if (res == -1)
+          {
+            c->len = 0;
+            c->host_pos = -1;
+            return (done > 0) ? (ssize_t) done : -1;
+          }
+        c->start = pos;
+        c->len = sizeof(c->data) - (size_t) res;
+        c->host_pos = pos + (off_t) c->len;
+        if (c->len == 0)
+          {
+            // End of file.
+            break;
+          }
+      }
+
+    return (ssize_t) done;
+  }
+
+  ssize_t
+  cache_write (struct file* pfd, const void* buf, size_t nbyte)
+  {
+    struct file_cache* c = pfd->cache;
+
+    // Only consecutive writes are collected.
+    if (c->dirty && (pfd->pos != c->start + (off_t) c->len))
+      {
+        if (cache_flush (pfd) < 0)
+          {
+            return -1;
+          }
+      }
+
+    if (!c->dirty)
+      {
+        // Drop the read-ahead data, it may overlap the new data.
+        c->start = pfd->pos;
+        c->len = 0;
+      }
+
+    if (c->len + nbyte > sizeof(c->data))
+      {
+        if (cache_flush (pfd) < 0)
+          {
+            return -1;
+          }
+
+        if (nbyte >= sizeof(c->data))
+          {
+            // Large writes go directly to the host.
+            if (cache_seek_host (pfd, pfd->pos) < 0)
+              {
+                return -1;
+              }
+            int res = host_transfer (SEMIHOSTING_SYS_WRITE, pfd->handle, buf,
+                                     nbyte);
+            if (res < 0)
+              {
+                c->host_pos = -1;
+                return -1;
+              }
+            c->host_pos += (off_t) (nbyte - (size_t) res);
+            pfd->pos += (off_t) (nbyte - (size_t) res);
+            if ((nbyte - (size_t) res) == 0)
+              {
+                return with_set_errno (0);
+              }
+            return (ssize_t) (nbyte - (size_t) res);
+          }
+
+        c->start = pfd->pos;
+      }
+
+    std::memcpy (c->data + c->len, buf, nbyte);
+    c->len += nbyte;
+    c->dirty = true;
+    pfd->pos += (off_t) nbyte;
+
+    return (ssize_t) nbyte;
+  }
+
+#endif /* defined(OS_USE_SEMIHOSTING_FILE_CACHE) */
+
   /*
    *  fd, is a user file descriptor.
    */
@@ -237,6 +555,15 @@ namespace
         return -1;
       }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    // SEEK_END needs the host file length, which does not include
+    // the write-behind data.
+    if ((pfd->cache != nullptr) && (cache_flush (pfd) < 0))
+      {
+        return -1;
+      }
+#endif
+
     // Convert SEEK_CUR to SEEK_SET.
     if (whence == SEEK_CUR)
       {
@@ -269,6 +596,20 @@ namespace
         offset += res;
       }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    if (pfd->cache != nullptr)
+      {
+        if (offset < 0)
+          {
+            errno = EINVAL;
+            return -1;
+          }
+        // The host position is set by the next transfer, if needed.
+        pfd->pos = offset;
+        return offset;
+      }
+#endif
+
     // This code only does absolute seeks.
     fields[0] = (field_t) (size_t) pfd->handle;
     fields[1] = (field_t) offset;
@@ -302,6 +643,14 @@ namespace
     st->st_mode |= S_IFCHR;
     st->st_blksize = 1024;
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    // The host file length does not include the write-behind data.
+    if ((pfd->cache != nullptr) && (cache_flush (pfd) < 0))
+      {
+        return -1;
+      }
+#endif
+
     int res;
     res = check_error (
         os::semihosting::call_host (SEMIHOSTING_SYS_FLEN, &pfd->handle));
@@ -400,6 +749,13 @@ namespace posix
       {
         opened_files[fd].handle = fh;
         opened_files[fd].pos = 0;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+        opened_files[fd].cache = nullptr;
+        if (!(oflag & O_APPEND) && (std::strcmp (path, ":tt") != 0))
+          {
+            cache_attach (&opened_files[fd]);
+          }
+#endif
         return fd;
       }
     else
@@ -429,6 +785,16 @@ namespace posix
         return 0;
       }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    // Report the write-behind errors, but close the file anyway.
+    int flushed = 0;
+    if (pfd->cache != nullptr)
+      {
+        flushed = cache_flush (pfd);
+        cache_detach (pfd);
+      }
+#endif
+
     field_t fields[1];
     fields[0] = (field_t) (size_t) pfd->handle;
 
@@ -443,6 +809,13 @@ namespace posix
         pfd->handle = -1;
       }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    if (flushed < 0)
+      {
+        return -1;
+      }
+#endif
+
     return res;
   }
 
@@ -465,6 +838,13 @@ namespace posix
         return -1;
       }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    if (pfd->cache != nullptr)
+      {
+        return cache_read (pfd, buf, nbyte);
+      }
+#endif
+
     field_t fields[3];
     fields[0] = (field_t) (size_t) pfd->handle;
     fields[1] = (field_t) buf;
@@ -499,6 +879,13 @@ namespace posix
         return -1;
       }
 
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    if (pfd->cache != nullptr)
+      {
+        return cache_write (pfd, buf, nbyte);
+      }
+#endif
+
     field_t fields[3];
 
     fields[0] = (field_t) (size_t) pfd->handle;
@@ -1180,6 +1567,17 @@ namespace posix
   int
   fsync (int fildes)
   {
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+    struct file* pfd;
+    pfd = find_slot (fildes);
+    if ((pfd != nullptr) && (pfd->cache != nullptr))
+      {
+        // The host has no sync call; sending the write-behind
+        // data is the best that can be done.
+        return cache_flush (pfd);
+      }
+#endif
+
 #if defined(DEBUG) && (defined (OS_DEBUG_SYSCALLS_BRK) || defined(OS_DEBUG_SYSCALL_FSYNC_BRK))
     os::arch::brk ();
 #endif
@@ -1672,6 +2070,11 @@ void
 __attribute__ ((noreturn,weak))
 os_terminate (int code)
 {
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+  // Do not lose the data pending in the write-behind buffers.
+  cache_flush_all ();
+#endif
+
 #if ( __SIZEOF_POINTER__ == 4 )
   os::semihosting::call_host (
       SEMIHOSTING_SYS_EXIT,
@@ -1851,6 +2254,9 @@ initialise_monitor_handles (void)
   for (int i = 0; i < OS_INTEGER_SEMIHOSTING_MAX_OPEN_FILES; i++)
     {
       opened_files[i].handle = -1;
+#if defined(OS_USE_SEMIHOSTING_FILE_CACHE)
+      opened_files[i].cache = nullptr;
+#endif
     }
 
   opened_files[0].handle = monitor_stdin;
@@ -1863,6 +2269,98 @@ initialise_monitor_handles (void)
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_BENCH)
+
+#include <micro-os-plus/diag/bench.h>
+
+/*
+ * Write, read back and randomly read a 4 KB file on the host, in
+ * requests of 64 bytes; each run opens and closes the file, and the
+ * random reads run after the write, in the registration order. The
+ * bytes transferred by a run are reported, so the throughput is
+ * bytes * clock / cycles; 0 bytes means the host did not open the
+ * file. Compare the results with and without
+ * OS_USE_SEMIHOSTING_FILE_CACHE.
+ *
+ * The file is left in the current folder of the debugger.
+ */
+
+namespace
+{
+  constexpr const char* bench_file = "semihosting-bench.tmp";
+  constexpr std::size_t bench_size = 4096;
+  constexpr std::size_t bench_chunk = 64;
+
+  char bench_buffer[bench_chunk];
+
+  enum class bench_access
+  {
+    write, read, seek_read
+  };
+
+  void
+  bench_transfer (bench_access access)
+  {
+    std::size_t bytes = 0;
+    int fd = posix::open (
+        bench_file,
+        (access == bench_access::write) ?
+            (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY);
+    if (fd >= 0)
+      {
+        // The same pseudo-random sequence of chunks in each run.
+        uint32_t seed = 1;
+        for (std::size_t i = 0; i < bench_size / bench_chunk; ++i)
+          {
+            ssize_t ret;
+            if (access == bench_access::write)
+              {
+                ret = posix::write (fd, bench_buffer, bench_chunk);
+              }
+            else
+              {
+                if (access == bench_access::seek_read)
+                  {
+                    seed = seed * 1103515245u + 12345u;
+                    off_t pos = static_cast<off_t> ((seed >> 16)
+                        % (bench_size / bench_chunk) * bench_chunk);
+                    if (posix::lseek (fd, pos, SEEK_SET) != pos)
+                      {
+                        continue;
+                      }
+                  }
+                ret = posix::read (fd, bench_buffer, bench_chunk);
+              }
+            if (ret > 0)
+              {
+                bytes += static_cast<std::size_t> (ret);
+              }
+          }
+        posix::close (fd);
+      }
+    bench_report ("bytes", static_cast<uint32_t> (bytes));
+  }
+} /* namespace */
+
+BENCH(semihosting_write_4k)
+{
+  bench_transfer (bench_access::write);
+}
+
+BENCH(semihosting_read_4k)
+{
+  bench_transfer (bench_access::read);
+}
+
+BENCH(semihosting_seek_read_4k)
+{
+  bench_transfer (bench_access::seek_read);
+}
+
+#endif /* defined(OS_USE_BENCH) */
+
+// ----------------------------------------------------------------------------
+
 #endif /* defined(OS_USE_SEMIHOSTING_SYSCALLS) */
 
 // ----------------------------------------------------------------------------
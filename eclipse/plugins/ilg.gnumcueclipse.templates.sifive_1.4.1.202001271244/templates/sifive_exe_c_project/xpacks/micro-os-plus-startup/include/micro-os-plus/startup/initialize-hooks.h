@@ -84,6 +84,25 @@ extern "C"
   void
   os_startup_initialize_args (int* p_argc, char*** p_argv);
 
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+
+  /**
+   * @brief Display the duration of the startup steps.
+   * @details
+   * With `OS_INCLUDE_STARTUP_PROFILER` defined for the whole project,
+   * each startup step, up to the call to `main()`, is measured with
+   * the `mcycle` counter. `main()` displays the table on the trace
+   * output, so the slow output does not delay the application.
+   * @par Parameters
+   *  None.
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_startup_profiler_dump (void);
+
+#endif /* defined(OS_INCLUDE_STARTUP_PROFILER) */
+
   /**
    * @}
    */
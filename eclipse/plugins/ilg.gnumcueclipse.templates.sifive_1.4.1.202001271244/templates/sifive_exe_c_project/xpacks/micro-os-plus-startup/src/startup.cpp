@@ -29,6 +29,7 @@
 #include <micro-os-plus/diag/trace.h>
 #include <micro-os-plus/startup/initialize-hooks.h>
 
+#include <cinttypes>
 #include <cstdint>
 #include <cstdlib>
 #include <algorithm>
@@ -53,6 +54,11 @@
 // If OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS is defined, the
 // code is capable of initializing multiple regions.
 //
+// If OS_INCLUDE_STARTUP_PROFILER is defined, the duration of each
+// step (including each static constructor), up to the call to main(),
+// is measured with the `mcycle` counter; main() displays the table
+// via the trace device with os_startup_profiler_dump().
+//
 // Note: External memory with variable size (size known after reading the
 // chip type) cannot be initialized via these linker script static tables
 // and need to be processed in the `os_startup_initialize_hardware_early ()`
@@ -143,14 +149,33 @@ extern "C"
 
 // ----------------------------------------------------------------------------
 
+// The regions are processed in blocks of 4 words, with all loads
+// grouped before the stores, so the pipeline is not stalled waiting
+// for each load; the remaining words are processed one by one.
+
 inline void
 __attribute__((always_inline))
 os_initialize_data (std::uintptr_t* from, std::uintptr_t* region_begin,
                     std::uintptr_t* region_end)
 {
-  // Iterate and copy word by word.
   // Assume that the pointers are word aligned.
   std::uintptr_t* p = region_begin;
+  std::uintptr_t* blocks_end = p + ((region_end - p) & ~3);
+  while (p < blocks_end)
+    {
+      std::uintptr_t w0 = from[0];
+      std::uintptr_t w1 = from[1];
+      std::uintptr_t w2 = from[2];
+      std::uintptr_t w3 = from[3];
+      p[0] = w0;
+      p[1] = w1;
+      p[2] = w2;
+      p[3] = w3;
+      p += 4;
+      from += 4;
+    }
+
+  // Copy the rest word by word.
   while (p < region_end)
     {
       *p++ = *from++;
@@ -161,9 +186,19 @@ inline void
 __attribute__((always_inline))
 os_initialize_bss (std::uintptr_t* region_begin, std::uintptr_t* region_end)
 {
-  // Iterate and clear word by word.
   // Assume that the pointers are word aligned.
   std::uintptr_t* p = region_begin;
+  std::uintptr_t* blocks_end = p + ((region_end - p) & ~3);
+  while (p < blocks_end)
+    {
+      p[0] = 0;
+      p[1] = 0;
+      p[2] = 0;
+      p[3] = 0;
+      p += 4;
+    }
+
+  // Clear the rest word by word.
   while (p < region_end)
     {
       *p++ = 0;
@@ -193,6 +228,108 @@ __fini_array_begin__[];
 extern function_ptr_t __attribute__((weak))
 __fini_array_end__[];
 
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+
+#if !defined(OS_INTEGER_STARTUP_PROFILER_RECORDS)
+#define OS_INTEGER_STARTUP_PROFILER_RECORDS (32)
+#endif
+
+namespace
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  struct startup_step
+  {
+    const char* name;
+    function_ptr_t function; // For the static constructors.
+    uint32_t cycles; // Since _start().
+  };
+
+#pragma GCC diagnostic pop
+
+  // Not in .bss, since the first records are taken before the data
+  // and bss sections are initialized.
+  startup_step __attribute__ ((section(".noinit")))
+  startup_profiler_records[OS_INTEGER_STARTUP_PROFILER_RECORDS];
+
+  std::size_t __attribute__ ((section(".noinit")))
+  startup_profiler_count;
+
+  // The steps not recorded because the table was full.
+  std::size_t __attribute__ ((section(".noinit")))
+  startup_profiler_dropped;
+
+  uint32_t __attribute__ ((section(".noinit")))
+  startup_profiler_begin;
+
+  inline void
+  __attribute__((always_inline))
+  startup_profiler_start (void)
+  {
+    startup_profiler_begin = riscv::csr::mcycle_low ();
+    startup_profiler_count = 0;
+    startup_profiler_dropped = 0;
+  }
+
+  inline void
+  __attribute__((always_inline))
+  startup_profiler_record (const char* name, function_ptr_t function)
+  {
+    uint32_t cycles = riscv::csr::mcycle_low () - startup_profiler_begin;
+    if (startup_profiler_count < OS_INTEGER_STARTUP_PROFILER_RECORDS)
+      {
+        startup_step& r =
+            startup_profiler_records[startup_profiler_count++];
+        r.name = name;
+        r.function = function;
+        r.cycles = cycles;
+      }
+    else
+      {
+        ++startup_profiler_dropped;
+      }
+  }
+}
+
+void
+os_startup_profiler_dump (void)
+{
+  os::trace::printf ("Startup profile (cycles):\n");
+  os::trace::printf ("     total      delta  step\n");
+
+  uint32_t previous = 0;
+  for (std::size_t i = 0; i < startup_profiler_count; ++i)
+    {
+      startup_step& r = startup_profiler_records[i];
+      os::trace::printf ("%10" PRIu32 " %10" PRIu32 "  %s", r.cycles,
+                         r.cycles - previous, r.name);
+      if (r.function != nullptr)
+        {
+          os::trace::printf (" %p", reinterpret_cast<void*> (r.function));
+        }
+      os::trace::printf ("\n");
+      previous = r.cycles;
+    }
+
+  if (startup_profiler_dropped != 0)
+    {
+      os::trace::printf (
+          "%u more steps not recorded, "
+          "increase OS_INTEGER_STARTUP_PROFILER_RECORDS\n",
+          static_cast<unsigned int> (startup_profiler_dropped));
+    }
+}
+
+#define OS_STARTUP_PROFILE(name, function) \
+  startup_profiler_record (name, function)
+
+#else
+
+#define OS_STARTUP_PROFILE(name, function)
+
+#endif /* defined(OS_INCLUDE_STARTUP_PROFILER) */
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Waggregate-return"
 
@@ -205,7 +342,10 @@ os_run_init_array (void)
 
   std::for_each (__preinit_array_begin__, __preinit_array_end__,
                  [](const function_ptr_t pf)
-                   { pf();} //
+                   {
+                     pf();
+                     OS_STARTUP_PROFILE("preinit_array", pf);
+                   } //
                  );
 
   // If the application needs to run the code in the .init section,
@@ -215,7 +355,10 @@ os_run_init_array (void)
 
   std::for_each (__init_array_begin__, __init_array_end__,
                  [](const function_ptr_t pf)
-                   { pf();} //
+                   {
+                     pf();
+                     OS_STARTUP_PROFILE("init_array", pf);
+                   } //
                  );
 }
 
@@ -281,6 +424,10 @@ _start (void)
 {
   // --------------------------------------------------------------------------
 
+#if defined(OS_INCLUDE_STARTUP_PROFILER)
+  startup_profiler_start ();
+#endif
+
   // Initialize hardware right after reset, to switch clock to higher
   // frequency and have the rest of the initializations run faster.
   //
@@ -295,6 +442,7 @@ _start (void)
   // to accommodate for the initializations duration.
 
   os_startup_initialize_hardware_early ();
+  OS_STARTUP_PROFILE("os_startup_initialize_hardware_early()", nullptr);
 
   // Use Old Style DATA and BSS section initialization,
   // that will manage a single BSS sections.
@@ -325,6 +473,7 @@ _start (void)
     }
 
 #endif /* OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS */
+  OS_STARTUP_PROFILE("data", nullptr);
 
 #if defined(DEBUG) && (OS_BOOL_STARTUP_GUARD_CHECKS)
 
@@ -368,6 +517,7 @@ _start (void)
     }
 
 #endif /* OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS */
+  OS_STARTUP_PROFILE("bss", nullptr);
 
 #if defined(DEBUG) && (OS_BOOL_STARTUP_GUARD_CHECKS)
 
@@ -389,6 +539,7 @@ _start (void)
   // Hook to continue the initializations. Usually compute and store the
   // clock frequency in a global variable, cleared above.
   os_startup_initialize_hardware ();
+  OS_STARTUP_PROFILE("os_startup_initialize_hardware()", nullptr);
 
   os::trace::printf ("Hardware initialized.\n");
   
@@ -397,6 +548,7 @@ _start (void)
   os_startup_initialize_free_store (
       &__heap_begin__,
       (size_t) ((char*) (&__heap_end__) - (char*) (&__heap_begin__)));
+  OS_STARTUP_PROFILE("os_startup_initialize_free_store()", nullptr);
 
   // Warning: `malloc()` may need `errno` which may depend on knowing
   // the current thread.
@@ -409,8 +561,10 @@ _start (void)
   int argc;
   char** argv;
   os_startup_initialize_args (&argc, &argv);
+  OS_STARTUP_PROFILE("os_startup_initialize_args()", nullptr);
 
   os::trace::dump_args(argc, argv);
+  OS_STARTUP_PROFILE("main()", nullptr);
 
   // Call the main entry point, and save the exit code.
   int code = main (argc, argv);
@@ -66,6 +66,19 @@ extern "C"
   void
   os_sysclock_sleep_for (os_clock_duration_t duration);
 
+  /*
+   * The high resolution clocks, independent of the ticks: the core
+   * cycles (mcycle) and the nanoseconds derived from the RTC (mtime,
+   * with the RTC resolution). Both are 64-bit, monotonic, and can be
+   * read from interrupt handlers.
+   */
+
+  os_clock_timestamp_t
+  os_sysclock_now_cycles (void);
+
+  os_clock_timestamp_t
+  os_sysclock_now_ns (void);
+
   static inline void
   __attribute__((always_inline))
   os_sysclock_internal_increment_count (void)
@@ -77,7 +90,16 @@ extern "C"
   __attribute__((always_inline))
   os_sysclock_steady_now (void)
   {
-    return os_sysclock.steady_count_;
+    // On RV32 the count is read in two halves; read it again if the
+    // interrupt updated it in between.
+    os_clock_timestamp_t count;
+    do
+      {
+        count = os_sysclock.steady_count_;
+      }
+    while (count != os_sysclock.steady_count_);
+
+    return count;
   }
 
   static inline os_clock_duration_t
@@ -77,6 +77,19 @@ namespace os
     void
     internal_increment_count ();
 
+    /**
+     * @brief The core cycles (mcycle), 64-bit.
+     */
+    static timestamp_t
+    now_cycles (void);
+
+    /**
+     * @brief The nanoseconds derived from the RTC (mtime), with
+     * the RTC resolution.
+     */
+    static timestamp_t
+    now_ns (void);
+
   private:
     timestamp_t volatile steady_count_ = 0;
   };
@@ -96,7 +109,16 @@ inline os::clock::timestamp_t
 __attribute__((always_inline))
 os::sysclock::steady_now (void)
 {
-  return steady_count_;
+  // On RV32 the count is read in two halves; read it again if the
+  // interrupt updated it in between.
+  timestamp_t count;
+  do
+    {
+      count = steady_count_;
+    }
+  while (count != steady_count_);
+
+  return count;
 }
 
 // ----------------------------------------------------------------------------
@@ -50,6 +50,44 @@ os_sysclock_sleep_for (os_clock_duration_t duration)
     }
 }
 
+os_clock_timestamp_t
+os_sysclock_now_cycles (void)
+{
+  uint32_t high;
+  uint32_t low;
+
+  // Read the high word again, to detect a carry from the low word.
+  do
+    {
+      high = riscv_csr_read_mcycle_high ();
+      low = riscv_csr_read_mcycle_low ();
+    }
+  while (high != riscv_csr_read_mcycle_high ());
+
+  return ((os_clock_timestamp_t) high << 32) | low;
+}
+
+os_clock_timestamp_t
+os_sysclock_now_ns (void)
+{
+  uint32_t high;
+  uint32_t low;
+
+  do
+    {
+      high = riscv_device_read_mtime_high ();
+      low = riscv_device_read_mtime_low ();
+    }
+  while (high != riscv_device_read_mtime_high ());
+
+  os_clock_timestamp_t rtc = ((os_clock_timestamp_t) high << 32) | low;
+  uint32_t frequency_hz = riscv_board_get_rtc_frequency_hz ();
+
+  // Split the conversion, to avoid overflowing.
+  return (rtc / frequency_hz) * 1000000000u
+      + ((rtc % frequency_hz) * 1000000000u) / frequency_hz;
+}
+
 // ----------------------------------------------------------------------------
 
 // Instantiate a static system clock object.
@@ -49,6 +49,44 @@ os::sysclock::sleep_for (duration_t duration)
     }
 }
 
+os::clock::timestamp_t
+os::sysclock::now_cycles (void)
+{
+  uint32_t high;
+  uint32_t low;
+
+  // Read the high word again, to detect a carry from the low word.
+  do
+    {
+      high = riscv::csr::mcycle_high ();
+      low = riscv::csr::mcycle_low ();
+    }
+  while (high != riscv::csr::mcycle_high ());
+
+  return (static_cast<timestamp_t> (high) << 32) | low;
+}
+
+os::clock::timestamp_t
+os::sysclock::now_ns (void)
+{
+  uint32_t high;
+  uint32_t low;
+
+  do
+    {
+      high = riscv::device::mtime_high ();
+      low = riscv::device::mtime_low ();
+    }
+  while (high != riscv::device::mtime_high ());
+
+  timestamp_t rtc = (static_cast<timestamp_t> (high) << 32) | low;
+  uint32_t frequency_hz = riscv::board::rtc_frequency_hz ();
+
+  // Split the conversion, to avoid overflowing.
+  return (rtc / frequency_hz) * 1000000000u
+      + ((rtc % frequency_hz) * 1000000000u) / frequency_hz;
+}
+
 // ----------------------------------------------------------------------------
 
 namespace os 
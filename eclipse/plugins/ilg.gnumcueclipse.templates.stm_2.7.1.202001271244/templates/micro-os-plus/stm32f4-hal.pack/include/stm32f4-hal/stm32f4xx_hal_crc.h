@@ -87,6 +87,16 @@ typedef struct
 
   __IO HAL_CRC_StateTypeDef   State;      /*!< CRC communication state */
 
+  struct __DMA_HandleTypeDef  *hdma;      /*!< CRC memory-to-memory DMA handle,
+                                               used by HAL_CRC_Accumulate_DMA() */
+
+  const uint8_t               *pBuffPtr;  /*!< Next byte to be processed by DMA  */
+
+  __IO uint32_t               XferCount;  /*!< Bytes left to be processed by DMA */
+
+  __IO uint32_t               ErrorCode;  /*!< Error of the last DMA computation,
+                                               see @ref CRC_Error_Code */
+
 }CRC_HandleTypeDef;
 /** 
   * @}
@@ -97,6 +107,15 @@ typedef struct
   */ 
 
 /* Exported constants --------------------------------------------------------*/
+/** @defgroup CRC_Error_Code CRC Error Code
+  * @{
+  */
+#define HAL_CRC_ERROR_NONE      0x00000000U   /*!< No error               */
+#define HAL_CRC_ERROR_DMA       0x00000001U   /*!< DMA transfer error     */
+/**
+  * @}
+  */
+
 /* Exported macro ------------------------------------------------------------*/
 /** @defgroup CRC_Exported_Macros CRC Exported Macros
   * @{
@@ -154,6 +173,12 @@ void HAL_CRC_MspDeInit(CRC_HandleTypeDef *hcrc);
   */
 uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength);
 uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength);
+HAL_StatusTypeDef HAL_CRC_Accumulate_DMA(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength);
+HAL_StatusTypeDef HAL_CRC_Calculate_DMA(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength);
+HAL_StatusTypeDef HAL_CRC_PollForTransfer(CRC_HandleTypeDef *hcrc, uint32_t Timeout);
+uint32_t HAL_CRC_GetValue(CRC_HandleTypeDef *hcrc);
+void HAL_CRC_CpltCallback(CRC_HandleTypeDef *hcrc);
+void HAL_CRC_ErrorCallback(CRC_HandleTypeDef *hcrc);
 /**
   * @}
   */ 
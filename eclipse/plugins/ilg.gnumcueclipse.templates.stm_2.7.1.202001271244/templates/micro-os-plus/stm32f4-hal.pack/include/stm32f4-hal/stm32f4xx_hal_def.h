@@ -106,21 +106,92 @@ typedef enum
   /* Reserved for future use */
   #error "USE_RTOS should be 0 in the current HAL release"
 #else
+/*
+ * The lock is taken with an atomic test-and-set, so a handle can be
+ * used from both thread and interrupt context without wrapping the
+ * HAL calls in global interrupt disables; the loser gets HAL_BUSY.
+ * On ARMv7-M (M3/M4/M7) the exclusive load/store instructions are
+ * used and the interrupts are never masked; on ARMv6-M, which has
+ * no exclusive access, the test-and-set is done with PRIMASK set,
+ * for only a few instructions.
+ * The Lock member is an enum, and its size depends on -fshort-enums,
+ * so the access width is selected at compile time.
+ */
+__STATIC_INLINE HAL_StatusTypeDef __HAL_TryLock(volatile void *lock, uint32_t size)
+{
+#if (__CORTEX_M >= 0x03U)
+  uint32_t locked;
+  uint32_t failed;
+
+  do
+  {
+    if(size == 1U)
+    {
+      locked = __LDREXB((volatile uint8_t *)lock);
+    }
+    else if(size == 2U)
+    {
+      locked = __LDREXH((volatile uint16_t *)lock);
+    }
+    else
+    {
+      locked = __LDREXW((volatile uint32_t *)lock);
+    }
+
+    if(locked != (uint32_t)HAL_UNLOCKED)
+    {
+      __CLREX();
+      return HAL_BUSY;
+    }
+
+    if(size == 1U)
+    {
+      failed = __STREXB((uint8_t)HAL_LOCKED, (volatile uint8_t *)lock);
+    }
+    else if(size == 2U)
+    {
+      failed = __STREXH((uint16_t)HAL_LOCKED, (volatile uint16_t *)lock);
+    }
+    else
+    {
+      failed = __STREXW((uint32_t)HAL_LOCKED, (volatile uint32_t *)lock);
+    }
+  } while(failed != 0U);
+#else
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if(*(volatile HAL_LockTypeDef *)lock != HAL_UNLOCKED)
+  {
+    __set_PRIMASK(primask);
+    return HAL_BUSY;
+  }
+  *(volatile HAL_LockTypeDef *)lock = HAL_LOCKED;
+
+  __set_PRIMASK(primask);
+#endif /* __CORTEX_M */
+
+  /* The accesses to the handle must not be done before the lock. */
+  __DMB();
+  return HAL_OK;
+}
+
   #define __HAL_LOCK(__HANDLE__)                                           \
                                 do{                                        \
-                                    if((__HANDLE__)->Lock == HAL_LOCKED)   \
+                                    if(__HAL_TryLock(&(__HANDLE__)->Lock,  \
+                                       sizeof((__HANDLE__)->Lock))         \
+                                       != HAL_OK)                          \
                                     {                                      \
                                        return HAL_BUSY;                    \
                                     }                                      \
-                                    else                                   \
-                                    {                                      \
-                                       (__HANDLE__)->Lock = HAL_LOCKED;    \
-                                    }                                      \
                                   }while (0)
 
+  /* The accesses to the handle must complete before the release. */
   #define __HAL_UNLOCK(__HANDLE__)                                          \
                                   do{                                       \
-                                      (__HANDLE__)->Lock = HAL_UNLOCKED;    \
+                                      __DMB();                              \
+                                      *(volatile HAL_LockTypeDef *)         \
+                                        &(__HANDLE__)->Lock = HAL_UNLOCKED; \
                                     }while (0)
 #endif /* USE_RTOS */
 
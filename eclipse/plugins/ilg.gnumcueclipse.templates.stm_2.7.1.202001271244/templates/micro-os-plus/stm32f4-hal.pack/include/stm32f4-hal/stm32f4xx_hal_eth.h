@@ -597,7 +597,7 @@ typedef struct
   /*!< Enhanced ETHERNET DMA PTP Descriptors */
   uint32_t   ExtendedStatus;        /*!< Extended status for PTP receive descriptor */
   
-  uint32_t   Reserved1;             /*!< Reserved */
+  uint32_t   Reserved1;             /*!< Reserved; frame context of the zero copy Tx */
   
   uint32_t   TimeStampLow;          /*!< Time Stamp Low value for transmit and receive */
   
@@ -622,6 +622,46 @@ typedef struct
 
 } ETH_DMARxFrameInfos;
 
+/**
+  * @brief  ETH zero copy buffer structure definition
+  */
+typedef struct __ETH_BufferTypeDef
+{
+  uint8_t *buffer;                       /*!< Buffer address */
+
+  uint32_t len;                          /*!< Buffer length */
+
+  struct __ETH_BufferTypeDef *next;      /*!< Next buffer of the frame, or NULL for the last one */
+
+} ETH_BufferTypeDef;
+
+/**
+  * @brief  ETH interrupt, poll and drop counters
+  */
+typedef struct
+{
+  uint32_t Tick;                         /*!< HAL_GetTick() when read, for the rates */
+
+  uint32_t Interrupts;                   /*!< ETH interrupts */
+
+  uint32_t RxInterrupts;                 /*!< Rx interrupts */
+
+  uint32_t TxInterrupts;                 /*!< Tx interrupts */
+
+  uint32_t RxPollModes;                  /*!< Rx interrupt disabled for polling, above the threshold */
+
+  uint32_t Polls;                        /*!< HAL_ETH_RxPoll() calls */
+
+  uint32_t PollFrames;                   /*!< Frames handed up by HAL_ETH_RxPoll() */
+
+  uint32_t PollsExhausted;               /*!< HAL_ETH_RxPoll() calls which used all their budget */
+
+  uint32_t RxDropped;                    /*!< Frames dropped by the driver: errors, too long */
+
+  uint32_t RxMissed;                     /*!< Frames missed by the DMA: no buffer, FIFO overflow */
+
+} ETH_StatsTypeDef;
+
 /** 
   * @brief  ETH Handle Structure definition  
   */
@@ -639,6 +679,28 @@ typedef struct
   ETH_DMADescTypeDef         *TxDesc;       /*!< Tx descriptor to Set        */
   
   ETH_DMARxFrameInfos        RxFrameInfos;  /*!< last Rx frame infos         */
+
+  ETH_DMADescTypeDef         *TxReleaseDesc; /*!< Tx descriptor to release (zero copy) */
+
+  uint32_t                   TxDescFree;    /*!< Free Tx descriptors (zero copy)     */
+
+  ETH_DMADescTypeDef         *RxBuildDesc;  /*!< Rx descriptor to refill (zero copy) */
+
+  uint32_t                   RxBuildCount;  /*!< Rx descriptors to refill (zero copy) */
+
+  uint32_t                   RxIntThreshold; /*!< Rx interrupts per ms before polling  */
+
+  uint32_t                   RxIntTick;     /*!< Tick of the Rx interrupt count      */
+
+  uint32_t                   RxIntCount;    /*!< Rx interrupts in that tick          */
+
+  __IO uint32_t              RxPolling;     /*!< Rx interrupt disabled, ring polled  */
+
+  uint32_t                   TxIntBatch;    /*!< Tx frames per completion interrupt  */
+
+  uint32_t                   TxIntCount;    /*!< Tx frames since the last interrupt  */
+
+  ETH_StatsTypeDef           Stats;         /*!< Interrupt, poll and drop counters   */
   
   __IO HAL_ETH_StateTypeDef  State;         /*!< ETH communication state     */
   
@@ -2109,6 +2171,8 @@ void HAL_ETH_MspInit(ETH_HandleTypeDef *heth);
 void HAL_ETH_MspDeInit(ETH_HandleTypeDef *heth);
 HAL_StatusTypeDef HAL_ETH_DMATxDescListInit(ETH_HandleTypeDef *heth, ETH_DMADescTypeDef *DMATxDescTab, uint8_t* TxBuff, uint32_t TxBuffCount);
 HAL_StatusTypeDef HAL_ETH_DMARxDescListInit(ETH_HandleTypeDef *heth, ETH_DMADescTypeDef *DMARxDescTab, uint8_t *RxBuff, uint32_t RxBuffCount);
+HAL_StatusTypeDef HAL_ETH_DMATxDescListInit_ZeroCopy(ETH_HandleTypeDef *heth, ETH_DMADescTypeDef *DMATxDescTab, uint32_t TxDescCount);
+HAL_StatusTypeDef HAL_ETH_DMARxDescListInit_ZeroCopy(ETH_HandleTypeDef *heth, ETH_DMADescTypeDef *DMARxDescTab, uint32_t RxDescCount);
 
 /**
   * @}
@@ -2120,6 +2184,14 @@ HAL_StatusTypeDef HAL_ETH_DMARxDescListInit(ETH_HandleTypeDef *heth, ETH_DMADesc
   */
 HAL_StatusTypeDef HAL_ETH_TransmitFrame(ETH_HandleTypeDef *heth, uint32_t FrameLength);
 HAL_StatusTypeDef HAL_ETH_GetReceivedFrame(ETH_HandleTypeDef *heth);
+/* Zero copy mode, with the buffers of the application */
+HAL_StatusTypeDef HAL_ETH_TransmitFrame_ZeroCopy(ETH_HandleTypeDef *heth, ETH_BufferTypeDef *pBuffers, void *pContext);
+HAL_StatusTypeDef HAL_ETH_ReleaseTxFrames(ETH_HandleTypeDef *heth);
+HAL_StatusTypeDef HAL_ETH_GetReceivedFrame_ZeroCopy(ETH_HandleTypeDef *heth, uint8_t **pBuffer, uint32_t *pLength);
+void HAL_ETH_RxAllocateCallback(ETH_HandleTypeDef *heth, uint8_t **buff);
+void HAL_ETH_TxFreeCallback(ETH_HandleTypeDef *heth, void *pContext);
+uint32_t HAL_ETH_RxPoll(ETH_HandleTypeDef *heth, uint32_t Budget);
+void HAL_ETH_RxPollCallback(ETH_HandleTypeDef *heth, uint8_t *buff, uint32_t Length);
 /* Communication with PHY functions*/
 HAL_StatusTypeDef HAL_ETH_ReadPHYRegister(ETH_HandleTypeDef *heth, uint16_t PHYReg, uint32_t *RegValue);
 HAL_StatusTypeDef HAL_ETH_WritePHYRegister(ETH_HandleTypeDef *heth, uint16_t PHYReg, uint32_t RegValue);
@@ -2144,6 +2216,7 @@ HAL_StatusTypeDef HAL_ETH_Start(ETH_HandleTypeDef *heth);
 HAL_StatusTypeDef HAL_ETH_Stop(ETH_HandleTypeDef *heth);
 HAL_StatusTypeDef HAL_ETH_ConfigMAC(ETH_HandleTypeDef *heth, ETH_MACInitTypeDef *macconf);
 HAL_StatusTypeDef HAL_ETH_ConfigDMA(ETH_HandleTypeDef *heth, ETH_DMAInitTypeDef *dmaconf);
+HAL_StatusTypeDef HAL_ETH_ConfigCoalescing(ETH_HandleTypeDef *heth, uint32_t RxIntThreshold, uint32_t TxIntBatch);
 /**
   * @}
   */ 
@@ -2154,6 +2227,7 @@ HAL_StatusTypeDef HAL_ETH_ConfigDMA(ETH_HandleTypeDef *heth, ETH_DMAInitTypeDef
   * @{
   */
 HAL_ETH_StateTypeDef HAL_ETH_GetState(ETH_HandleTypeDef *heth);
+void HAL_ETH_GetStats(ETH_HandleTypeDef *heth, ETH_StatsTypeDef *pStats);
 /**
   * @}
   */
@@ -154,6 +154,21 @@ typedef enum
                                                    Value is allowed for gState only */
 }HAL_UART_StateTypeDef;
 
+/** 
+  * @brief  UART transmit queue descriptor
+  */
+typedef struct __UART_TxDescTypeDef
+{
+  const uint8_t                 *pData;           /*!< Pointer to the data to send        */
+
+  uint16_t                      Size;             /*!< Number of bytes to send            */
+
+  void                          *pContext;        /*!< User data, not used by the driver  */
+
+  struct __UART_TxDescTypeDef   *pNext;           /*!< Next queued descriptor (driver)    */
+
+}UART_TxDescTypeDef;
+
 /** 
   * @brief  UART handle Structure definition  
   */  
@@ -168,12 +183,20 @@ typedef struct
   uint16_t                      TxXferSize;       /*!< UART Tx Transfer size              */
   
   uint16_t                      TxXferCount;      /*!< UART Tx Transfer Counter           */
+
+  UART_TxDescTypeDef            *pTxQueueHead;    /*!< UART Tx queue, descriptor in progress */
+
+  UART_TxDescTypeDef            *pTxQueueTail;    /*!< UART Tx queue, last descriptor     */
   
   uint8_t                       *pRxBuffPtr;      /*!< Pointer to UART Rx transfer Buffer */
   
   uint16_t                      RxXferSize;       /*!< UART Rx Transfer size              */
   
   uint16_t                      RxXferCount;      /*!< UART Rx Transfer Counter           */  
+
+  __IO uint16_t                 RxStreamHead;     /*!< UART Rx stream write index         */
+
+  __IO uint16_t                 RxStreamTail;     /*!< UART Rx stream read index          */
   
   DMA_HandleTypeDef             *hdmatx;          /*!< UART Tx DMA Handle parameters      */
     
@@ -210,6 +233,7 @@ typedef struct
 #define HAL_UART_ERROR_FE           ((uint32_t)0x00000004U)   /*!< Frame error         */
 #define HAL_UART_ERROR_ORE          ((uint32_t)0x00000008U)   /*!< Overrun error       */
 #define HAL_UART_ERROR_DMA          ((uint32_t)0x00000010U)   /*!< DMA transfer error  */
+#define HAL_UART_ERROR_STREAM       ((uint32_t)0x00000020U)   /*!< Rx stream overrun   */
 /**
   * @}
   */
@@ -653,6 +677,15 @@ HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData
 HAL_StatusTypeDef HAL_UART_DMAPause(UART_HandleTypeDef *huart);
 HAL_StatusTypeDef HAL_UART_DMAResume(UART_HandleTypeDef *huart);
 HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_RxStream_Start(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_RxStream_Stop(UART_HandleTypeDef *huart);
+uint16_t HAL_UART_RxStream_GetSpan(UART_HandleTypeDef *huart, uint8_t **pData);
+void HAL_UART_RxStream_Release(UART_HandleTypeDef *huart, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_TxQueue_Put(UART_HandleTypeDef *huart, UART_TxDescTypeDef *pDesc);
+HAL_StatusTypeDef HAL_UART_TxQueue_Flush(UART_HandleTypeDef *huart, uint32_t Timeout);
+#if defined(OS_USE_BENCH)
+HAL_StatusTypeDef HAL_UART_RegisterBench(UART_HandleTypeDef *huart);
+#endif /* OS_USE_BENCH */
 
 void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
@@ -660,6 +693,8 @@ void HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef *huart);
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
 void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart);
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxStreamCallback(UART_HandleTypeDef *huart, uint16_t Size);
+void HAL_UART_TxQueueCallback(UART_HandleTypeDef *huart, UART_TxDescTypeDef *pDesc);
 /**
   * @}
   */
@@ -28,6 +28,31 @@
           a new 32-bit data buffer. This function resets the CRC computation  
           unit before starting the computation to avoid getting wrong CRC values.
 
+      (#) To process a byte buffer of any alignment and length without
+          the CPU, use HAL_CRC_Accumulate_DMA() or HAL_CRC_Calculate_DMA():
+          (++) Link a DMA2 stream to the handle in HAL_CRC_MspInit() with
+               __HAL_LINKDMA(hcrc, hdma, hdma_crc), configured with
+               Direction = DMA_MEMORY_TO_MEMORY, PeriphInc = DMA_PINC_ENABLE,
+               MemInc = DMA_MINC_DISABLE, PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+               MemDataAlignment = DMA_MDATAALIGN_WORD, Mode = DMA_NORMAL,
+               FIFOMode = DMA_FIFOMODE_ENABLE, FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+               enable its interrupt and call HAL_DMA_IRQHandler() from it.
+          (++) The DMA reads the buffer by bytes and packs each 4 bytes in
+               a little endian word, so the result is the same as the one
+               of HAL_CRC_Accumulate() on the same memory seen as words.
+          (++) The 1 to 3 bytes after the last full word are processed in
+               software, in memory order, most significant bit first, and
+               the unit is seeded with the result, so the computation can
+               be continued by any of the functions.
+          (++) HAL_CRC_CpltCallback() is called when done; the result is
+               returned by HAL_CRC_GetValue(). HAL_CRC_PollForTransfer()
+               waits for the end, also with the interrupts disabled.
+          (++) On a DMA error, HAL_CRC_ErrorCallback() is called with
+               ErrorCode set to HAL_CRC_ERROR_DMA, and the handle is
+               ready for a new computation.
+          (++) The software equivalent is crc32_update_words(), in
+               cortexm/Crc32.h.
+
   @endverbatim
   ******************************************************************************
   * @attention
@@ -74,9 +99,34 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/** @addtogroup CRC_Private_Constants
+  * @{
+  */
+#define CRC_POLYNOMIAL           0x04C11DB7U
+#define CRC_DMA_MAX_LENGTH       0xFFFCU     /* Bytes, a multiple of 4 that fits in NDTR */
+/**
+  * @}
+  */
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+/** @addtogroup CRC_Private_Functions
+  * @{
+  */
+#ifdef HAL_DMA_MODULE_ENABLED
+static HAL_StatusTypeDef CRC_DMA_Start(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength, uint32_t Reset);
+static void CRC_DMA_Continue(CRC_HandleTypeDef *hcrc);
+static void CRC_DMAXferCplt(DMA_HandleTypeDef *hdma);
+static void CRC_DMAError(DMA_HandleTypeDef *hdma);
+#endif /* HAL_DMA_MODULE_ENABLED */
+static uint32_t CRC_Bytes(uint32_t crc, const uint8_t *pBuffer, uint32_t BufferLength);
+static uint32_t CRC_SeedWord(uint32_t crc);
+#if defined(OS_USE_BENCH)
+static void CRC_RegisterBench(CRC_HandleTypeDef *hcrc);
+#endif /* OS_USE_BENCH */
+/**
+  * @}
+  */
 /* Private functions ---------------------------------------------------------*/
 /* Exported functions --------------------------------------------------------*/
 
@@ -134,6 +184,10 @@ HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc)
   /* Change CRC peripheral state */
   hcrc->State = HAL_CRC_STATE_READY;
   
+#if defined(OS_USE_BENCH)
+  CRC_RegisterBench(hcrc);
+#endif /* OS_USE_BENCH */
+
   /* Return function status */
   return HAL_OK;
 }
@@ -217,6 +271,9 @@ __weak void HAL_CRC_MspDeInit(CRC_HandleTypeDef *hcrc)
           using combination of the previous CRC value and the new one.
       (+) Compute the 32-bit CRC value of 32-bit data buffer,
           independently of the previous CRC value.
+      (+) Compute the 32-bit CRC value of a byte buffer with DMA,
+          using combination of the previous CRC value and the new one,
+          or independently of it.
 
 @endverbatim
   * @{
@@ -295,6 +352,114 @@ uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t
   return hcrc->Instance->DR;
 }
 
+
+#ifdef HAL_DMA_MODULE_ENABLED
+
+/**
+  * @brief  Starts the computation of the 32-bit CRC of a byte buffer with DMA,
+  *         using combination of the previous CRC value and the new one.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @param  pBuffer: pointer to the buffer, of any alignment; it must not
+  *         be changed until the end of the computation
+  * @param  BufferLength: length of the buffer in bytes
+  * @note   HAL_CRC_CpltCallback() is called at the end, from the DMA interrupt
+  *         (or directly, if BufferLength is less than 4).
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_CRC_Accumulate_DMA(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength)
+{
+  return CRC_DMA_Start(hcrc, pBuffer, BufferLength, 0U);
+}
+
+/**
+  * @brief  Starts the computation of the 32-bit CRC of a byte buffer with DMA,
+  *         independently of the previous CRC value.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @param  pBuffer: pointer to the buffer, of any alignment
+  * @param  BufferLength: length of the buffer in bytes
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_CRC_Calculate_DMA(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength)
+{
+  return CRC_DMA_Start(hcrc, pBuffer, BufferLength, 1U);
+}
+
+#endif /* HAL_DMA_MODULE_ENABLED */
+
+/**
+  * @brief  Waits for the end of a DMA computation.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @param  Timeout: timeout duration in ms, or HAL_MAX_DELAY
+  * @note   With the interrupts disabled by PRIMASK the DMA interrupt is
+  *         not taken, so its handler is called from here.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_CRC_PollForTransfer(CRC_HandleTypeDef *hcrc, uint32_t Timeout)
+{
+  uint32_t tickstart = HAL_GetTick();
+
+  while(hcrc->State == HAL_CRC_STATE_BUSY)
+  {
+#ifdef HAL_DMA_MODULE_ENABLED
+    if((__get_PRIMASK() != 0U) && (hcrc->hdma != NULL))
+    {
+      HAL_DMA_IRQHandler(hcrc->hdma);
+    }
+#endif /* HAL_DMA_MODULE_ENABLED */
+
+    if((Timeout != HAL_MAX_DELAY) && ((HAL_GetTick() - tickstart) > Timeout))
+    {
+      return HAL_TIMEOUT;
+    }
+  }
+
+  return (hcrc->ErrorCode == HAL_CRC_ERROR_NONE) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+  * @brief  Returns the current CRC value.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @retval 32-bit CRC
+  */
+uint32_t HAL_CRC_GetValue(CRC_HandleTypeDef *hcrc)
+{
+  return hcrc->Instance->DR;
+}
+
+/**
+  * @brief  DMA computation complete callback.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @retval None
+  */
+__weak void HAL_CRC_CpltCallback(CRC_HandleTypeDef *hcrc)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcrc);
+  /* NOTE : This function Should not be modified, when the callback is needed,
+            the HAL_CRC_CpltCallback could be implemented in the user file
+   */
+}
+
+/**
+  * @brief  DMA computation error callback.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @retval None
+  */
+__weak void HAL_CRC_ErrorCallback(CRC_HandleTypeDef *hcrc)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcrc);
+  /* NOTE : This function Should not be modified, when the callback is needed,
+            the HAL_CRC_ErrorCallback could be implemented in the user file
+   */
+}
+
 /**
   * @}
   */ 
@@ -330,6 +495,257 @@ HAL_CRC_StateTypeDef HAL_CRC_GetState(CRC_HandleTypeDef *hcrc)
   * @}
   */
 
+/**
+  * @}
+  */
+
+/** @addtogroup CRC_Private_Functions
+  * @{
+  */
+
+#ifdef HAL_DMA_MODULE_ENABLED
+
+/**
+  * @brief  Starts a DMA computation.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @param  pBuffer: pointer to the buffer, of any alignment
+  * @param  BufferLength: length of the buffer in bytes
+  * @param  Reset: if not zero, the unit is reset before the computation
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef CRC_DMA_Start(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength, uint32_t Reset)
+{
+  if(hcrc->hdma == NULL)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Check the parameters */
+  assert_param(hcrc->hdma->Init.PeriphDataAlignment == DMA_PDATAALIGN_BYTE);
+  assert_param(hcrc->hdma->Init.MemDataAlignment == DMA_MDATAALIGN_WORD);
+
+  /* Process Locked */
+  __HAL_LOCK(hcrc);
+
+  if(hcrc->State != HAL_CRC_STATE_READY)
+  {
+    /* Process Unlocked */
+    __HAL_UNLOCK(hcrc);
+
+    return HAL_BUSY;
+  }
+
+  /* Change CRC peripheral state */
+  hcrc->State = HAL_CRC_STATE_BUSY;
+
+  if(Reset != 0U)
+  {
+    /* Reset CRC Calculation Unit */
+    __HAL_CRC_DR_RESET(hcrc);
+  }
+
+  hcrc->pBuffPtr = pBuffer;
+  hcrc->ErrorCode = HAL_CRC_ERROR_NONE;
+  hcrc->XferCount = BufferLength;
+
+  /* Set the DMA callbacks */
+  hcrc->hdma->Parent = hcrc;
+  hcrc->hdma->XferCpltCallback = CRC_DMAXferCplt;
+  hcrc->hdma->XferHalfCpltCallback = NULL;
+  hcrc->hdma->XferErrorCallback = CRC_DMAError;
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(hcrc);
+
+  /* Start the first chunk, or process the short buffer */
+  CRC_DMA_Continue(hcrc);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
+/**
+  * @brief  Starts the DMA for the next chunk of full words, or completes
+  *         the computation with the last bytes.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @retval None
+  */
+static void CRC_DMA_Continue(CRC_HandleTypeDef *hcrc)
+{
+  const uint8_t *buffer = hcrc->pBuffPtr;
+  uint32_t length = hcrc->XferCount & ~3U;
+
+  if(length != 0U)
+  {
+    if(length > CRC_DMA_MAX_LENGTH)
+    {
+      length = CRC_DMA_MAX_LENGTH;
+    }
+    hcrc->pBuffPtr = buffer + length;
+    hcrc->XferCount -= length;
+
+    /* In memory-to-memory mode the peripheral port reads the buffer by
+       bytes, and the FIFO packs them in words for the memory port */
+    if(HAL_DMA_Start_IT(hcrc->hdma, (uint32_t)buffer, (uint32_t)&hcrc->Instance->DR, length) != HAL_OK)
+    {
+      /* Ready for a new computation, as after the other errors */
+      hcrc->ErrorCode = HAL_CRC_ERROR_DMA;
+      hcrc->State = HAL_CRC_STATE_READY;
+      HAL_CRC_ErrorCallback(hcrc);
+    }
+    return;
+  }
+
+  if(hcrc->XferCount != 0U)
+  {
+    /* The unit takes only words; the last bytes are processed in software,
+       and the unit is set to the result */
+    uint32_t crc = CRC_Bytes(hcrc->Instance->DR, buffer, hcrc->XferCount);
+    __HAL_CRC_DR_RESET(hcrc);
+    hcrc->Instance->DR = CRC_SeedWord(crc);
+    hcrc->XferCount = 0U;
+  }
+
+  hcrc->State = HAL_CRC_STATE_READY;
+  HAL_CRC_CpltCallback(hcrc);
+}
+
+/**
+  * @brief  DMA transfer complete callback.
+  * @param  hdma: DMA handle
+  * @retval None
+  */
+static void CRC_DMAXferCplt(DMA_HandleTypeDef *hdma)
+{
+  CRC_DMA_Continue((CRC_HandleTypeDef *)hdma->Parent);
+}
+
+/**
+  * @brief  DMA error callback.
+  * @param  hdma: DMA handle
+  * @retval None
+  */
+static void CRC_DMAError(DMA_HandleTypeDef *hdma)
+{
+  CRC_HandleTypeDef *hcrc = (CRC_HandleTypeDef *)hdma->Parent;
+
+  /* The FIFO error flag may be set in memory-to-memory mode, without
+     loss of data; only the transfer errors abort the computation */
+  if((hdma->ErrorCode & HAL_DMA_ERROR_TE) != 0U)
+  {
+    hcrc->ErrorCode = HAL_CRC_ERROR_DMA;
+    hcrc->State = HAL_CRC_STATE_READY;
+    HAL_CRC_ErrorCallback(hcrc);
+  }
+}
+
+#endif /* HAL_DMA_MODULE_ENABLED */
+
+/**
+  * @brief  Processes bytes in software, most significant bit first,
+  *         as the unit does with the bytes of a word.
+  * @param  crc: the current CRC value
+  * @param  pBuffer: pointer to the bytes
+  * @param  BufferLength: number of bytes
+  * @retval 32-bit CRC
+  */
+static uint32_t CRC_Bytes(uint32_t crc, const uint8_t *pBuffer, uint32_t BufferLength)
+{
+  uint32_t index = 0U;
+  uint32_t bit = 0U;
+
+  for(index = 0U; index < BufferLength; index++)
+  {
+    crc ^= (uint32_t)pBuffer[index] << 24;
+    for(bit = 0U; bit < 8U; bit++)
+    {
+      crc = ((crc & 0x80000000U) != 0U) ? ((crc << 1) ^ CRC_POLYNOMIAL) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+  * @brief  Returns the word that brings a reset unit to a given CRC value.
+  * @note   The unit has no initial value register; the 32 steps of a word
+  *         are reversed from the value (the polynomial is odd, so the
+  *         lowest bit tells if it was xored), and the result is xored
+  *         with the value after reset.
+  * @param  crc: the CRC value
+  * @retval the word to be written in DR after reset
+  */
+static uint32_t CRC_SeedWord(uint32_t crc)
+{
+  uint32_t bit = 0U;
+
+  for(bit = 0U; bit < 32U; bit++)
+  {
+    crc = ((crc & 1U) != 0U) ? (((crc ^ CRC_POLYNOMIAL) >> 1) | 0x80000000U) : (crc >> 1);
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
+
+#if defined(OS_USE_BENCH)
+
+#include "diag/Bench.h"
+
+/* 1 KB, from an aligned and from an odd address */
+static __ALIGN_BEGIN uint8_t CRC_BenchBuffer[1024U + 1U] __ALIGN_END;
+
+static void CRC_BenchCpu(void *arg)
+{
+  BENCH_KEEP(HAL_CRC_Calculate((CRC_HandleTypeDef *)arg, (uint32_t *)(void *)CRC_BenchBuffer, 1024U / 4U));
+}
+
+static void CRC_BenchDma(void *arg)
+{
+  HAL_CRC_Calculate_DMA((CRC_HandleTypeDef *)arg, CRC_BenchBuffer, 1024U);
+  HAL_CRC_PollForTransfer((CRC_HandleTypeDef *)arg, HAL_MAX_DELAY);
+}
+
+static void CRC_BenchDmaUnaligned(void *arg)
+{
+  HAL_CRC_Calculate_DMA((CRC_HandleTypeDef *)arg, CRC_BenchBuffer + 1U, 1024U);
+  HAL_CRC_PollForTransfer((CRC_HandleTypeDef *)arg, HAL_MAX_DELAY);
+}
+
+static bench_t CRC_Bench[] =
+{
+  { "crc_hw_cpu_1k", CRC_BenchCpu, NULL, NULL },
+  { "crc_hw_dma_1k", CRC_BenchDma, NULL, NULL },
+  { "crc_hw_dma_1k_unaligned", CRC_BenchDmaUnaligned, NULL, NULL }
+};
+
+/**
+  * @brief  Registers the benchmarks of the first initialized handle;
+  *         the DMA ones only if a DMA handle is linked.
+  * @param  hcrc: pointer to a CRC_HandleTypeDef structure that contains
+  *         the configuration information for CRC
+  * @retval None
+  */
+static void CRC_RegisterBench(CRC_HandleTypeDef *hcrc)
+{
+  uint32_t index = 0U;
+
+  if(CRC_Bench[0].arg != NULL)
+  {
+    return;
+  }
+
+  for(index = 0U; index < (sizeof(CRC_Bench) / sizeof(CRC_Bench[0])); index++)
+  {
+    if((index == 0U) || (hcrc->hdma != NULL))
+    {
+      CRC_Bench[index].arg = hcrc;
+      bench_register(&CRC_Bench[index]);
+    }
+  }
+}
+
+#endif /* OS_USE_BENCH */
+
 /**
   * @}
   */
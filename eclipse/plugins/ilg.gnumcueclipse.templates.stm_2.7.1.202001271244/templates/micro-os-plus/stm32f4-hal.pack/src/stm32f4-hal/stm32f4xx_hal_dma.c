@@ -114,6 +114,14 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
 
+/* With OS_USE_FAST_ISRS the interrupt handler is linked in RAM
+   (see cortexm/FastCode.h) */
+#if defined(OS_USE_FAST_ISRS)
+#include "cortexm/FastCode.h"
+#else
+#define OS_FAST_ISR
+#endif
+
 /** @addtogroup STM32F4xx_HAL_Driver
   * @{
   */
@@ -737,7 +745,7 @@ HAL_StatusTypeDef HAL_DMA_PollForTransfer(DMA_HandleTypeDef *hdma, HAL_DMA_Level
   *               the configuration information for the specified DMA Stream.  
   * @retval None
   */
-void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+OS_FAST_ISR void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
 {
   uint32_t tmpisr;
   __IO uint32_t count = 0;
@@ -105,6 +105,43 @@
        (+) Pause the DMA Transfer using HAL_UART_DMAPause()      
        (+) Resume the DMA Transfer using HAL_UART_DMAResume()  
        (+) Stop the DMA Transfer using HAL_UART_DMAStop()      
+
+     *** Circular DMA reception (Rx stream) ***
+     ==========================================
+     [..]
+       (+) Configure the Rx DMA stream in DMA_CIRCULAR mode, with the DMA and
+            the UART interrupts at the same preemption priority
+       (+) Start the reception into a ring buffer using HAL_UART_RxStream_Start()
+       (+) At half and full buffer, and when the line becomes idle,
+            HAL_UART_RxStreamCallback() is executed with the number of new bytes
+       (+) Get the received bytes in place using HAL_UART_RxStream_GetSpan(),
+            which returns the largest contiguous block, and give them back to
+            the DMA using HAL_UART_RxStream_Release()
+       (+) If the DMA overwrites bytes not yet released, all the unreleased
+            bytes are dropped, HAL_UART_ERROR_STREAM is set and
+            HAL_UART_ErrorCallback() is executed; the spans obtained before
+            must not be released
+       (+) Stop the reception using HAL_UART_RxStream_Stop()
+
+     *** DMA transmit queue ***
+     ==========================
+     [..]
+       (+) Queue any number of UART_TxDescTypeDef descriptors (pointer, size)
+            using HAL_UART_TxQueue_Put(), from the application or from interrupts;
+            the descriptors and the data must not be changed until sent
+       (+) The DMA transfer complete interrupt starts the next descriptor while
+            the UART still sends the last bytes, so the line has no gaps
+       (+) When a descriptor is sent, HAL_UART_TxQueueCallback() is executed and
+            the descriptor and its data may be reused
+       (+) When the queue is empty and the last byte left the line,
+            HAL_UART_TxCpltCallback() is executed
+       (+) Wait for the end of the transmission using HAL_UART_TxQueue_Flush()
+       (+) In case of DMA transfer error, or if the DMA cannot be restarted
+            for the next descriptor, the queue is emptied and
+            HAL_UART_ErrorCallback() is executed
+       (+) With OS_USE_BENCH, HAL_UART_RegisterBench() registers the transmit
+            benchmarks on a handle chosen by the application; they send
+            text lines on its line
     
      *** UART HAL driver macros list ***
      ============================================= 
@@ -156,6 +193,14 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
 
+/* With OS_USE_FAST_ISRS the interrupt handler is linked in RAM
+   (see cortexm/FastCode.h) */
+#if defined(OS_USE_FAST_ISRS)
+#include "cortexm/FastCode.h"
+#else
+#define OS_FAST_ISR
+#endif
+
 /** @addtogroup STM32F4xx_HAL_Driver
   * @{
   */
@@ -188,6 +233,11 @@ static void UART_DMATxHalfCplt(DMA_HandleTypeDef *hdma);
 static void UART_DMARxHalfCplt(DMA_HandleTypeDef *hdma);
 static void UART_DMAError(DMA_HandleTypeDef *hdma); 
 static void UART_DMAAbortOnError(DMA_HandleTypeDef *hdma);
+static void UART_DMARxStreamEvent(DMA_HandleTypeDef *hdma);
+static void UART_DMARxStreamError(DMA_HandleTypeDef *hdma);
+static void UART_RxStreamUpdate(UART_HandleTypeDef *huart);
+static void UART_DMATxQueueCplt(DMA_HandleTypeDef *hdma);
+static void UART_DMATxQueueError(DMA_HandleTypeDef *hdma);
 static HAL_StatusTypeDef UART_Transmit_IT(UART_HandleTypeDef *huart);
 static HAL_StatusTypeDef UART_EndTransmit_IT(UART_HandleTypeDef *huart);
 static HAL_StatusTypeDef UART_Receive_IT(UART_HandleTypeDef *huart);
@@ -587,6 +637,8 @@ HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart)
     (#) Non Blocking mode functions with DMA are:
         (++) HAL_UART_Transmit_DMA()
         (++) HAL_UART_Receive_DMA()
+        (++) HAL_UART_RxStream_Start()
+        (++) HAL_UART_TxQueue_Put()
 
     (#) A set of Transfer Complete Callbacks are provided in non blocking mode:
         (++) HAL_UART_TxCpltCallback()
@@ -1110,13 +1162,266 @@ HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart)
   return HAL_OK;
 }
 
+/**
+  * @brief  Starts the continuous reception in a ring buffer (DMA).
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  pData: Pointer to the ring buffer.
+  * @param  Size: Size of the ring buffer, in bytes.
+  * @note   The Rx DMA stream must be configured in DMA_CIRCULAR mode; the
+  *         reception does not end, HAL_UART_RxStreamCallback() announces the
+  *         new bytes at half and full buffer and when the line becomes idle.
+  * @note   Line errors do not stop the reception, the frames should be
+  *         protected by a checksum.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_UART_RxStream_Start(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  uint32_t *tmp;
+
+  /* Check that a Rx process is not already ongoing */
+  if(huart->RxState == HAL_UART_STATE_READY)
+  {
+    if((pData == NULL) || (Size == 0U) || (huart->hdmarx == NULL) ||
+       (huart->hdmarx->Init.Mode != DMA_CIRCULAR))
+    {
+      return HAL_ERROR;
+    }
+
+    /* Process Locked */
+    __HAL_LOCK(huart);
+
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxStreamHead = 0U;
+    huart->RxStreamTail = 0U;
+
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    /* The half and full transfer events only advance the write index */
+    huart->hdmarx->XferCpltCallback = UART_DMARxStreamEvent;
+    huart->hdmarx->XferHalfCpltCallback = UART_DMARxStreamEvent;
+    huart->hdmarx->XferErrorCallback = UART_DMARxStreamError;
+    huart->hdmarx->XferAbortCallback = NULL;
+
+    /* Enable the DMA stream */
+    tmp = (uint32_t*)&pData;
+    if(HAL_DMA_Start_IT(huart->hdmarx, (uint32_t)&huart->Instance->DR, *(uint32_t*)tmp, Size) != HAL_OK)
+    {
+      huart->RxState = HAL_UART_STATE_READY;
+      __HAL_UNLOCK(huart);
+      return HAL_ERROR;
+    }
+
+    /* Forget an idle line detected before the start */
+    __HAL_UART_CLEAR_IDLEFLAG(huart);
+
+    /* Process Unlocked */
+    __HAL_UNLOCK(huart);
+
+    /* Enable the UART Idle line Interrupt */
+    SET_BIT(huart->Instance->CR1, USART_CR1_IDLEIE);
+
+    /* Enable the DMA transfer for the receiver request by setting the DMAR bit
+       in the UART CR3 register */
+    SET_BIT(huart->Instance->CR3, USART_CR3_DMAR);
+
+    return HAL_OK;
+  }
+  else
+  {
+    return HAL_BUSY;
+  }
+}
+
+/**
+  * @brief  Stops the reception started by HAL_UART_RxStream_Start().
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_UART_RxStream_Stop(UART_HandleTypeDef *huart)
+{
+  if((huart->RxState == HAL_UART_STATE_BUSY_RX) &&
+     (HAL_IS_BIT_SET(huart->Instance->CR3, USART_CR3_DMAR)))
+  {
+    CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAR);
+
+    /* Abort the UART DMA Rx stream */
+    if(huart->hdmarx != NULL)
+    {
+      HAL_DMA_Abort(huart->hdmarx);
+    }
+
+    UART_EndRxTransfer(huart);
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Returns the oldest received bytes not yet released, in place.
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  pData: Set to the address of the first byte.
+  * @retval Number of contiguous bytes at pData; when the data wraps around
+  *         the end of the buffer, the rest is returned by the next call.
+  */
+uint16_t HAL_UART_RxStream_GetSpan(UART_HandleTypeDef *huart, uint8_t **pData)
+{
+  uint32_t head = huart->RxStreamHead;
+  uint32_t tail = huart->RxStreamTail;
+  uint32_t span;
+
+  span = (head >= tail) ? (head - tail) : (huart->RxXferSize - tail);
+  *pData = huart->pRxBuffPtr + tail;
+
+  /* Do not read the data before the index */
+  __DMB();
+
+  return (uint16_t)span;
+}
+
+/**
+  * @brief  Gives back to the DMA the bytes returned by HAL_UART_RxStream_GetSpan().
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  Size: Number of bytes processed, at most the span.
+  * @retval None
+  */
+void HAL_UART_RxStream_Release(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  uint32_t tail = (uint32_t)huart->RxStreamTail + Size;
+
+  if(tail >= huart->RxXferSize)
+  {
+    tail -= huart->RxXferSize;
+  }
+
+  /* The bytes must be read before the DMA may overwrite them */
+  __DMB();
+  huart->RxStreamTail = (uint16_t)tail;
+}
+
+/**
+  * @brief  Queues a buffer for transmission (DMA).
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  pDesc: Pointer to the descriptor of the buffer.
+  * @note   The Tx DMA stream must be configured in DMA_NORMAL mode.
+  * @note   May be called from interrupts; the buffers are sent back-to-back,
+  *         and HAL_UART_TxQueueCallback() is called when each one is sent.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_UART_TxQueue_Put(UART_HandleTypeDef *huart, UART_TxDescTypeDef *pDesc)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t primask;
+
+  if((pDesc == NULL) || (pDesc->pData == NULL) || (pDesc->Size == 0U) ||
+     (huart->hdmatx == NULL) || (huart->hdmatx->Init.Mode != DMA_NORMAL))
+  {
+    return HAL_ERROR;
+  }
+
+  pDesc->pNext = NULL;
+
+  /* The queue is also updated by the DMA interrupt */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if(huart->pTxQueueHead != NULL)
+  {
+    /* The DMA interrupt will start it */
+    huart->pTxQueueTail->pNext = pDesc;
+    huart->pTxQueueTail = pDesc;
+  }
+  else if((huart->gState == HAL_UART_STATE_READY) ||
+          ((huart->gState == HAL_UART_STATE_BUSY_TX) &&
+           (huart->hdmatx->XferCpltCallback == UART_DMATxQueueCplt)))
+  {
+    /* Idle, or the previous queue is still leaving the line */
+    CLEAR_BIT(huart->Instance->CR1, USART_CR1_TCIE);
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->ErrorCode &= ~HAL_UART_ERROR_DMA;
+
+    huart->hdmatx->XferCpltCallback = UART_DMATxQueueCplt;
+    huart->hdmatx->XferHalfCpltCallback = NULL;
+    huart->hdmatx->XferErrorCallback = UART_DMATxQueueError;
+    huart->hdmatx->XferAbortCallback = NULL;
+
+    huart->pTxQueueHead = pDesc;
+    huart->pTxQueueTail = pDesc;
+
+    if(HAL_DMA_Start_IT(huart->hdmatx, (uint32_t)pDesc->pData, (uint32_t)&huart->Instance->DR, pDesc->Size) == HAL_OK)
+    {
+      /* Clear the TC flag, it is set again after the last byte of the queue */
+      __HAL_UART_CLEAR_FLAG(huart, UART_FLAG_TC);
+
+      /* Enable the DMA transfer for transmit request by setting the DMAT bit
+         in the UART CR3 register */
+      SET_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+    }
+    else
+    {
+      huart->pTxQueueHead = NULL;
+      huart->pTxQueueTail = NULL;
+      huart->gState = HAL_UART_STATE_READY;
+      status = HAL_ERROR;
+    }
+  }
+  else
+  {
+    /* Another transmit process is ongoing */
+    status = HAL_BUSY;
+  }
+
+  __set_PRIMASK(primask);
+
+  return status;
+}
+
+/**
+  * @brief  Waits for the end of the ongoing transmission.
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  Timeout: Timeout duration.
+  * @note   With the interrupts disabled, the DMA and the UART interrupt
+  *         handlers are called from the loop.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_UART_TxQueue_Flush(UART_HandleTypeDef *huart, uint32_t Timeout)
+{
+  uint32_t tickstart = HAL_GetTick();
+
+  while(huart->gState == HAL_UART_STATE_BUSY_TX)
+  {
+    if(__get_PRIMASK() != 0U)
+    {
+      if(huart->hdmatx != NULL)
+      {
+        HAL_DMA_IRQHandler(huart->hdmatx);
+      }
+      HAL_UART_IRQHandler(huart);
+    }
+
+    if((Timeout != HAL_MAX_DELAY) && ((HAL_GetTick() - tickstart) > Timeout))
+    {
+      return HAL_TIMEOUT;
+    }
+  }
+
+  return ((huart->ErrorCode & HAL_UART_ERROR_DMA) == 0U) ? HAL_OK : HAL_ERROR;
+}
+
 /**
   * @brief  This function handles UART interrupt request.
   * @param  huart: pointer to a UART_HandleTypeDef structure that contains
   *                the configuration information for the specified UART module.
   * @retval None
   */
-void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+OS_FAST_ISR void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
 {
    uint32_t isrflags   = READ_REG(huart->Instance->SR);
    uint32_t cr1its     = READ_REG(huart->Instance->CR1);
@@ -1124,6 +1429,13 @@ void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
    uint32_t errorflags = 0x00U;
    uint32_t dmarequest = 0x00U;
 
+  /* UART Rx stream idle line ------------------------------------------------*/
+  if(((isrflags & USART_SR_IDLE) != RESET) && ((cr1its & USART_CR1_IDLEIE) != RESET))
+  {
+    __HAL_UART_CLEAR_IDLEFLAG(huart);
+    UART_RxStreamUpdate(huart);
+  }
+
   /* If no error occurs */
   errorflags = (isrflags & (uint32_t)(USART_SR_PE | USART_SR_FE | USART_SR_ORE | USART_SR_NE));
   if(errorflags == RESET)
@@ -1312,6 +1624,40 @@ __weak void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
    */ 
 }
 
+/**
+  * @brief  UART Rx stream callback.
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  Size: Number of bytes received since the previous call.
+  * @retval None
+  */
+ __weak void HAL_UART_RxStreamCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(huart);
+  UNUSED(Size);
+  /* NOTE: This function Should not be modified, when the callback is needed,
+           the HAL_UART_RxStreamCallback could be implemented in the user file
+   */
+}
+
+/**
+  * @brief  UART Tx queue callback.
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @param  pDesc: The descriptor sent; it may be reused.
+  * @retval None
+  */
+ __weak void HAL_UART_TxQueueCallback(UART_HandleTypeDef *huart, UART_TxDescTypeDef *pDesc)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(huart);
+  UNUSED(pDesc);
+  /* NOTE: This function Should not be modified, when the callback is needed,
+           the HAL_UART_TxQueueCallback could be implemented in the user file
+   */
+}
+
 /**
   * @}
   */
@@ -1695,6 +2041,10 @@ static void UART_EndTxTransfer(UART_HandleTypeDef *huart)
   /* Disable TXEIE and TCIE interrupts */
   CLEAR_BIT(huart->Instance->CR1, (USART_CR1_TXEIE | USART_CR1_TCIE));
 
+  /* Forget the descriptors not yet sent */
+  huart->pTxQueueHead = NULL;
+  huart->pTxQueueTail = NULL;
+
   /* At end of Tx process, restore huart->gState to Ready */
   huart->gState = HAL_UART_STATE_READY;
 }
@@ -1706,8 +2056,8 @@ static void UART_EndTxTransfer(UART_HandleTypeDef *huart)
   */
 static void UART_EndRxTransfer(UART_HandleTypeDef *huart)
 {
-  /* Disable RXNE, PE and ERR (Frame error, noise error, overrun error) interrupts */
-  CLEAR_BIT(huart->Instance->CR1, (USART_CR1_RXNEIE | USART_CR1_PEIE));
+  /* Disable RXNE, PE, IDLE and ERR (Frame error, noise error, overrun error) interrupts */
+  CLEAR_BIT(huart->Instance->CR1, (USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_IDLEIE));
   CLEAR_BIT(huart->Instance->CR3, USART_CR3_EIE);
 
   /* At end of Rx process, restore huart->RxState to Ready */
@@ -1729,6 +2079,161 @@ static void UART_DMAAbortOnError(DMA_HandleTypeDef *hdma)
   HAL_UART_ErrorCallback(huart);
 }
 
+/**
+  * @brief  DMA UART Rx stream half and full transfer callback.
+  * @param  hdma: DMA handle.
+  * @retval None
+  */
+static void UART_DMARxStreamEvent(DMA_HandleTypeDef *hdma)
+{
+  UART_RxStreamUpdate((UART_HandleTypeDef*)hdma->Parent);
+}
+
+/**
+  * @brief  DMA UART Rx stream error callback.
+  * @param  hdma: DMA handle.
+  * @retval None
+  */
+static void UART_DMARxStreamError(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef* huart = (UART_HandleTypeDef*)hdma->Parent;
+
+  /* The FIFO error flag may be set in direct mode without loss of
+     data; only the transfer errors stop the reception */
+  if((hdma->ErrorCode & HAL_DMA_ERROR_TE) != 0U)
+  {
+    CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAR);
+    UART_EndRxTransfer(huart);
+
+    huart->ErrorCode |= HAL_UART_ERROR_DMA;
+    HAL_UART_ErrorCallback(huart);
+  }
+}
+
+/**
+  * @brief  Advances the Rx stream write index to the DMA position and
+  *         announces the new bytes.
+  * @param  huart: UART handle.
+  * @note   Called by the UART and the DMA interrupts, which must not
+  *         preempt each other.
+  * @retval None
+  */
+static void UART_RxStreamUpdate(UART_HandleTypeDef *huart)
+{
+  uint32_t size = huart->RxXferSize;
+  uint32_t last = huart->RxStreamHead;
+  uint32_t tail = huart->RxStreamTail;
+  uint32_t used = (last >= tail) ? (last - tail) : (last + size - tail);
+  uint32_t head;
+  uint32_t count;
+
+  /* NDTR counts down and is reloaded with the size after the last byte */
+  head = size - __HAL_DMA_GET_COUNTER(huart->hdmarx);
+  if(head >= size)
+  {
+    head = 0U;
+  }
+
+  count = (head >= last) ? (head - last) : (head + size - last);
+  if(count == 0U)
+  {
+    return;
+  }
+
+  /* One byte is kept free, to tell a full buffer from an empty one */
+  if((used + count) >= size)
+  {
+    /* The DMA wrote over bytes not yet released, and possibly over bytes
+       being read; the whole window is dropped and the reading restarts
+       at the DMA position, with the next bytes */
+    huart->RxStreamHead = (uint16_t)head;
+    huart->RxStreamTail = (uint16_t)head;
+
+    huart->ErrorCode |= HAL_UART_ERROR_STREAM;
+    HAL_UART_ErrorCallback(huart);
+    return;
+  }
+
+  huart->RxStreamHead = (uint16_t)head;
+  HAL_UART_RxStreamCallback(huart, (uint16_t)count);
+}
+
+/**
+  * @brief  DMA UART Tx queue transfer complete callback.
+  * @param  hdma: DMA handle.
+  * @retval None
+  */
+static void UART_DMATxQueueCplt(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef* huart = (UART_HandleTypeDef*)hdma->Parent;
+  UART_TxDescTypeDef *pDesc;
+  UART_TxDescTypeDef *pNext;
+  uint32_t primask;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  pDesc = huart->pTxQueueHead;
+  pNext = pDesc->pNext;
+  huart->pTxQueueHead = pNext;
+
+  if(pNext != NULL)
+  {
+    /* Restart at once, the UART still has the last one or two bytes
+       to send */
+    status = HAL_DMA_Start_IT(hdma, (uint32_t)pNext->pData, (uint32_t)&huart->Instance->DR, pNext->Size);
+    if(status != HAL_OK)
+    {
+      /* The descriptors not yet sent are dropped, as on a DMA error */
+      CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+      UART_EndTxTransfer(huart);
+    }
+  }
+  else
+  {
+    huart->pTxQueueTail = NULL;
+
+    /* Disable the DMA transfer for transmit request by setting the DMAT bit
+       in the UART CR3 register */
+    CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+
+    /* Enable the UART Transmit Complete Interrupt */
+    SET_BIT(huart->Instance->CR1, USART_CR1_TCIE);
+  }
+
+  __set_PRIMASK(primask);
+
+  HAL_UART_TxQueueCallback(huart, pDesc);
+
+  if(status != HAL_OK)
+  {
+    huart->ErrorCode |= HAL_UART_ERROR_DMA;
+    HAL_UART_ErrorCallback(huart);
+  }
+}
+
+/**
+  * @brief  DMA UART Tx queue error callback.
+  * @param  hdma: DMA handle.
+  * @retval None
+  */
+static void UART_DMATxQueueError(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef* huart = (UART_HandleTypeDef*)hdma->Parent;
+
+  /* The FIFO error flag may be set in direct mode without loss of
+     data; only the transfer errors stop the queue */
+  if((hdma->ErrorCode & HAL_DMA_ERROR_TE) != 0U)
+  {
+    CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+    UART_EndTxTransfer(huart);
+
+    huart->ErrorCode |= HAL_UART_ERROR_DMA;
+    HAL_UART_ErrorCallback(huart);
+  }
+}
+
 /**
   * @brief  Sends an amount of data in non blocking mode.
   * @param  huart: Pointer to a UART_HandleTypeDef structure that contains
@@ -1941,6 +2446,88 @@ static void UART_SetConfig(UART_HandleTypeDef *huart)
   }
 }
 
+#if defined(OS_USE_BENCH)
+
+#include "diag/Bench.h"
+
+/* 1 KB, as 64 messages of 16 bytes; at 8N1 they take 10240 bit times
+   on the line, the rest of the measured time is the line idle time */
+#define UART_BENCH_COUNT  64U
+#define UART_BENCH_SIZE   16U
+
+static uint8_t UART_BenchBuffer[UART_BENCH_COUNT * UART_BENCH_SIZE];
+static UART_TxDescTypeDef UART_BenchDesc[UART_BENCH_COUNT];
+
+static void UART_BenchDmaLoop(void *arg)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)arg;
+  uint32_t index = 0U;
+
+  for(index = 0U; index < UART_BENCH_COUNT; index++)
+  {
+    HAL_UART_Transmit_DMA(huart, UART_BenchBuffer + (index * UART_BENCH_SIZE), UART_BENCH_SIZE);
+    HAL_UART_TxQueue_Flush(huart, HAL_MAX_DELAY);
+  }
+}
+
+static void UART_BenchQueue(void *arg)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)arg;
+  uint32_t index = 0U;
+
+  for(index = 0U; index < UART_BENCH_COUNT; index++)
+  {
+    HAL_UART_TxQueue_Put(huart, &UART_BenchDesc[index]);
+  }
+  HAL_UART_TxQueue_Flush(huart, HAL_MAX_DELAY);
+}
+
+static bench_t UART_Bench[] =
+{
+  { "uart_tx_dma_loop_16x64", UART_BenchDmaLoop, NULL, NULL },
+  { "uart_tx_queue_16x64", UART_BenchQueue, NULL, NULL }
+};
+
+/**
+  * @brief  Registers the transmit benchmarks on a handle with a Tx DMA
+  *         handle; the messages are printable lines.
+  * @note   Called by the application after HAL_UART_Init(), on a line
+  *         that may be used by the benchmarks; only one handle is
+  *         registered.
+  * @param  huart: pointer to a UART_HandleTypeDef structure that contains
+  *                the configuration information for the specified UART module.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_UART_RegisterBench(UART_HandleTypeDef *huart)
+{
+  uint32_t index = 0U;
+
+  if((UART_Bench[0].arg != NULL) || (huart->hdmatx == NULL))
+  {
+    return HAL_ERROR;
+  }
+
+  for(index = 0U; index < sizeof(UART_BenchBuffer); index++)
+  {
+    UART_BenchBuffer[index] = ((index % UART_BENCH_SIZE) == (UART_BENCH_SIZE - 1U)) ? '\n' : (uint8_t)('a' + (index % UART_BENCH_SIZE));
+  }
+  for(index = 0U; index < UART_BENCH_COUNT; index++)
+  {
+    UART_BenchDesc[index].pData = UART_BenchBuffer + (index * UART_BENCH_SIZE);
+    UART_BenchDesc[index].Size = UART_BENCH_SIZE;
+  }
+
+  for(index = 0U; index < (sizeof(UART_Bench) / sizeof(UART_Bench[0])); index++)
+  {
+    UART_Bench[index].arg = huart;
+    bench_register(&UART_Bench[index]);
+  }
+
+  return HAL_OK;
+}
+
+#endif /* OS_USE_BENCH */
+
 /**
   * @}
   */
@@ -168,6 +168,7 @@
 #define  USE_RTOS                     0U
 #define  PREFETCH_ENABLE              1U
 #define  ART_ACCLERATOR_ENABLE        1U /* To enable instruction cache and prefetch */
+#define  DMA_DCACHE_MAINTENANCE_ENABLE 0U /* Set to 1U to clean/invalidate the D-cache in the DMA start/complete paths */
 
 /* ########################## Assert Selection ############################## */
 /**
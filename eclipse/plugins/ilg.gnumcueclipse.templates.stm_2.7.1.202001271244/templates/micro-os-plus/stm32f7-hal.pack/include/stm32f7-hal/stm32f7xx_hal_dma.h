@@ -46,6 +46,12 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f7xx_hal_def.h"
 
+/* The automatic D-cache maintenance in the start and complete paths,
+   opt-in, enabled in stm32f7xx_hal_conf.h */
+#if !defined(DMA_DCACHE_MAINTENANCE_ENABLE)
+#define DMA_DCACHE_MAINTENANCE_ENABLE 0U
+#endif
+
 /** @addtogroup STM32F7xx_HAL_Driver
   * @{
   */
@@ -182,6 +188,9 @@ typedef struct __DMA_HandleTypeDef
  uint32_t                    StreamBaseAddress;                                            /*!< DMA Stream Base Address                */
 
  uint32_t                    StreamIndex;                                                  /*!< DMA Stream Index                       */
+
+ uint32_t                    CacheLength;                                                  /*!< Data length of the current transfer,
+                                                                                                used by the D-cache maintenance        */
  
 }DMA_HandleTypeDef;
 
@@ -661,6 +670,11 @@ void              HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
 HAL_StatusTypeDef HAL_DMA_CleanCallbacks(DMA_HandleTypeDef *hdma);
 HAL_StatusTypeDef HAL_DMA_RegisterCallback(DMA_HandleTypeDef *hdma, HAL_DMA_CallbackIDTypeDef CallbackID, void (* pCallback)(DMA_HandleTypeDef *_hdma));
 HAL_StatusTypeDef HAL_DMA_UnRegisterCallback(DMA_HandleTypeDef *hdma, HAL_DMA_CallbackIDTypeDef CallbackID);
+void              HAL_DMA_PrepareDCache(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+void              HAL_DMA_CompleteDCache(DMA_HandleTypeDef *hdma, uint32_t DstAddress, uint32_t DataLength);
+#if defined(OS_USE_BENCH)
+HAL_StatusTypeDef HAL_DMA_RegisterBench(DMA_HandleTypeDef *hdma);
+#endif /* OS_USE_BENCH */
 
 /**
   * @}
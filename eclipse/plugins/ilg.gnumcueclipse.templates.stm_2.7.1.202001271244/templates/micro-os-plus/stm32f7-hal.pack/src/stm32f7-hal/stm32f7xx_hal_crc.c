@@ -33,6 +33,36 @@
         input data buffer starting with the defined initialization value 
         (default or non-default) to initiate CRC calculation
 
+    (#) To process a byte buffer of any alignment and length without
+        the CPU, use HAL_CRC_Accumulate_DMA() or HAL_CRC_Calculate_DMA():
+         (++) link a DMA2 stream to the handle in HAL_CRC_MspInit() with
+              __HAL_LINKDMA(hcrc, hdma, hdma_crc), configured with
+              Direction = DMA_MEMORY_TO_MEMORY, PeriphInc = DMA_PINC_ENABLE,
+              MemInc = DMA_MINC_DISABLE, PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+              Mode = DMA_NORMAL, FIFOMode = DMA_FIFOMODE_ENABLE,
+              FIFOThreshold = DMA_FIFO_THRESHOLD_FULL; enable its interrupt
+              and call HAL_DMA_IRQHandler() from it
+         (++) with MemDataAlignment = DMA_MDATAALIGN_WORD the DMA packs each
+              4 bytes in a little endian word, as HAL_CRC_Accumulate() does
+              with CRC_INPUTDATA_FORMAT_WORDS on the same memory; with
+              DMA_MDATAALIGN_BYTE each byte is written alone, in memory order,
+              as with CRC_INPUTDATA_FORMAT_BYTES, at a lower rate
+         (++) the bytes after the last full DMA item are written to the
+              unit one by one
+         (++) with DMA_DCACHE_MAINTENANCE_ENABLE the DMA driver cleans the
+              buffer from the data cache before each transfer; otherwise
+              the application cleans it, with HAL_DMA_PrepareDCache(), or
+              places it in non cacheable memory
+         (++) HAL_CRC_CpltCallback() is called when done; the result is
+              returned by HAL_CRC_GetValue(). HAL_CRC_PollForTransfer()
+              waits for the end, also with the interrupts disabled
+         (++) on a DMA error HAL_CRC_ErrorCallback() is called with
+              ErrorCode set to HAL_CRC_ERROR_DMA, and the handle is
+              ready for a new computation
+         (++) with the default polynomial and no inversion, the software
+              equivalents are crc32_update_words() and crc32_update(),
+              in cortexm/Crc32.h
+
   @endverbatim
   ******************************************************************************
   * @attention
@@ -80,11 +110,21 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+#define CRC_DMA_MAX_LENGTH  0xFFFFU     /* Largest NDTR value */
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 static uint32_t CRC_Handle_8(CRC_HandleTypeDef *hcrc, uint8_t pBuffer[], uint32_t BufferLength);
 static uint32_t CRC_Handle_16(CRC_HandleTypeDef *hcrc, uint16_t pBuffer[], uint32_t BufferLength);
+#ifdef HAL_DMA_MODULE_ENABLED
+static HAL_StatusTypeDef CRC_DMA_Start(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength, uint32_t Reset);
+static void CRC_DMA_Continue(CRC_HandleTypeDef *hcrc);
+static void CRC_DMAXferCplt(DMA_HandleTypeDef *hdma);
+static void CRC_DMAError(DMA_HandleTypeDef *hdma);
+#endif /* HAL_DMA_MODULE_ENABLED */
+#if defined(OS_USE_BENCH)
+static void CRC_RegisterBench(CRC_HandleTypeDef *hcrc);
+#endif /* OS_USE_BENCH */
 /* Exported functions --------------------------------------------------------*/
 
 /** @defgroup CRC_Exported_Functions CRC Exported Functions
@@ -183,6 +223,10 @@ HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc)
   /* Change CRC peripheral state */
   hcrc->State = HAL_CRC_STATE_READY;
   
+#if defined(OS_USE_BENCH)
+  CRC_RegisterBench(hcrc);
+#endif /* OS_USE_BENCH */
+
   /* Return function status */
   return HAL_OK;
 }
@@ -277,6 +321,9 @@ __weak void HAL_CRC_MspDeInit(CRC_HandleTypeDef *hcrc)
           
       (+) Compute the 7, 8, 16 or 32-bit CRC value of an 8, 16 or 32-bit data buffer
           independently of the previous CRC value.
+          
+      (+) Compute the CRC value of a byte buffer with DMA, using combination
+          of the previous CRC value and the new one, or independently of it.
 
 @endverbatim
   * @{
@@ -404,6 +451,107 @@ uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t
   return temp;
 }
 
+#ifdef HAL_DMA_MODULE_ENABLED
+
+/**
+  * @brief  Start the computation of the CRC value of a byte buffer with DMA,
+  *         starting with the previously computed CRC as initialization value.
+  * @param  hcrc: CRC handle
+  * @param  pBuffer: pointer to the input data buffer, of any alignment; it
+  *         must not be changed until the end of the computation
+  * @param  BufferLength: input data buffer length, in bytes
+  * @note   HAL_CRC_CpltCallback() is called at the end, from the DMA interrupt
+  *         (or directly, if the buffer is shorter than a DMA item).
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_CRC_Accumulate_DMA(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength)
+{
+  return CRC_DMA_Start(hcrc, pBuffer, BufferLength, 0);
+}
+
+/**
+  * @brief  Start the computation of the CRC value of a byte buffer with DMA,
+  *         starting with hcrc->Instance->INIT as initialization value.
+  * @param  hcrc: CRC handle
+  * @param  pBuffer: pointer to the input data buffer, of any alignment
+  * @param  BufferLength: input data buffer length, in bytes
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_CRC_Calculate_DMA(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength)
+{
+  return CRC_DMA_Start(hcrc, pBuffer, BufferLength, 1);
+}
+
+#endif /* HAL_DMA_MODULE_ENABLED */
+
+/**
+  * @brief  Wait for the end of a DMA computation.
+  * @param  hcrc: CRC handle
+  * @param  Timeout: timeout duration in ms, or HAL_MAX_DELAY
+  * @note   With the interrupts disabled by PRIMASK the DMA interrupt is
+  *         not taken, so its handler is called from here.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_CRC_PollForTransfer(CRC_HandleTypeDef *hcrc, uint32_t Timeout)
+{
+  uint32_t tickstart = HAL_GetTick();
+
+  while(hcrc->State == HAL_CRC_STATE_BUSY)
+  {
+#ifdef HAL_DMA_MODULE_ENABLED
+    if((__get_PRIMASK() != 0) && (hcrc->hdma != NULL))
+    {
+      HAL_DMA_IRQHandler(hcrc->hdma);
+    }
+#endif /* HAL_DMA_MODULE_ENABLED */
+
+    if((Timeout != HAL_MAX_DELAY) && ((HAL_GetTick() - tickstart) > Timeout))
+    {
+      return HAL_TIMEOUT;
+    }
+  }
+
+  return (hcrc->ErrorCode == HAL_CRC_ERROR_NONE) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+  * @brief  Return the current CRC value.
+  * @param  hcrc: CRC handle
+  * @retval uint32_t CRC (returned value LSBs for CRC shorter than 32 bits)
+  */
+uint32_t HAL_CRC_GetValue(CRC_HandleTypeDef *hcrc)
+{
+  return hcrc->Instance->DR;
+}
+
+/**
+  * @brief  DMA computation complete callback.
+  * @param  hcrc: CRC handle
+  * @retval None
+  */
+__weak void HAL_CRC_CpltCallback(CRC_HandleTypeDef *hcrc)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcrc);
+  /* NOTE : This function should not be modified, when the callback is needed,
+            the HAL_CRC_CpltCallback can be implemented in the user file
+   */
+}
+
+/**
+  * @brief  DMA computation error callback.
+  * @param  hcrc: CRC handle
+  * @retval None
+  */
+__weak void HAL_CRC_ErrorCallback(CRC_HandleTypeDef *hcrc)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcrc);
+  /* NOTE : This function should not be modified, when the callback is needed,
+            the HAL_CRC_ErrorCallback can be implemented in the user file
+   */
+}
+
 /**             
   * @brief  Enter 8-bit input data to the CRC calculator.
   *         Specific data handling to optimize processing time.  
@@ -473,6 +621,221 @@ static uint32_t CRC_Handle_16(CRC_HandleTypeDef *hcrc, uint16_t pBuffer[], uint3
   return hcrc->Instance->DR;
 }
 
+#ifdef HAL_DMA_MODULE_ENABLED
+
+/**
+  * @brief  Start a DMA computation.
+  * @param  hcrc: CRC handle
+  * @param  pBuffer: pointer to the input data buffer, of any alignment
+  * @param  BufferLength: input data buffer length, in bytes
+  * @param  Reset: if not zero, the unit is reset before the computation
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef CRC_DMA_Start(CRC_HandleTypeDef *hcrc, const uint8_t *pBuffer, uint32_t BufferLength, uint32_t Reset)
+{
+  if(hcrc->hdma == NULL)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Check the parameters */
+  assert_param(hcrc->hdma->Init.PeriphDataAlignment == DMA_PDATAALIGN_BYTE);
+
+  /* Process locked */
+  __HAL_LOCK(hcrc);
+
+  if(hcrc->State != HAL_CRC_STATE_READY)
+  {
+    /* Process unlocked */
+    __HAL_UNLOCK(hcrc);
+
+    return HAL_BUSY;
+  }
+
+  /* Change CRC peripheral state */
+  hcrc->State = HAL_CRC_STATE_BUSY;
+
+  if(Reset != 0)
+  {
+    /* Reset CRC Calculation Unit (hcrc->Instance->INIT is 
+    *  written in hcrc->Instance->DR) */
+    __HAL_CRC_DR_RESET(hcrc);
+  }
+
+  hcrc->pBuffPtr = pBuffer;
+  hcrc->ErrorCode = HAL_CRC_ERROR_NONE;
+  hcrc->XferCount = BufferLength;
+
+  /* Set the DMA callbacks */
+  hcrc->hdma->Parent = hcrc;
+  hcrc->hdma->XferCpltCallback = CRC_DMAXferCplt;
+  hcrc->hdma->XferHalfCpltCallback = NULL;
+  hcrc->hdma->XferErrorCallback = CRC_DMAError;
+
+  /* Process unlocked */
+  __HAL_UNLOCK(hcrc);
+
+  /* Start the first chunk, or process the short buffer */
+  CRC_DMA_Continue(hcrc);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
+/**
+  * @brief  Start the DMA for the next chunk of full items, or complete
+  *         the computation with the last bytes.
+  * @param  hcrc: CRC handle
+  * @retval None
+  */
+static void CRC_DMA_Continue(CRC_HandleTypeDef *hcrc)
+{
+  const uint8_t *buffer = hcrc->pBuffPtr;
+  uint32_t item = 1;  /* Bytes written to DR by each DMA access */
+  uint32_t length = 0;
+
+  if(hcrc->hdma->Init.MemDataAlignment == DMA_MDATAALIGN_WORD)
+  {
+    item = 4;
+  }
+  else if(hcrc->hdma->Init.MemDataAlignment == DMA_MDATAALIGN_HALFWORD)
+  {
+    item = 2;
+  }
+
+  length = hcrc->XferCount & ~(item - 1);
+  if(length != 0)
+  {
+    if(length > CRC_DMA_MAX_LENGTH)
+    {
+      length = CRC_DMA_MAX_LENGTH & ~(item - 1);
+    }
+    hcrc->pBuffPtr = buffer + length;
+    hcrc->XferCount -= length;
+
+    /* In memory-to-memory mode the peripheral port reads the buffer by
+       bytes, and the FIFO packs them for the memory port */
+    if(HAL_DMA_Start_IT(hcrc->hdma, (uint32_t)buffer, (uint32_t)&hcrc->Instance->DR, length) != HAL_OK)
+    {
+      /* Ready for a new computation, as after the other errors */
+      hcrc->ErrorCode = HAL_CRC_ERROR_DMA;
+      hcrc->State = HAL_CRC_STATE_READY;
+      HAL_CRC_ErrorCallback(hcrc);
+    }
+    return;
+  }
+
+  /* The last bytes, as with CRC_INPUTDATA_FORMAT_BYTES */
+  for(; hcrc->XferCount != 0; hcrc->XferCount--)
+  {
+    *(__IO uint8_t*) (&hcrc->Instance->DR) = *buffer++;
+  }
+
+  hcrc->State = HAL_CRC_STATE_READY;
+  HAL_CRC_CpltCallback(hcrc);
+}
+
+/**
+  * @brief  DMA transfer complete callback.
+  * @param  hdma: DMA handle
+  * @retval None
+  */
+static void CRC_DMAXferCplt(DMA_HandleTypeDef *hdma)
+{
+  CRC_DMA_Continue((CRC_HandleTypeDef *)hdma->Parent);
+}
+
+/**
+  * @brief  DMA error callback.
+  * @param  hdma: DMA handle
+  * @retval None
+  */
+static void CRC_DMAError(DMA_HandleTypeDef *hdma)
+{
+  CRC_HandleTypeDef *hcrc = (CRC_HandleTypeDef *)hdma->Parent;
+
+  /* The FIFO error flag may be set in memory-to-memory mode, without
+     loss of data; only the transfer errors abort the computation */
+  if((hdma->ErrorCode & HAL_DMA_ERROR_TE) != 0)
+  {
+    hcrc->ErrorCode = HAL_CRC_ERROR_DMA;
+    hcrc->State = HAL_CRC_STATE_READY;
+    HAL_CRC_ErrorCallback(hcrc);
+  }
+}
+
+#endif /* HAL_DMA_MODULE_ENABLED */
+
+#if defined(OS_USE_BENCH)
+
+#include "diag/Bench.h"
+
+/* 1 KB, from an aligned and from an odd address */
+static __ALIGN_BEGIN uint8_t CRC_BenchBuffer[1024 + 1] __ALIGN_END;
+
+static void CRC_BenchCpu(void *arg)
+{
+  CRC_HandleTypeDef *hcrc = (CRC_HandleTypeDef *)arg;
+  uint32_t length = 1024;
+
+  /* HAL_CRC_Calculate() counts the items of the input format */
+  if(hcrc->InputDataFormat == CRC_INPUTDATA_FORMAT_WORDS)
+  {
+    length = 1024 / 4;
+  }
+  else if(hcrc->InputDataFormat == CRC_INPUTDATA_FORMAT_HALFWORDS)
+  {
+    length = 1024 / 2;
+  }
+  BENCH_KEEP(HAL_CRC_Calculate(hcrc, (uint32_t *)(void *)CRC_BenchBuffer, length));
+}
+
+static void CRC_BenchDma(void *arg)
+{
+  HAL_CRC_Calculate_DMA((CRC_HandleTypeDef *)arg, CRC_BenchBuffer, 1024);
+  HAL_CRC_PollForTransfer((CRC_HandleTypeDef *)arg, HAL_MAX_DELAY);
+}
+
+static void CRC_BenchDmaUnaligned(void *arg)
+{
+  HAL_CRC_Calculate_DMA((CRC_HandleTypeDef *)arg, CRC_BenchBuffer + 1, 1024);
+  HAL_CRC_PollForTransfer((CRC_HandleTypeDef *)arg, HAL_MAX_DELAY);
+}
+
+static bench_t CRC_Bench[] =
+{
+  { "crc_hw_cpu_1k", CRC_BenchCpu, NULL, NULL },
+  { "crc_hw_dma_1k", CRC_BenchDma, NULL, NULL },
+  { "crc_hw_dma_1k_unaligned", CRC_BenchDmaUnaligned, NULL, NULL }
+};
+
+/**
+  * @brief  Register the benchmarks of the first initialized handle;
+  *         the DMA ones only if a DMA handle is linked.
+  * @param  hcrc: CRC handle
+  * @retval None
+  */
+static void CRC_RegisterBench(CRC_HandleTypeDef *hcrc)
+{
+  uint32_t index = 0;
+
+  if(CRC_Bench[0].arg != NULL)
+  {
+    return;
+  }
+
+  for(index = 0; index < (sizeof(CRC_Bench) / sizeof(CRC_Bench[0])); index++)
+  {
+    if((index == 0) || (hcrc->hdma != NULL))
+    {
+      CRC_Bench[index].arg = hcrc;
+      bench_register(&CRC_Bench[index]);
+    }
+  }
+}
+
+#endif /* OS_USE_BENCH */
+
 /**
   * @}
   */
@@ -114,6 +114,14 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f7xx_hal.h"
 
+/* With OS_USE_FAST_ISRS the interrupt handler is linked in RAM
+   (see cortexm/FastCode.h) */
+#if defined(OS_USE_FAST_ISRS)
+#include "cortexm/FastCode.h"
+#else
+#define OS_FAST_ISR
+#endif
+
 /** @addtogroup STM32F7xx_HAL_Driver
   * @{
   */
@@ -139,10 +147,14 @@ typedef struct
  * @{
  */
  #define HAL_TIMEOUT_DMA_ABORT    ((uint32_t)5)  /* 5 ms */
+ #define DMA_DCACHE_LINE_SIZE     32U            /* Cortex-M7 cache line */
+ #define DMA_PSIZE_SHIFT          11U            /* DMA_SxCR_PSIZE position */
+ #define DMA_MSIZE_SHIFT          13U            /* DMA_SxCR_MSIZE position */
 /**
   * @}
   */
 /* Private macros ------------------------------------------------------------*/
+#define DMA_DCACHE_LINE(__ADDRESS__) ((uint32_t *)((__ADDRESS__) & ~(DMA_DCACHE_LINE_SIZE - 1U)))
 /* Private functions ---------------------------------------------------------*/
 /** @addtogroup DMA_Private_Functions
   * @{
@@ -150,6 +162,11 @@ typedef struct
 static void DMA_SetConfig(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
 static uint32_t DMA_CalcBaseAndBitshift(DMA_HandleTypeDef *hdma);
 static HAL_StatusTypeDef DMA_CheckFifoParam(DMA_HandleTypeDef *hdma);
+static uint32_t DMA_MemoryBytes(DMA_HandleTypeDef *hdma, uint32_t Increment, uint32_t DataLength);
+static uint32_t DMA_MaintainDCache(uint32_t Address, uint32_t Size);
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+static void DMA_CompleteDCache(DMA_HandleTypeDef *hdma, uint32_t Address, uint32_t Offset, uint32_t DataLength, uint32_t Refilled);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
 
 /**
   * @}
@@ -711,6 +728,18 @@ HAL_StatusTypeDef HAL_DMA_PollForTransfer(DMA_HandleTypeDef *hdma, HAL_DMA_Level
    status = HAL_ERROR;
   }
   
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+  /* Discard the cached copies of the received data */
+  if(CompleteLevel == HAL_DMA_FULL_TRANSFER)
+  {
+    DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength, 0U);
+  }
+  else
+  {
+    DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength / 2U, 0U);
+  }
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+
   /* Get the level transfer complete flag */
   if(CompleteLevel == HAL_DMA_FULL_TRANSFER)
   {
@@ -737,7 +766,7 @@ HAL_StatusTypeDef HAL_DMA_PollForTransfer(DMA_HandleTypeDef *hdma, HAL_DMA_Level
   *               the configuration information for the specified DMA Stream.  
   * @retval None
   */
-void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+OS_FAST_ISR void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
 {
   uint32_t tmpisr;
   __IO uint32_t count = 0;
@@ -801,6 +830,9 @@ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
         /* Current memory buffer used is Memory 0 */
         if((hdma->Instance->CR & DMA_SxCR_CT) == RESET)
         {
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength / 2U, 0U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
           if(hdma->XferHalfCpltCallback != NULL)
           {
             /* Half transfer callback */
@@ -810,6 +842,9 @@ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
         /* Current memory buffer used is Memory 1 */
         else
         {
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+          DMA_CompleteDCache(hdma, hdma->Instance->M1AR, 0U, hdma->CacheLength / 2U, 0U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
           if(hdma->XferM1HalfCpltCallback != NULL)
           {
             /* Half transfer callback */
@@ -826,11 +861,21 @@ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
           hdma->Instance->CR  &= ~(DMA_IT_HT);
         }
         
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+        DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength / 2U, 0U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
         if(hdma->XferHalfCpltCallback != NULL)
         {
           /* Half transfer callback */
           hdma->XferHalfCpltCallback(hdma);
         }
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+        /* The first half, refilled by the callback, is sent next */
+        if((hdma->Instance->CR & DMA_SxCR_CIRC) != RESET)
+        {
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength / 2U, 1U);
+        }
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
       }
     }
   }
@@ -874,25 +919,49 @@ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
         /* Current memory buffer used is Memory 0 */
         if((hdma->Instance->CR & DMA_SxCR_CT) == RESET)
         {
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+          DMA_CompleteDCache(hdma, hdma->Instance->M1AR, 0U, hdma->CacheLength, 0U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
           if(hdma->XferM1CpltCallback != NULL)
           {
             /* Transfer complete Callback for memory1 */
             hdma->XferM1CpltCallback(hdma);
           }
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+          DMA_CompleteDCache(hdma, hdma->Instance->M1AR, 0U, hdma->CacheLength, 1U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
         }
         /* Current memory buffer used is Memory 1 */
         else
         {
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength, 0U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
           if(hdma->XferCpltCallback != NULL)
           {
             /* Transfer complete Callback for memory0 */
             hdma->XferCpltCallback(hdma);
           }
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength, 1U);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
         }
       }
       /* Disable the transfer complete interrupt if the DMA mode is not CIRCULAR */
       else
       {
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+        /* In circular mode, the first half was done at half transfer */
+        if((hdma->Instance->CR & DMA_SxCR_CIRC) != RESET)
+        {
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, hdma->CacheLength / 2U, hdma->CacheLength - (hdma->CacheLength / 2U), 0U);
+        }
+        else
+        {
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, 0U, hdma->CacheLength, 0U);
+        }
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+
         if((hdma->Instance->CR & DMA_SxCR_CIRC) == RESET)
         {
           /* Disable the transfer complete interrupt */
@@ -910,6 +979,13 @@ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
           /* Transfer complete callback */
           hdma->XferCpltCallback(hdma);
         }
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+        /* The second half, refilled by the callback, is sent next */
+        if((hdma->Instance->CR & DMA_SxCR_CIRC) != RESET)
+        {
+          DMA_CompleteDCache(hdma, hdma->Instance->M0AR, hdma->CacheLength / 2U, hdma->CacheLength - (hdma->CacheLength / 2U), 1U);
+        }
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
       }
     }
   }
@@ -1078,6 +1154,108 @@ HAL_StatusTypeDef HAL_DMA_UnRegisterCallback(DMA_HandleTypeDef *hdma, HAL_DMA_Ca
   return status;
 }
 
+/**
+  * @brief  Prepares the D-cache for a transfer: cleans the source buffer
+  *         and cleans and invalidates the destination buffer in memory.
+  * @note   Called by the start functions when DMA_DCACHE_MAINTENANCE_ENABLE
+  *         is set; otherwise the application calls it before the start.
+  * @note   The buffers should be aligned to the 32 bytes cache line, and
+  *         their size rounded up to it; the lines partly covered are
+  *         shared with other data, which the CPU must not write until
+  *         HAL_DMA_CompleteDCache() is called.
+  *         The buffers in the DTCM are never cached and are skipped.
+  * @param  hdma:       pointer to a DMA_HandleTypeDef structure that contains
+  *                     the configuration information for the specified DMA Stream.
+  * @param  SrcAddress: The source memory Buffer address
+  * @param  DstAddress: The destination memory Buffer address
+  * @param  DataLength: The length of data to be transferred from source to destination
+  * @retval None
+  */
+void HAL_DMA_PrepareDCache(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+  uint32_t size;
+
+  if((SCB->CCR & SCB_CCR_DC_Msk) == 0U)
+  {
+    return;
+  }
+
+  if(hdma->Init.Direction == DMA_MEMORY_TO_PERIPH)
+  {
+    size = DMA_MaintainDCache(SrcAddress, DMA_MemoryBytes(hdma, hdma->Init.MemInc, DataLength));
+    SCB_CleanDCache_by_Addr(DMA_DCACHE_LINE(SrcAddress), (int32_t)size);
+  }
+  else
+  {
+    if(hdma->Init.Direction == DMA_MEMORY_TO_MEMORY)
+    {
+      /* The source is on the peripheral port */
+      size = DMA_MaintainDCache(SrcAddress, DMA_MemoryBytes(hdma, hdma->Init.PeriphInc, DataLength));
+      SCB_CleanDCache_by_Addr(DMA_DCACHE_LINE(SrcAddress), (int32_t)size);
+    }
+    /* The dirty lines must not be evicted over the received data */
+    size = DMA_MaintainDCache(DstAddress, DMA_MemoryBytes(hdma, hdma->Init.MemInc, DataLength));
+    SCB_CleanInvalidateDCache_by_Addr(DMA_DCACHE_LINE(DstAddress), (int32_t)size);
+  }
+}
+
+/**
+  * @brief  Discards the cached copies of a buffer written by a
+  *         peripheral to memory or memory to memory transfer, so the CPU
+  *         reads the data written by the DMA.
+  * @note   Called by HAL_DMA_IRQHandler() and HAL_DMA_PollForTransfer(),
+  *         before the callbacks, when DMA_DCACHE_MAINTENANCE_ENABLE is set.
+  * @note   The lines partly covered by the buffer are cleaned before they
+  *         are invalidated, so the data shared with them is kept; the
+  *         buffer bytes in these lines are then the ones written by the
+  *         DMA only if the CPU did not write these lines during the transfer.
+  * @param  hdma:       pointer to a DMA_HandleTypeDef structure that contains
+  *                     the configuration information for the specified DMA Stream.
+  * @param  DstAddress: The destination memory Buffer address
+  * @param  DataLength: The length of data transferred
+  * @retval None
+  */
+void HAL_DMA_CompleteDCache(DMA_HandleTypeDef *hdma, uint32_t DstAddress, uint32_t DataLength)
+{
+  uint32_t size;
+  uint32_t start;
+  uint32_t end;
+
+  if(((SCB->CCR & SCB_CCR_DC_Msk) == 0U) || (hdma->Init.Direction == DMA_MEMORY_TO_PERIPH))
+  {
+    return;
+  }
+
+  size = DMA_MaintainDCache(DstAddress, DMA_MemoryBytes(hdma, hdma->Init.MemInc, DataLength));
+  if(size == 0U)
+  {
+    return;
+  }
+
+  start = (uint32_t)DMA_DCACHE_LINE(DstAddress);
+  end = start + size;
+
+  /* Partial head line */
+  if(start != DstAddress)
+  {
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)start, (int32_t)DMA_DCACHE_LINE_SIZE);
+    start += DMA_DCACHE_LINE_SIZE;
+  }
+
+  /* Partial tail line, unless it is the head one */
+  if(((end & (DMA_DCACHE_LINE_SIZE - 1U)) != 0U) && (end > start))
+  {
+    end = (uint32_t)DMA_DCACHE_LINE(end);
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)end, (int32_t)DMA_DCACHE_LINE_SIZE);
+  }
+
+  /* Whole lines, only written by the DMA */
+  if(end > start)
+  {
+    SCB_InvalidateDCache_by_Addr((uint32_t *)start, (int32_t)(end - start));
+  }
+}
+
 /**
   * @}
   */
@@ -1145,6 +1323,11 @@ static void DMA_SetConfig(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t
   /* Clear DBM bit */
   hdma->Instance->CR &= (uint32_t)(~DMA_SxCR_DBM);
 
+  hdma->CacheLength = DataLength;
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+  HAL_DMA_PrepareDCache(hdma, SrcAddress, DstAddress, DataLength);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+
   /* Configure DMA Stream data length */
   hdma->Instance->NDTR = DataLength;
 
@@ -1289,6 +1472,187 @@ static HAL_StatusTypeDef DMA_CheckFifoParam(DMA_HandleTypeDef *hdma)
   return status; 
 }
 
+/**
+  * @brief  Returns the bytes of a buffer accessed by a transfer.
+  * @param  hdma:       pointer to a DMA_HandleTypeDef structure that contains
+  *                     the configuration information for the specified DMA Stream.
+  * @param  Increment:  DMA_MINC_ENABLE/DMA_PINC_ENABLE if the buffer address is incremented
+  * @param  DataLength: The length of data, in peripheral data size items
+  * @retval Size in bytes
+  */
+static uint32_t DMA_MemoryBytes(DMA_HandleTypeDef *hdma, uint32_t Increment, uint32_t DataLength)
+{
+  if(Increment == 0U)
+  {
+    /* A single item, of the memory data size */
+    return 1U << (hdma->Init.MemDataAlignment >> DMA_MSIZE_SHIFT);
+  }
+  return DataLength << (hdma->Init.PeriphDataAlignment >> DMA_PSIZE_SHIFT);
+}
+
+/**
+  * @brief  Returns the size to clean or invalidate from the cache line of
+  *         Address; 0 for the DTCM, which is never cached.
+  * @param  Address: Buffer address
+  * @param  Size:    Buffer size in bytes
+  * @retval Size in bytes, from the beginning of the first line
+  */
+static uint32_t DMA_MaintainDCache(uint32_t Address, uint32_t Size)
+{
+  if((Size == 0U) || ((Address >= RAMDTCM_BASE) && ((Address + Size) <= SRAM1_BASE)))
+  {
+    return 0U;
+  }
+  return Address + Size - (Address & ~(DMA_DCACHE_LINE_SIZE - 1U));
+}
+
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+/**
+  * @brief  Maintains the D-cache for a completed part of the memory buffer:
+  *         invalidates it for the received data, or cleans it after the
+  *         callback refilled it, in circular and double buffer transmit.
+  * @param  hdma:       pointer to a DMA_HandleTypeDef structure that contains
+  *                     the configuration information for the specified DMA Stream.
+  * @param  Address:    The memory buffer address (M0AR or M1AR)
+  * @param  Offset:     The first data item of the completed part
+  * @param  DataLength: The number of data items of the completed part
+  * @param  Refilled:   1 after the callback, 0 before it
+  * @retval None
+  */
+static void DMA_CompleteDCache(DMA_HandleTypeDef *hdma, uint32_t Address, uint32_t Offset, uint32_t DataLength, uint32_t Refilled)
+{
+  uint32_t size;
+
+  if(hdma->Init.MemInc == DMA_MINC_ENABLE)
+  {
+    Address += Offset << (hdma->Init.PeriphDataAlignment >> DMA_PSIZE_SHIFT);
+  }
+
+  if(Refilled == 0U)
+  {
+    HAL_DMA_CompleteDCache(hdma, Address, DataLength);
+  }
+  else if((hdma->Init.Direction == DMA_MEMORY_TO_PERIPH) && ((SCB->CCR & SCB_CCR_DC_Msk) != 0U))
+  {
+    size = DMA_MaintainDCache(Address, DMA_MemoryBytes(hdma, hdma->Init.MemInc, DataLength));
+    SCB_CleanDCache_by_Addr(DMA_DCACHE_LINE(Address), (int32_t)size);
+  }
+}
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+
+#if defined(OS_USE_BENCH)
+
+#include "diag/Bench.h"
+#include "cortexm/DmaBuffer.h"
+
+#if OS_INTEGER_BENCH_WARMUP < 1
+#error "The DMA benchmarks switch the D-cache in the warm-up runs"
+#endif
+
+/* 2 KB memory to memory, from and to cacheable buffers with the D-cache
+   on and off, and from and to the non cacheable .dmabuffer section.
+   The dcache_off one is registered first: its first warm-up run
+   disables the D-cache, and the first warm-up run of the next one
+   enables it again, so the switch is never measured. With the D-cache
+   on, the cleans and invalidates of the buffers are included.
+   The cacheable buffers are OS_CACHED_BSS, placed after the DTCM
+   (where .bss usually is, in the templates), which is never cached.
+   Since the D-cache is switched for the whole system, the benchmarks
+   are registered only by the application, with HAL_DMA_RegisterBench(). */
+#define DMA_BENCH_SIZE 2048U
+
+static uint8_t DMA_BenchSrc[DMA_BENCH_SIZE] OS_CACHED_BSS;
+static uint8_t DMA_BenchDst[DMA_BENCH_SIZE] OS_CACHED_BSS;
+static uint8_t DMA_BenchNcSrc[DMA_BENCH_SIZE] OS_DMA_BUFFER;
+static uint8_t DMA_BenchNcDst[DMA_BENCH_SIZE] OS_DMA_BUFFER;
+
+typedef struct
+{
+  DMA_HandleTypeDef *hdma;
+  uint8_t *pSrc;
+  uint8_t *pDst;
+  uint32_t DCache;             /* 0 to run with the D-cache disabled */
+} DMA_BenchTypeDef;
+
+static DMA_BenchTypeDef DMA_BenchParam[] =
+{
+  { NULL, DMA_BenchSrc, DMA_BenchDst, 0U },
+  { NULL, DMA_BenchSrc, DMA_BenchDst, 1U },
+  { NULL, DMA_BenchNcSrc, DMA_BenchNcDst, 1U }
+};
+
+/* Set if the D-cache was disabled by a benchmark */
+static uint32_t DMA_BenchDCacheDisabled;
+
+static void DMA_BenchM2M(void *arg)
+{
+  DMA_BenchTypeDef *param = (DMA_BenchTypeDef *)arg;
+  DMA_HandleTypeDef *hdma = param->hdma;
+  uint32_t length = DMA_BENCH_SIZE >> (hdma->Init.PeriphDataAlignment >> DMA_PSIZE_SHIFT);
+
+  if(param->DCache == 0U)
+  {
+    if((SCB->CCR & SCB_CCR_DC_Msk) != 0U)
+    {
+      DMA_BenchDCacheDisabled = 1U;
+      SCB_DisableDCache();
+    }
+  }
+  else if(DMA_BenchDCacheDisabled != 0U)
+  {
+    DMA_BenchDCacheDisabled = 0U;
+    SCB_EnableDCache();
+  }
+
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 0U)
+  HAL_DMA_PrepareDCache(hdma, (uint32_t)param->pSrc, (uint32_t)param->pDst, length);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+  if(HAL_DMA_Start(hdma, (uint32_t)param->pSrc, (uint32_t)param->pDst, length) == HAL_OK)
+  {
+    HAL_DMA_PollForTransfer(hdma, HAL_DMA_FULL_TRANSFER, HAL_MAX_DELAY);
+  }
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 0U)
+  HAL_DMA_CompleteDCache(hdma, (uint32_t)param->pDst, length);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+}
+
+static bench_t DMA_Bench[] =
+{
+  { "dma_m2m_2k_dcache_off", DMA_BenchM2M, &DMA_BenchParam[0], NULL },
+  { "dma_m2m_2k", DMA_BenchM2M, &DMA_BenchParam[1], NULL },
+  { "dma_m2m_2k_dmabuffer", DMA_BenchM2M, &DMA_BenchParam[2], NULL }
+};
+
+/**
+  * @brief  Registers the benchmarks on a memory to memory stream that
+  *         increments both addresses.
+  * @note   Called by the application after HAL_DMA_Init(); the benchmarks
+  *         disable and enable the D-cache, so nothing else may use it
+  *         while they run. Only one handle is registered.
+  * @param  hdma: DMA handle
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_DMA_RegisterBench(DMA_HandleTypeDef *hdma)
+{
+  uint32_t index = 0;
+
+  if((DMA_BenchParam[0].hdma != NULL) || (hdma->Init.Direction != DMA_MEMORY_TO_MEMORY)
+     || (hdma->Init.PeriphInc != DMA_PINC_ENABLE) || (hdma->Init.MemInc != DMA_MINC_ENABLE))
+  {
+    return HAL_ERROR;
+  }
+
+  for(index = 0; index < (sizeof(DMA_Bench) / sizeof(DMA_Bench[0])); index++)
+  {
+    DMA_BenchParam[index].hdma = hdma;
+    bench_register(&DMA_Bench[index]);
+  }
+
+  return HAL_OK;
+}
+
+#endif /* OS_USE_BENCH */
+
 /**
   * @}
   */
@@ -149,6 +149,18 @@ HAL_StatusTypeDef HAL_DMAEx_MultiBufferStart(DMA_HandleTypeDef *hdma, uint32_t S
       
       /* Configure the source, destination address and the data length */
       DMA_MultiBufferSetConfig(hdma, SrcAddress, DstAddress, DataLength);
+
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+      /* The configuration prepared the first buffer */
+      if(hdma->Init.Direction == DMA_MEMORY_TO_PERIPH)
+      {
+        HAL_DMA_PrepareDCache(hdma, SecondMemAddress, DstAddress, DataLength);
+      }
+      else
+      {
+        HAL_DMA_PrepareDCache(hdma, SrcAddress, SecondMemAddress, DataLength);
+      }
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
       
       /* Enable the peripheral */
       __HAL_DMA_ENABLE(hdma);
@@ -205,6 +217,18 @@ HAL_StatusTypeDef HAL_DMAEx_MultiBufferStart_IT(DMA_HandleTypeDef *hdma, uint32_
     
     /* Configure the source, destination address and the data length */
     DMA_MultiBufferSetConfig(hdma, SrcAddress, DstAddress, DataLength); 
+
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+    /* The configuration prepared the first buffer */
+    if(hdma->Init.Direction == DMA_MEMORY_TO_PERIPH)
+    {
+      HAL_DMA_PrepareDCache(hdma, SecondMemAddress, DstAddress, DataLength);
+    }
+    else
+    {
+      HAL_DMA_PrepareDCache(hdma, SrcAddress, SecondMemAddress, DataLength);
+    }
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
     
     /* Clear all flags */
     __HAL_DMA_CLEAR_FLAG (hdma, __HAL_DMA_GET_TC_FLAG_INDEX(hdma));
@@ -291,6 +315,11 @@ static void DMA_MultiBufferSetConfig(DMA_HandleTypeDef *hdma, uint32_t SrcAddres
 {
   /* Configure DMA Stream data length */
   hdma->Instance->NDTR = DataLength;
+
+  hdma->CacheLength = DataLength;
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+  HAL_DMA_PrepareDCache(hdma, SrcAddress, DstAddress, DataLength);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
   
   /* Peripheral to Memory */
   if((hdma->Init.Direction) == DMA_MEMORY_TO_PERIPH)
@@ -52,6 +52,33 @@
       (#) Get a received frame when an ETH RX interrupt occurs:
          (##) HAL_ETH_GetReceivedFrame_IT(); (called in IT mode only)
 
+      (#) Zero copy mode, with the buffers owned by the application (a pool):
+         (##) HAL_ETH_DMATxDescListInit_ZeroCopy() and HAL_ETH_DMARxDescListInit_ZeroCopy()
+              instead of the list init functions above; the Rx descriptors get
+              their buffers, of ETH_RX_ZC_BUF_SIZE bytes, from HAL_ETH_RxAllocateCallback()
+         (##) HAL_ETH_TransmitFrame_ZeroCopy() sends a chain of buffers, one
+              descriptor each; HAL_ETH_ReleaseTxFrames(), called from
+              HAL_ETH_TxCpltCallback() or polled, gives each frame back
+              through HAL_ETH_TxFreeCallback()
+         (##) HAL_ETH_GetReceivedFrame_ZeroCopy() hands up the buffer of a
+              received frame, replaced in its descriptor by a new one; the
+              frame must fit in one buffer;
+              the buffers are aligned on and sized in multiples of the
+              32 bytes D-cache line; with DMA_DCACHE_MAINTENANCE_ENABLE the
+              driver cleans and invalidates them, otherwise they must not
+              be cacheable (dma_buffer_alloc(), in cortexm/DmaBuffer.h)
+
+      (#) Interrupt coalescing, in zero copy mode:
+         (##) HAL_ETH_ConfigCoalescing() sets the Rx interrupts per millisecond
+              above which the Rx interrupt is disabled, and the sent frames
+              per Tx completion interrupt; the last frames of a burst are
+              released when the Tx ring becomes idle
+         (##) HAL_ETH_RxPoll(), called after HAL_ETH_RxCpltCallback() until it
+              returns less than its budget, hands the received frames to
+              HAL_ETH_RxPollCallback(), releases the sent ones, and enables
+              the Rx interrupt again when the ring is empty
+         (##) HAL_ETH_GetStats() reads the interrupt, poll and drop counters
+
       (#) Communicate with external PHY device:
          (##) Read a specific register from the PHY  
               HAL_ETH_ReadPHYRegister();
@@ -123,6 +150,8 @@
   */
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+/* The counters of a new handle */
+static const ETH_StatsTypeDef ETH_StatsReset = { 0U };
 /* Private function prototypes -----------------------------------------------*/
 /** @defgroup ETH_Private_Functions ETH Private Functions
   * @{
@@ -138,6 +167,12 @@ static void ETH_DMATransmissionDisable(ETH_HandleTypeDef *heth);
 static void ETH_DMAReceptionEnable(ETH_HandleTypeDef *heth);
 static void ETH_DMAReceptionDisable(ETH_HandleTypeDef *heth);
 static void ETH_FlushTransmitFIFO(ETH_HandleTypeDef *heth);
+static void ETH_RxRefill(ETH_HandleTypeDef *heth);
+static void ETH_CleanDCache(const uint8_t *pData, uint32_t Size);
+static void ETH_InvalidateDCache(uint8_t *pData, uint32_t Size);
+#if defined(OS_USE_BENCH)
+static void ETH_RegisterBench(ETH_HandleTypeDef *heth);
+#endif /* OS_USE_BENCH */
 
 /**
   * @}
@@ -189,6 +224,16 @@ HAL_StatusTypeDef HAL_ETH_Init(ETH_HandleTypeDef *heth)
   assert_param(IS_ETH_CHECKSUM_MODE(heth->Init.ChecksumMode));
   assert_param(IS_ETH_MEDIA_INTERFACE(heth->Init.MediaInterface));  
   
+  /* No coalescing until HAL_ETH_ConfigCoalescing(), and the counters
+     from zero */
+  heth->RxIntThreshold = 0U;
+  heth->RxIntTick = 0U;
+  heth->RxIntCount = 0U;
+  heth->RxPolling = 0U;
+  heth->TxIntBatch = 0U;
+  heth->TxIntCount = 0U;
+  heth->Stats = ETH_StatsReset;
+
   if(heth->State == HAL_ETH_STATE_RESET)
   {
     /* Allocate lock resource and initialize it */
@@ -598,6 +643,174 @@ HAL_StatusTypeDef HAL_ETH_DMARxDescListInit(ETH_HandleTypeDef *heth, ETH_DMADesc
   return HAL_OK;
 }
 
+/**
+  * @brief  Initializes the DMA Tx descriptors in chain mode, for the zero copy
+  *         mode: the buffers are set by HAL_ETH_TransmitFrame_ZeroCopy().
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  DMATxDescTab: Pointer to the first Tx desc list
+  * @param  TxDescCount: Number of the used Tx desc in the list
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_ETH_DMATxDescListInit_ZeroCopy(ETH_HandleTypeDef *heth, ETH_DMADescTypeDef *DMATxDescTab, uint32_t TxDescCount)
+{
+  uint32_t i = 0U;
+  ETH_DMADescTypeDef *dmatxdesc;
+
+  if(TxDescCount == 0U)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Process Locked */
+  __HAL_LOCK(heth);
+
+  /* Set the ETH peripheral state to BUSY */
+  heth->State = HAL_ETH_STATE_BUSY;
+
+  /* All the descriptors are free */
+  heth->TxDesc = DMATxDescTab;
+  heth->TxReleaseDesc = DMATxDescTab;
+  heth->TxDescFree = TxDescCount;
+  heth->TxIntCount = 0U;
+
+  /* Fill each DMATxDesc descriptor with the right values */
+  for(i=0U; i < TxDescCount; i++)
+  {
+    /* Get the pointer on the ith member of the Tx Desc list */
+    dmatxdesc = DMATxDescTab + i;
+
+    /* Set Second Address Chained bit */
+    dmatxdesc->Status = ETH_DMATXDESC_TCH;
+
+    /* No buffer yet */
+    dmatxdesc->Buffer1Addr = 0U;
+
+    if ((heth->Init).ChecksumMode == ETH_CHECKSUM_BY_HARDWARE)
+    {
+      /* Set the DMA Tx descriptors checksum insertion */
+      dmatxdesc->Status |= ETH_DMATXDESC_CHECKSUMTCPUDPICMPFULL;
+    }
+
+    /* Initialize the next descriptor with the Next Descriptor Polling Enable */
+    if(i < (TxDescCount-1U))
+    {
+      /* Set next descriptor address register with next descriptor base address */
+      dmatxdesc->Buffer2NextDescAddr = (uint32_t)(DMATxDescTab+i+1U);
+    }
+    else
+    {
+      /* For last descriptor, set next descriptor address register equal to the first descriptor base address */
+      dmatxdesc->Buffer2NextDescAddr = (uint32_t) DMATxDescTab;
+    }
+  }
+
+  /* Set Transmit Descriptor List Address Register */
+  (heth->Instance)->DMATDLAR = (uint32_t) DMATxDescTab;
+
+  /* Set ETH HAL State to Ready */
+  heth->State= HAL_ETH_STATE_READY;
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(heth);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
+/**
+  * @brief  Initializes the DMA Rx descriptors in chain mode, for the zero copy
+  *         mode: each descriptor gets a buffer of ETH_RX_ZC_BUF_SIZE bytes from
+  *         HAL_ETH_RxAllocateCallback(), and a new one each time its frame
+  *         is handed up by HAL_ETH_GetReceivedFrame_ZeroCopy().
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  DMARxDescTab: Pointer to the first Rx desc list
+  * @param  RxDescCount: Number of the used Rx desc in the list
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_ETH_DMARxDescListInit_ZeroCopy(ETH_HandleTypeDef *heth, ETH_DMADescTypeDef *DMARxDescTab, uint32_t RxDescCount)
+{
+  uint32_t i = 0U;
+  ETH_DMADescTypeDef *DMARxDesc;
+
+  if(RxDescCount == 0U)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Process Locked */
+  __HAL_LOCK(heth);
+
+  /* Set the ETH peripheral state to BUSY */
+  heth->State = HAL_ETH_STATE_BUSY;
+
+  /* All the descriptors wait for a buffer */
+  heth->RxDesc = DMARxDescTab;
+  heth->RxBuildDesc = DMARxDescTab;
+  heth->RxBuildCount = RxDescCount;
+
+  /* A new ring is not polled */
+  heth->RxIntCount = 0U;
+  if(heth->RxPolling != 0U)
+  {
+    heth->RxPolling = 0U;
+    __HAL_ETH_DMA_ENABLE_IT(heth, ETH_DMA_IT_R);
+  }
+
+  /* Fill each DMARxDesc descriptor with the right values */
+  for(i=0U; i < RxDescCount; i++)
+  {
+    /* Get the pointer on the ith member of the Rx Desc list */
+    DMARxDesc = DMARxDescTab+i;
+
+    /* Owned by the CPU until it gets a buffer */
+    DMARxDesc->Status = 0U;
+
+    /* Set Buffer1 size and Second Address Chained bit */
+    DMARxDesc->ControlBufferSize = ETH_DMARXDESC_RCH | ETH_RX_ZC_BUF_SIZE;
+
+    DMARxDesc->Buffer1Addr = 0U;
+
+    if((heth->Init).RxMode == ETH_RXINTERRUPT_MODE)
+    {
+      /* Enable Ethernet DMA Rx Descriptor interrupt */
+      DMARxDesc->ControlBufferSize &= ~ETH_DMARXDESC_DIC;
+    }
+
+    /* Initialize the next descriptor with the Next Descriptor Polling Enable */
+    if(i < (RxDescCount-1U))
+    {
+      /* Set next descriptor address register with next descriptor base address */
+      DMARxDesc->Buffer2NextDescAddr = (uint32_t)(DMARxDescTab+i+1U);
+    }
+    else
+    {
+      /* For last descriptor, set next descriptor address register equal to the first descriptor base address */
+      DMARxDesc->Buffer2NextDescAddr = (uint32_t)(DMARxDescTab);
+    }
+  }
+
+  /* Set Receive Descriptor List Address Register */
+  (heth->Instance)->DMARDLAR = (uint32_t) DMARxDescTab;
+
+  /* Give the descriptors their buffers */
+  ETH_RxRefill(heth);
+
+#if defined(OS_USE_BENCH)
+  ETH_RegisterBench(heth);
+#endif /* OS_USE_BENCH */
+
+  /* Set ETH HAL State to Ready */
+  heth->State= HAL_ETH_STATE_READY;
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(heth);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
 /**
   * @brief  Initializes the ETH MSP.
   * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
@@ -644,9 +857,13 @@ __weak void HAL_ETH_MspDeInit(ETH_HandleTypeDef *heth)
   [..]  This section provides functions allowing to:
         (+) Transmit a frame
             HAL_ETH_TransmitFrame();
+            HAL_ETH_TransmitFrame_ZeroCopy();
+            HAL_ETH_ReleaseTxFrames();
         (+) Receive a frame
             HAL_ETH_GetReceivedFrame();
             HAL_ETH_GetReceivedFrame_IT();
+            HAL_ETH_GetReceivedFrame_ZeroCopy();
+            HAL_ETH_RxPoll();
         (+) Read from an External PHY register
             HAL_ETH_ReadPHYRegister();
         (+) Write to an External PHY register
@@ -936,6 +1153,289 @@ HAL_StatusTypeDef HAL_ETH_GetReceivedFrame_IT(ETH_HandleTypeDef *heth)
   return HAL_ERROR;
 }
 
+/**
+  * @brief  Sends an Ethernet frame in zero copy mode: each buffer of the chain
+  *         takes a Tx descriptor and is sent as is; the buffers must not be
+  *         changed until the frame is released by HAL_ETH_ReleaseTxFrames().
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  pBuffers: Chain of the frame buffers
+  * @param  pContext: Context given to HAL_ETH_TxFreeCallback() when the frame
+  *         is released (for example the buffer or the packet)
+  * @retval HAL status: HAL_BUSY if there are not enough free Tx descriptors
+  */
+HAL_StatusTypeDef HAL_ETH_TransmitFrame_ZeroCopy(ETH_HandleTypeDef *heth, ETH_BufferTypeDef *pBuffers, void *pContext)
+{
+  ETH_BufferTypeDef *buffer;
+  ETH_DMADescTypeDef *dmatxdesc, *firstdesc;
+  uint32_t bufcount = 0U, status = 0U;
+
+  /* Get the number of needed Tx descriptors */
+  for(buffer = pBuffers; buffer != NULL; buffer = buffer->next)
+  {
+    if((buffer->len == 0U) || (buffer->len > ETH_DMATXDESC_TBS1))
+    {
+      return HAL_ERROR;
+    }
+    bufcount++;
+  }
+  if(bufcount == 0U)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Process Locked */
+  __HAL_LOCK(heth);
+
+  if(bufcount > heth->TxDescFree)
+  {
+    /* Process Unlocked */
+    __HAL_UNLOCK(heth);
+
+    return HAL_BUSY;
+  }
+
+  /* Set the ETH peripheral state to BUSY */
+  heth->State = HAL_ETH_STATE_BUSY;
+
+  firstdesc = heth->TxDesc;
+  dmatxdesc = firstdesc;
+  for(buffer = pBuffers; buffer != NULL; buffer = buffer->next)
+  {
+    /* The DMA reads the memory, not the D-cache */
+    ETH_CleanDCache(buffer->buffer, buffer->len);
+
+    /* Keep the chain and checksum insertion bits */
+    status = dmatxdesc->Status & (ETH_DMATXDESC_TCH | ETH_DMATXDESC_CIC);
+    if(dmatxdesc == firstdesc)
+    {
+      /* Setting the first segment bit; owned by the DMA last */
+      status |= ETH_DMATXDESC_FS;
+    }
+    else
+    {
+      status |= ETH_DMATXDESC_OWN;
+    }
+    if(buffer->next == NULL)
+    {
+      /* Setting the last segment bit; the interrupt to release the frames
+         is every TxIntBatch frames, and when the ring gets full */
+      status |= ETH_DMATXDESC_LS;
+      heth->TxIntCount++;
+      if((heth->TxIntCount >= heth->TxIntBatch) || (bufcount == heth->TxDescFree))
+      {
+        status |= ETH_DMATXDESC_IC;
+        heth->TxIntCount = 0U;
+      }
+      dmatxdesc->Reserved1 = (uint32_t)pContext;
+    }
+
+    dmatxdesc->Buffer1Addr = (uint32_t)buffer->buffer;
+    dmatxdesc->ControlBufferSize = (buffer->len & ETH_DMATXDESC_TBS1);
+
+    /* The descriptor is complete before the DMA may own it */
+    __DMB();
+    dmatxdesc->Status = status;
+
+    /* Point to next descriptor */
+    dmatxdesc = (ETH_DMADescTypeDef *)(dmatxdesc->Buffer2NextDescAddr);
+  }
+  heth->TxDesc = dmatxdesc;
+  heth->TxDescFree -= bufcount;
+
+  /* Give the first descriptor last, the DMA never sees a partial frame */
+  __DMB();
+  firstdesc->Status |= ETH_DMATXDESC_OWN;
+
+  /* Clear the Tx buffer unavailable flag and resume the transmission; the
+     flag may have been cleared by the interrupt handler, with the DMA
+     suspended */
+  (heth->Instance)->DMASR = ETH_DMASR_TBUS;
+  (heth->Instance)->DMATPDR = 0U;
+
+  /* Set ETH HAL State to Ready */
+  heth->State = HAL_ETH_STATE_READY;
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(heth);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
+/**
+  * @brief  Releases the frames sent in zero copy mode, calling
+  *         HAL_ETH_TxFreeCallback() with the context of each of them.
+  *         Called from HAL_ETH_TxCpltCallback() or polled; the callback
+  *         must not transmit, the handle is locked.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_ETH_ReleaseTxFrames(ETH_HandleTypeDef *heth)
+{
+  ETH_DMADescTypeDef *dmatxdesc;
+
+  /* Process Locked */
+  __HAL_LOCK(heth);
+
+  /* The descriptors between the release and the set pointers are in use,
+     all of them when the pointers meet with none free */
+  while(((heth->TxReleaseDesc != heth->TxDesc) || (heth->TxDescFree == 0U)) &&
+        (((heth->TxReleaseDesc)->Status & ETH_DMATXDESC_OWN) == (uint32_t)RESET))
+  {
+    dmatxdesc = heth->TxReleaseDesc;
+    heth->TxReleaseDesc = (ETH_DMADescTypeDef *)(dmatxdesc->Buffer2NextDescAddr);
+    heth->TxDescFree++;
+
+    if((dmatxdesc->Status & ETH_DMATXDESC_LS) != (uint32_t)RESET)
+    {
+      HAL_ETH_TxFreeCallback(heth, (void *)dmatxdesc->Reserved1);
+    }
+  }
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(heth);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
+/**
+  * @brief  Gets a received frame in zero copy mode: the buffer is handed up,
+  *         and replaced in its descriptor by a new one from
+  *         HAL_ETH_RxAllocateCallback(); the application frees it when done.
+  *         The frames in error, or longer than ETH_RX_ZC_BUF_SIZE, are dropped.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  pBuffer: Pointer to the frame buffer
+  * @param  pLength: Pointer to the frame length, without the CRC
+  * @retval HAL status: HAL_ERROR if there is no received frame
+  */
+HAL_StatusTypeDef HAL_ETH_GetReceivedFrame_ZeroCopy(ETH_HandleTypeDef *heth, uint8_t **pBuffer, uint32_t *pLength)
+{
+  ETH_DMADescTypeDef *dmarxdesc;
+  uint32_t status = 0U, buff = 0U;
+  HAL_StatusTypeDef result = HAL_ERROR;
+
+  /* Process Locked */
+  __HAL_LOCK(heth);
+
+  /* Check the ETH state to BUSY */
+  heth->State = HAL_ETH_STATE_BUSY;
+
+  /* Stop at the first good frame, or at a descriptor owned by the DMA
+     or waiting for a buffer */
+  while((result != HAL_OK) &&
+        ((heth->RxDesc != heth->RxBuildDesc) || (heth->RxBuildCount == 0U)) &&
+        (((status = (heth->RxDesc)->Status) & ETH_DMARXDESC_OWN) == (uint32_t)RESET))
+  {
+    dmarxdesc = heth->RxDesc;
+    heth->RxDesc = (ETH_DMADescTypeDef *)(dmarxdesc->Buffer2NextDescAddr);
+
+    if((status & (ETH_DMARXDESC_FS | ETH_DMARXDESC_LS | ETH_DMARXDESC_ES)) == (ETH_DMARXDESC_FS | ETH_DMARXDESC_LS))
+    {
+      /* Hand the buffer up, the descriptor waits for a new one */
+      *pBuffer = (uint8_t *)dmarxdesc->Buffer1Addr;
+      *pLength = ((status & ETH_DMARXDESC_FL) >> ETH_DMARXDESC_FRAMELENGTHSHIFT) - 4U;
+      dmarxdesc->Buffer1Addr = 0U;
+      heth->RxBuildCount++;
+      /* Drop the lines the CPU may have loaded while the DMA owned it */
+      ETH_InvalidateDCache(*pBuffer, *pLength);
+
+      result = HAL_OK;
+    }
+    else
+    {
+      /* Drop the frame: its buffer goes back to the DMA, in the first
+         descriptor waiting for one, which keeps them in the ring order */
+      buff = dmarxdesc->Buffer1Addr;
+      dmarxdesc->Buffer1Addr = 0U;
+      (heth->RxBuildDesc)->Buffer1Addr = buff;
+      __DMB();
+      (heth->RxBuildDesc)->Status = ETH_DMARXDESC_OWN;
+      heth->RxBuildDesc = (ETH_DMADescTypeDef *)((heth->RxBuildDesc)->Buffer2NextDescAddr);
+      heth->Stats.RxDropped++;
+    }
+  }
+
+  /* Replace the buffer handed up */
+  ETH_RxRefill(heth);
+
+  /* Set HAL State to Ready */
+  heth->State = HAL_ETH_STATE_READY;
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(heth);
+
+  /* Return function status */
+  return result;
+}
+
+/**
+  * @brief  Hands up to Budget received frames to HAL_ETH_RxPollCallback(), in
+  *         zero copy mode, after releasing the sent frames. When the ring is
+  *         empty and the Rx interrupt was disabled by the coalescing, it is
+  *         enabled again.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  Budget: Maximum number of frames
+  * @retval Number of frames; when equal to Budget, there may be more. Budget
+  *         is also returned when the handle is locked by another context,
+  *         the ring is then polled again.
+  */
+uint32_t HAL_ETH_RxPoll(ETH_HandleTypeDef *heth, uint32_t Budget)
+{
+  uint8_t *buff = NULL;
+  uint32_t length = 0U, count = 0U, cleared = 0U;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  /* Including the frames sent without a completion interrupt */
+  HAL_ETH_ReleaseTxFrames(heth);
+
+  while(count < Budget)
+  {
+    status = HAL_ETH_GetReceivedFrame_ZeroCopy(heth, &buff, &length);
+    if(status == HAL_OK)
+    {
+      HAL_ETH_RxPollCallback(heth, buff, length);
+      count++;
+    }
+    else if(status == HAL_BUSY)
+    {
+      /* Not an empty ring: stay in the polling mode, and ask for
+         another poll */
+      break;
+    }
+    else if((heth->RxPolling != 0U) && (cleared == 0U))
+    {
+      /* A frame received from now on sets the flag again, and raises
+         the interrupt once enabled: clear it, and check once more */
+      __HAL_ETH_DMA_CLEAR_IT(heth, ETH_DMA_IT_R);
+      cleared = 1U;
+    }
+    else
+    {
+      if(heth->RxPolling != 0U)
+      {
+        /* Empty ring: back to the interrupts */
+        heth->RxPolling = 0U;
+        __HAL_ETH_DMA_ENABLE_IT(heth, ETH_DMA_IT_R);
+      }
+      break;
+    }
+  }
+
+  heth->Stats.Polls++;
+  heth->Stats.PollFrames += count;
+  if(count == Budget)
+  {
+    heth->Stats.PollsExhausted++;
+  }
+
+  return (status == HAL_BUSY) ? Budget : count;
+}
+
 /**
   * @brief  This function handles ETH interrupt request.
   * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
@@ -944,36 +1444,59 @@ HAL_StatusTypeDef HAL_ETH_GetReceivedFrame_IT(ETH_HandleTypeDef *heth)
   */
 void HAL_ETH_IRQHandler(ETH_HandleTypeDef *heth)
 {
-  /* Frame received */
-  if (__HAL_ETH_DMA_GET_FLAG(heth, ETH_DMA_FLAG_R)) 
+  uint32_t tick = 0U;
+
+  /* The lock and the state belong to the thread context functions this
+     interrupt may preempt (HAL_ETH_TransmitFrame_ZeroCopy(),
+     HAL_ETH_RxPoll(), ...); the handler must not release them */
+
+  heth->Stats.Interrupts++;
+
+  /* Frame received, unless the Rx interrupt is disabled and the ring polled */
+  if (__HAL_ETH_DMA_GET_FLAG(heth, ETH_DMA_FLAG_R) &&
+      (((heth->Instance)->DMAIER & ETH_DMA_IT_R) != (uint32_t)RESET))
   {
+    heth->Stats.RxInterrupts++;
+
+    if(heth->RxIntThreshold != 0U)
+    {
+      /* Count the Rx interrupts of the current millisecond */
+      tick = HAL_GetTick();
+      if(tick != heth->RxIntTick)
+      {
+        heth->RxIntTick = tick;
+        heth->RxIntCount = 0U;
+      }
+      heth->RxIntCount++;
+
+      if(heth->RxIntCount > heth->RxIntThreshold)
+      {
+        /* Flood: no Rx interrupt until HAL_ETH_RxPoll() empties the ring */
+        __HAL_ETH_DMA_DISABLE_IT(heth, ETH_DMA_IT_R);
+        heth->RxPolling = 1U;
+        heth->Stats.RxPollModes++;
+      }
+    }
+
     /* Receive complete callback */
     HAL_ETH_RxCpltCallback(heth);
     
      /* Clear the Eth DMA Rx IT pending bits */
     __HAL_ETH_DMA_CLEAR_IT(heth, ETH_DMA_IT_R);
-
-    /* Set HAL State to Ready */
-    heth->State = HAL_ETH_STATE_READY;
-    
-    /* Process Unlocked */
-    __HAL_UNLOCK(heth);
-
   }
-  /* Frame transmitted */
-  else if (__HAL_ETH_DMA_GET_FLAG(heth, ETH_DMA_FLAG_T)) 
+  /* Frame transmitted, or Tx ring idle when the frames are batched */
+  else if (__HAL_ETH_DMA_GET_FLAG(heth, ETH_DMA_FLAG_T) ||
+           (__HAL_ETH_DMA_GET_FLAG(heth, ETH_DMA_FLAG_TBU) &&
+            (((heth->Instance)->DMAIER & ETH_DMA_IT_TBU) != (uint32_t)RESET)))
   {
+    heth->Stats.TxInterrupts++;
+
+    /* Clear the Eth DMA Tx IT pending bits, before the frames sent from
+       the callback may set them again */
+    __HAL_ETH_DMA_CLEAR_IT(heth, ETH_DMA_IT_T | ETH_DMA_IT_TBU);
+
     /* Transfer complete callback */
     HAL_ETH_TxCpltCallback(heth);
-    
-    /* Clear the Eth DMA Tx IT pending bits */
-    __HAL_ETH_DMA_CLEAR_IT(heth, ETH_DMA_IT_T);
-
-    /* Set HAL State to Ready */
-    heth->State = HAL_ETH_STATE_READY;
-    
-    /* Process Unlocked */
-    __HAL_UNLOCK(heth);
   }
   
   /* Clear the interrupt flags */
@@ -987,12 +1510,6 @@ void HAL_ETH_IRQHandler(ETH_HandleTypeDef *heth)
 
     /* Clear the interrupt flags */
     __HAL_ETH_DMA_CLEAR_IT(heth, ETH_DMA_FLAG_AIS);
-  
-    /* Set HAL State to Ready */
-    heth->State = HAL_ETH_STATE_READY;
-    
-    /* Process Unlocked */
-    __HAL_UNLOCK(heth);
   }
 }
 
@@ -1044,6 +1561,61 @@ __weak void HAL_ETH_ErrorCallback(ETH_HandleTypeDef *heth)
   */ 
 }
 
+/**
+  * @brief  Rx buffer allocation callback, for the zero copy mode.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  buff: Pointer to the new buffer, of ETH_RX_ZC_BUF_SIZE bytes and
+  *         aligned on 32 bytes; left NULL when there is none, the
+  *         descriptor is refilled later
+  * @retval None
+  */
+__weak void HAL_ETH_RxAllocateCallback(ETH_HandleTypeDef *heth, uint8_t **buff)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(heth);
+  UNUSED(buff);
+  /* NOTE : This function Should not be modified, when the callback is needed,
+  the HAL_ETH_RxAllocateCallback could be implemented in the user file
+  */
+}
+
+/**
+  * @brief  Tx frame release callback, for the zero copy mode.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  pContext: Context of the frame, as given to HAL_ETH_TransmitFrame_ZeroCopy()
+  * @retval None
+  */
+__weak void HAL_ETH_TxFreeCallback(ETH_HandleTypeDef *heth, void *pContext)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(heth);
+  UNUSED(pContext);
+  /* NOTE : This function Should not be modified, when the callback is needed,
+  the HAL_ETH_TxFreeCallback could be implemented in the user file
+  */
+}
+
+/**
+  * @brief  Received frame callback of HAL_ETH_RxPoll().
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  buff: Frame buffer, owned by the application from now on
+  * @param  Length: Frame length, without the CRC
+  * @retval None
+  */
+__weak void HAL_ETH_RxPollCallback(ETH_HandleTypeDef *heth, uint8_t *buff, uint32_t Length)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(heth);
+  UNUSED(buff);
+  UNUSED(Length);
+  /* NOTE : This function Should not be modified, when the callback is needed,
+  the HAL_ETH_RxPollCallback could be implemented in the user file
+  */
+}
+
 /**
   * @brief  Reads a PHY register
   * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
@@ -1209,6 +1781,8 @@ HAL_StatusTypeDef HAL_ETH_WritePHYRegister(ETH_HandleTypeDef *heth, uint16_t PHY
           HAL_ETH_ConfigMAC();
       (+) Set the DMA configuration in runtime mode
           HAL_ETH_ConfigDMA();
+      (+) Set the interrupt coalescing
+          HAL_ETH_ConfigCoalescing();
 
 @endverbatim
   * @{
@@ -1545,6 +2119,60 @@ HAL_StatusTypeDef HAL_ETH_ConfigDMA(ETH_HandleTypeDef *heth, ETH_DMAInitTypeDef
    return HAL_OK; 
 }
 
+/**
+  * @brief  Sets the interrupt coalescing, for the zero copy mode.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  RxIntThreshold: Rx interrupts in a millisecond above which the Rx
+  *         interrupt is disabled, until HAL_ETH_RxPoll() finds the ring empty;
+  *         0 to keep it enabled
+  * @param  TxIntBatch: Sent frames per Tx completion interrupt, 0 or 1 for
+  *         each of them; the frames are also released by HAL_ETH_RxPoll()
+  * @note   With TxIntBatch above 1, the last frames of a burst are released
+  *         when the Tx ring becomes idle, by the Tx buffer unavailable
+  *         interrupt; the DMA must then close each frame before fetching
+  *         the next descriptor, and the operate on second frame mode is
+  *         disabled. It is enabled again, as by HAL_ETH_Init(), otherwise.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_ETH_ConfigCoalescing(ETH_HandleTypeDef *heth, uint32_t RxIntThreshold, uint32_t TxIntBatch)
+{
+  uint32_t tmpreg = 0U;
+
+  /* Process Locked */
+  __HAL_LOCK(heth);
+
+  heth->RxIntThreshold = RxIntThreshold;
+  heth->RxIntCount = 0U;
+  heth->TxIntBatch = TxIntBatch;
+  heth->TxIntCount = 0U;
+
+  tmpreg = (heth->Instance)->DMAOMR;
+  if(TxIntBatch > 1U)
+  {
+    tmpreg &= ~ETH_DMAOMR_OSF;
+    __HAL_ETH_DMA_ENABLE_IT(heth, ETH_DMA_IT_TBU);
+  }
+  else
+  {
+    tmpreg |= ETH_DMAOMR_OSF;
+    __HAL_ETH_DMA_DISABLE_IT(heth, ETH_DMA_IT_TBU);
+  }
+  (heth->Instance)->DMAOMR = tmpreg;
+
+  /* Wait until the write operation will be taken into account:
+  at least four TX_CLK/RX_CLK clock cycles */
+  tmpreg = (heth->Instance)->DMAOMR;
+  HAL_Delay(ETH_REG_WRITE_DELAY);
+  (heth->Instance)->DMAOMR = tmpreg;
+
+  /* Process Unlocked */
+  __HAL_UNLOCK(heth);
+
+  /* Return function status */
+  return HAL_OK;
+}
+
 /**
   * @}
   */
@@ -1561,6 +2189,8 @@ HAL_StatusTypeDef HAL_ETH_ConfigDMA(ETH_HandleTypeDef *heth, ETH_DMAInitTypeDef
   and the data flow.
        (+) Get the ETH handle state:
            HAL_ETH_GetState();
+       (+) Get the interrupt, poll and drop counters:
+           HAL_ETH_GetStats();
            
 
   @endverbatim
@@ -1579,6 +2209,34 @@ HAL_ETH_StateTypeDef HAL_ETH_GetState(ETH_HandleTypeDef *heth)
   return heth->State;
 }
 
+/**
+  * @brief  Gets the interrupt, poll and drop counters. The interrupts/s are
+  *         the difference of two readings divided by the Tick difference,
+  *         the frames per poll are PollFrames / Polls.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  pStats: Pointer to the copy of the counters
+  * @retval None
+  */
+void HAL_ETH_GetStats(ETH_HandleTypeDef *heth, ETH_StatsTypeDef *pStats)
+{
+  uint32_t missed = 0U;
+  uint32_t primask = 0U;
+
+  /* The missed frame counters are cleared when read */
+  missed = (heth->Instance)->DMAMFBOCR;
+
+  /* A consistent copy, the interrupt updates the counters */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  heth->Stats.RxMissed += (missed & ETH_DMAMFBOCR_MFC) + ((missed & ETH_DMAMFBOCR_MFA) >> 17U);
+  heth->Stats.Tick = HAL_GetTick();
+  *pStats = heth->Stats;
+
+  __set_PRIMASK(primask);
+}
+
 /**
   * @}
   */
@@ -2027,6 +2685,278 @@ static void ETH_FlushTransmitFIFO(ETH_HandleTypeDef *heth)
   (heth->Instance)->DMAOMR = tmpreg;
 }
 
+/**
+  * @brief  Gives the Rx descriptors waiting for a buffer a new one from
+  *         HAL_ETH_RxAllocateCallback(), in the ring order, and gives
+  *         them back to the DMA.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @retval None
+  */
+static void ETH_RxRefill(ETH_HandleTypeDef *heth)
+{
+  uint8_t *buff = NULL;
+
+  while(heth->RxBuildCount != 0U)
+  {
+    buff = NULL;
+    HAL_ETH_RxAllocateCallback(heth, &buff);
+    if(buff == NULL)
+    {
+      /* No buffer now, retried by the next received frame */
+      break;
+    }
+
+    /* No dirty line may be written over the received data; the buffer
+       has whole lines, no neighbour data is lost */
+    assert_param(((uint32_t)buff & 31U) == 0U);
+    ETH_InvalidateDCache(buff, ETH_RX_ZC_BUF_SIZE);
+
+    (heth->RxBuildDesc)->Buffer1Addr = (uint32_t)buff;
+
+    /* The descriptor is complete before the DMA owns it */
+    __DMB();
+    (heth->RxBuildDesc)->Status = ETH_DMARXDESC_OWN;
+
+    heth->RxBuildDesc = (ETH_DMADescTypeDef *)((heth->RxBuildDesc)->Buffer2NextDescAddr);
+    heth->RxBuildCount--;
+  }
+
+  /* When Rx Buffer unavailable flag is set: clear it and resume reception */
+  if (((heth->Instance)->DMASR & ETH_DMASR_RBUS) != (uint32_t)RESET)
+  {
+    /* Clear RBUS ETHERNET DMA flag */
+    (heth->Instance)->DMASR = ETH_DMASR_RBUS;
+    /* Resume DMA reception */
+    (heth->Instance)->DMARPDR = 0U;
+  }
+}
+
+/**
+  * @brief  Cleans the D-cache lines of a buffer read by the DMA.
+  * @note   The Ethernet DMA is not a DMA stream, the maintenance is done
+  *         here, under the same DMA_DCACHE_MAINTENANCE_ENABLE switch.
+  * @param  pData: Buffer address
+  * @param  Size: Buffer size, in bytes
+  * @retval None
+  */
+static void ETH_CleanDCache(const uint8_t *pData, uint32_t Size)
+{
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+  if((Size != 0U) && ((SCB->CCR & SCB_CCR_DC_Msk) != 0U))
+  {
+    uint32_t start = (uint32_t)pData & ~31U;
+    SCB_CleanDCache_by_Addr((uint32_t *)start, (int32_t)((uint32_t)pData + Size - start));
+  }
+#else
+  UNUSED(pData);
+  UNUSED(Size);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+}
+
+/**
+  * @brief  Invalidates the D-cache lines of a buffer written by the DMA; the
+  *         buffer must be aligned on and sized in multiples of the 32 bytes
+  *         line, the neighbouring data is not written back.
+  * @param  pData: Buffer address
+  * @param  Size: Buffer size, in bytes
+  * @retval None
+  */
+static void ETH_InvalidateDCache(uint8_t *pData, uint32_t Size)
+{
+#if (DMA_DCACHE_MAINTENANCE_ENABLE == 1U)
+  if((Size != 0U) && ((SCB->CCR & SCB_CCR_DC_Msk) != 0U))
+  {
+    uint32_t start = (uint32_t)pData & ~31U;
+    SCB_InvalidateDCache_by_Addr((uint32_t *)start, (int32_t)((uint32_t)pData + Size - start));
+  }
+#else
+  UNUSED(pData);
+  UNUSED(Size);
+#endif /* DMA_DCACHE_MAINTENANCE_ENABLE */
+}
+
+#if defined(OS_USE_BENCH)
+
+#include "diag/Bench.h"
+
+/* Frames sent per run, at most ETH_BENCH_INFLIGHT on the loop at a time */
+#define ETH_BENCH_FRAMES    16U
+#define ETH_BENCH_INFLIGHT  2U
+/* Polls without a frame before giving up, if the loop is broken */
+#define ETH_BENCH_POLLS     1000000U
+
+typedef struct
+{
+  ETH_HandleTypeDef *heth;
+  uint32_t Length;             /* Frame length, without the CRC */
+  uint32_t Runs;
+} ETH_BenchTypeDef;
+
+static ETH_BenchTypeDef ETH_BenchParam[] =
+{
+  { NULL, 60U, 0U },
+  { NULL, 508U, 0U },
+  { NULL, 1514U, 0U }
+};
+
+/**
+  * @brief  Sets or clears the MAC loopback mode; the write delay is a few us,
+  *         not the millisecond of the other MAC configuration writes.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @param  Loopback: ETH_MACCR_LM or 0
+  * @retval None
+  */
+static void ETH_BenchSetLoopback(ETH_HandleTypeDef *heth, uint32_t Loopback)
+{
+  __IO uint32_t tmpreg1 = 0U;
+  __IO uint32_t delay = SystemCoreClock / 1000000U;
+
+  MODIFY_REG((heth->Instance)->MACCR, ETH_MACCR_LM, Loopback);
+
+  /* Wait until the write operation will be taken into account:
+     at least four TX_CLK/RX_CLK clock cycles */
+  tmpreg1 = (heth->Instance)->MACCR;
+  while(delay-- != 0U)
+  {
+  }
+  (heth->Instance)->MACCR = tmpreg1;
+}
+
+/**
+  * @brief  Sends ETH_BENCH_FRAMES frames through the MAC loopback, each received
+  *         buffer being sent again; frames/s is ETH_BENCH_FRAMES * SystemCoreClock
+  *         divided by the cycles. The share of the time spent on the frames,
+  *         not on polls finding none, is reported once, as cpu%.
+  * @param  arg: Pointer to the ETH_BenchTypeDef of the frame size
+  * @retval None
+  */
+static void ETH_BenchLoopback(void *arg)
+{
+  ETH_BenchTypeDef *bench = (ETH_BenchTypeDef *)arg;
+  ETH_HandleTypeDef *heth = bench->heth;
+  ETH_BufferTypeDef frame;
+  uint8_t *buff = NULL;
+  uint32_t length = 0U, sent = 0U, received = 0U, index = 0U;
+  uint32_t polls = ETH_BENCH_POLLS;
+  uint32_t begin = 0U, start = 0U, busy = 0U, total = 0U;
+  uint32_t primask = 0U;
+
+  /* The warm up runs have the interrupts enabled, the ETH interrupt must
+     not take the frames */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  begin = DWT->CYCCNT;
+  ETH_BenchSetLoopback(heth, ETH_MACCR_LM);
+
+  frame.len = bench->Length;
+  frame.next = NULL;
+
+  /* Broadcast frames of the local experimental type, from the pool */
+  for(sent = 0U; sent < ETH_BENCH_INFLIGHT; sent++)
+  {
+    buff = NULL;
+    HAL_ETH_RxAllocateCallback(heth, &buff);
+    if(buff == NULL)
+    {
+      break;
+    }
+    for(index = 0U; index < 6U; index++)
+    {
+      buff[index] = 0xFFU;
+      buff[6U + index] = (heth->Init).MACAddr[index];
+    }
+    buff[12] = 0x88U;
+    buff[13] = 0xB5U;
+
+    frame.buffer = buff;
+    if(HAL_ETH_TransmitFrame_ZeroCopy(heth, &frame, buff) != HAL_OK)
+    {
+      HAL_ETH_TxFreeCallback(heth, buff);
+      break;
+    }
+  }
+
+  while((received < sent) && (polls != 0U))
+  {
+    start = DWT->CYCCNT;
+    HAL_ETH_ReleaseTxFrames(heth);
+    if(HAL_ETH_GetReceivedFrame_ZeroCopy(heth, &buff, &length) != HAL_OK)
+    {
+      polls--;
+      continue;
+    }
+
+    if(length == bench->Length)
+    {
+      received++;
+
+      /* Send the received buffer again, no copy */
+      frame.buffer = buff;
+      if((sent < ETH_BENCH_FRAMES) && (HAL_ETH_TransmitFrame_ZeroCopy(heth, &frame, buff) == HAL_OK))
+      {
+        sent++;
+        buff = NULL;
+      }
+    }
+    if(buff != NULL)
+    {
+      /* The last frames, or one from the line before the loopback */
+      HAL_ETH_TxFreeCallback(heth, buff);
+    }
+    busy += DWT->CYCCNT - start;
+  }
+
+  HAL_ETH_ReleaseTxFrames(heth);
+  ETH_BenchSetLoopback(heth, 0U);
+  total = DWT->CYCCNT - begin;
+
+  __set_PRIMASK(primask);
+
+  /* Once, at the last warm up run, which is not measured */
+  bench->Runs++;
+  if((bench->Runs == OS_INTEGER_BENCH_WARMUP) && (total >= 100U))
+  {
+    bench_report("cpu%", busy / (total / 100U));
+  }
+}
+
+static bench_t ETH_Bench[] =
+{
+  { "eth_zc_loopback_64", ETH_BenchLoopback, &ETH_BenchParam[0], NULL },
+  { "eth_zc_loopback_512", ETH_BenchLoopback, &ETH_BenchParam[1], NULL },
+  { "eth_zc_loopback_1518", ETH_BenchLoopback, &ETH_BenchParam[2], NULL }
+};
+
+/**
+  * @brief  Registers the MAC loopback benchmarks of the first handle in zero
+  *         copy mode, started. The pool must hold a few buffers more than
+  *         the Rx descriptors, and HAL_ETH_TxFreeCallback() must free the
+  *         buffers of HAL_ETH_RxAllocateCallback() given as context.
+  * @param  heth: pointer to a ETH_HandleTypeDef structure that contains
+  *         the configuration information for ETHERNET module
+  * @retval None
+  */
+static void ETH_RegisterBench(ETH_HandleTypeDef *heth)
+{
+  uint32_t index = 0U;
+
+  if(ETH_BenchParam[0].heth != NULL)
+  {
+    return;
+  }
+
+  for(index = 0U; index < (sizeof(ETH_Bench) / sizeof(ETH_Bench[0])); index++)
+  {
+    ETH_BenchParam[index].heth = heth;
+    bench_register(&ETH_Bench[index]);
+  }
+}
+
+#endif /* OS_USE_BENCH */
+
 /**
   * @}
   */
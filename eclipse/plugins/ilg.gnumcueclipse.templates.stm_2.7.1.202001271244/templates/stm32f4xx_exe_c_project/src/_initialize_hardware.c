@@ -31,6 +31,10 @@
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_cortex.h"
 
+#if defined(OS_USE_FAST_VECTORS)
+#include "cortexm/FastCode.h"
+#endif
+
 // ----------------------------------------------------------------------------
 
 // The external clock frequency is specified as a preprocessor definition
@@ -87,6 +91,11 @@ __initialize_hardware(void)
   // Call the CSMSIS system clock routine to store the clock frequency
   // in the SystemCoreClock global RAM location.
   SystemCoreClockUpdate();
+
+#if defined(OS_USE_FAST_VECTORS)
+  // Copy the vector table to zero wait state RAM.
+  fast_vectors_relocate();
+#endif
 }
 
 // Disable when using RTOSes, since they have their own handler.
@@ -30,6 +30,11 @@
 #include "stm32f7xx.h"
 #include "stm32f7xx_hal.h"
 #include "stm32f7xx_hal_cortex.h"
+#include "cortexm/DmaBuffer.h"
+
+#if defined(OS_USE_FAST_VECTORS)
+#include "cortexm/FastCode.h"
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -94,6 +99,10 @@ __initialize_hardware_early (void)
 void
 __initialize_hardware (void)
 {
+  // Make the DMA buffers region non cacheable, before the data cache
+  // is enabled (see cortexm/DmaBuffer.h).
+  dma_buffer_init ();
+
   // Enable instruction & data cache.
   SCB_EnableICache ();
   SCB_EnableDCache ();
@@ -109,6 +118,11 @@ __initialize_hardware (void)
   // Call the CSMSIS system clock routine to store the clock frequency
   // in the SystemCoreClock global RAM location.
   SystemCoreClockUpdate ();
+
+#if defined(OS_USE_FAST_VECTORS)
+  // Copy the vector table to zero wait state RAM.
+  fast_vectors_relocate ();
+#endif
 }
 
 // Disable when using RTOSes, since they have their own handler.
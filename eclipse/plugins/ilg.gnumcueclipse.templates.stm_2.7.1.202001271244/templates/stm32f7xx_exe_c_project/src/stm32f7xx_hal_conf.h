@@ -154,6 +154,7 @@
 #define  USE_RTOS                     0
 #define  PREFETCH_ENABLE              1
 #define  ART_ACCLERATOR_ENABLE        1 /* To enable instruction cache and prefetch */
+#define  DMA_DCACHE_MAINTENANCE_ENABLE 0 /* Set to 1 to clean/invalidate the D-cache in the DMA start/complete paths */
 
 /* ########################## Assert Selection ############################## */
 /**